@@ -0,0 +1,103 @@
+﻿#include "stdafx.h"
+#include "bench.h"
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+#define asd_Bench_MinTimeMs		200		// 측정 1회의 최소 실행시간
+#define asd_Bench_MaxOps		(1 << 30)
+
+namespace asdbench
+{
+	std::atomic<uint64_t> g_allocCount(0);
+	volatile uint64_t g_sink = 0;
+
+	struct Entry
+	{
+		const char* m_name;
+		BenchFunc m_func;
+	};
+
+	// 정적 초기화 순서 문제를 피하기 위해 함수 내 static 사용
+	static std::vector<Entry>& GetEntries()
+	{
+		static std::vector<Entry> s_entries;
+		return s_entries;
+	}
+
+
+	Registrar::Registrar(const char* a_name,
+						 BenchFunc&& a_func)
+	{
+		GetEntries().push_back(Entry{a_name, std::move(a_func)});
+	}
+
+
+	struct Measure
+	{
+		size_t m_ops;
+		double m_ns;
+		uint64_t m_bytes;
+		uint64_t m_allocs;
+	};
+
+
+	static Measure Run(const BenchFunc& a_func,
+					   const size_t a_ops)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		Measure ret;
+		ret.m_ops = a_ops;
+		const uint64_t allocs = g_allocCount.load(std::memory_order_relaxed);
+		const auto start = Clock::now();
+		ret.m_bytes = a_func(a_ops);
+		const auto end = Clock::now();
+		ret.m_allocs = g_allocCount.load(std::memory_order_relaxed) - allocs;
+		ret.m_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		return ret;
+	}
+
+
+	size_t RunAll(const char* a_filter)
+	{
+		std::printf("%-40s %12s %12s %14s %12s\n",
+					"Benchmark", "ops", "ns/op", "MB/s", "allocs/op");
+		std::printf("%s\n", std::string(94, '-').c_str());
+
+		size_t count = 0;
+		for (auto& entry : GetEntries()) {
+			if (a_filter!=nullptr && std::strstr(entry.m_name, a_filter)==nullptr)
+				continue;
+			++count;
+
+			// 워밍업 (풀 채우기 등) 후 최소 실행시간을 넘을 때까지 연산 횟수를 늘려가며 측정
+			Run(entry.m_func, 1);
+			Measure m = Run(entry.m_func, 1);
+			const double minNs = asd_Bench_MinTimeMs * 1e6;
+			while (m.m_ns < minNs && m.m_ops < asd_Bench_MaxOps) {
+				size_t next;
+				if (m.m_ns <= 0)
+					next = m.m_ops * 100;
+				else
+					next = (size_t)(m.m_ops * (minNs * 1.2 / m.m_ns));
+				next = std::min(std::max(next, m.m_ops * 2), m.m_ops * 100);
+				m = Run(entry.m_func, std::min<size_t>(next, asd_Bench_MaxOps));
+			}
+
+			const double nsPerOp = m.m_ns / m.m_ops;
+			const double allocsPerOp = (double)m.m_allocs / m.m_ops;
+			if (m.m_bytes > 0) {
+				const double mbPerSec = (m.m_bytes / (1024.0 * 1024.0)) / (m.m_ns / 1e9);
+				std::printf("%-40s %12zu %12.1f %14.1f %12.3f\n",
+							entry.m_name, m.m_ops, nsPerOp, mbPerSec, allocsPerOp);
+			}
+			else {
+				std::printf("%-40s %12zu %12.1f %14s %12.3f\n",
+							entry.m_name, m.m_ops, nsPerOp, "-", allocsPerOp);
+			}
+			std::fflush(stdout);
+		}
+		return count;
+	}
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+#include "asd/asdbase.h"
+#include "asd/buffer.h"
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace asdbench
+{
+	// 벤치마크 함수
+	// a_ops 번의 연산을 수행하고 처리한 총 바이트 수를 리턴한다. (바이트 단위가 의미 없으면 0)
+	typedef std::function<uint64_t(size_t a_ops)> BenchFunc;
+
+	struct Registrar
+	{
+		Registrar(const char* a_name,
+				  BenchFunc&& a_func);
+	};
+
+	// a_filter가 이름에 포함된 벤치마크만 실행한다. (nullptr이면 전체)
+	// 리턴값은 실행한 벤치마크 개수
+	size_t RunAll(const char* a_filter);
+
+	// operator new 호출 횟수 (main.cpp에서 전역 operator new를 재정의하여 센다)
+	extern std::atomic<uint64_t> g_allocCount;
+
+	// 컴파일러가 결과를 사용하지 않는 연산을 제거하지 못하도록 한다.
+	extern volatile uint64_t g_sink;
+	template <typename T>
+	inline void DoNotOptimize(const T& a_value)
+	{
+#if asd_Compiler_GCC
+		asm volatile("" : : "r,m"(a_value) : "memory");
+#else
+		g_sink += *reinterpret_cast<const volatile uint8_t*>(&a_value);
+#endif
+	}
+
+	// 쓰고 모두 읽은 버퍼가 끝없이 쌓이지 않도록 일정 크기마다 비운다.
+	#define asd_Bench_RecycleBytes	(256 * 1024)
+	inline void Recycle(asd::BufferList& a_list)
+	{
+		if (a_list.GetTotalSize() >= asd_Bench_RecycleBytes && !a_list.Readable(1))
+			a_list.Clear();
+	}
+}
+
+
+// 사용법
+//   asdbench_Define(BufferList_Write_64B)
+//   {
+//       for (size_t i=0; i<a_ops; ++i) { ... }
+//       return 처리한_바이트_수;
+//   }
+#define asdbench_Define(Name)																\
+	static uint64_t asdbench_ ## Name(size_t a_ops);										\
+	static asdbench::Registrar asdbench_Registrar_ ## Name(#Name, asdbench_ ## Name);		\
+	static uint64_t asdbench_ ## Name(size_t a_ops)
@@ -0,0 +1,173 @@
+﻿#include "stdafx.h"
+#include "bench.h"
+#include "asd/buffer.h"
+#include <vector>
+
+
+namespace asdbench
+{
+	template <size_t Bytes>
+	static uint64_t BufferList_WriteRead(size_t a_ops)
+	{
+		uint8_t src[Bytes] = {0};
+		uint8_t dst[Bytes];
+		asd::BufferList list;
+		for (size_t i=0; i<a_ops; ++i) {
+			src[0] = (uint8_t)i;
+			list.Write(src, Bytes);
+			list.Read(dst, Bytes);
+			DoNotOptimize(dst);
+			Recycle(list);
+		}
+		return (uint64_t)a_ops * Bytes;
+	}
+
+
+	template <size_t Bytes>
+	static uint64_t BufferList_Write(size_t a_ops)
+	{
+		uint8_t src[Bytes] = {0};
+		asd::BufferList list;
+		for (size_t i=0; i<a_ops; ++i) {
+			src[0] = (uint8_t)i;
+			list.Write(src, Bytes);
+			if (list.GetTotalSize() >= asd_Bench_RecycleBytes)
+				list.Clear();
+		}
+		return (uint64_t)a_ops * Bytes;
+	}
+}
+
+
+
+asdbench_Define(BufferList_WriteRead_16B)
+{
+	return asdbench::BufferList_WriteRead<16>(a_ops);
+}
+
+asdbench_Define(BufferList_WriteRead_256B)
+{
+	return asdbench::BufferList_WriteRead<256>(a_ops);
+}
+
+asdbench_Define(BufferList_WriteRead_4KB)
+{
+	return asdbench::BufferList_WriteRead<4 * 1024>(a_ops);
+}
+
+asdbench_Define(BufferList_Write_64B)
+{
+	return asdbench::BufferList_Write<64>(a_ops);
+}
+
+asdbench_Define(BufferList_Write_32KB)
+{
+	return asdbench::BufferList_Write<32 * 1024>(a_ops);
+}
+
+
+// 메시지마다 BufferList를 새로 만들어 작은 메시지 하나를 쓰는 경우
+asdbench_Define(BufferList_New_Message_64B)
+{
+	uint8_t src[64] = {0};
+	for (size_t i=0; i<a_ops; ++i) {
+		auto list = asd::BufferList::New();
+		list->ReserveBuffer(sizeof(src));
+		list->Write(src, sizeof(src));
+		asdbench::DoNotOptimize(list);
+	}
+	return (uint64_t)a_ops * sizeof(src);
+}
+
+
+// 여러 버퍼에 걸친 데이터를 복사 없이 구간 목록으로 얻기
+asdbench_Define(BufferList_PeekSpans_64KB)
+{
+	uint8_t src[1024] = {0};
+	asd::BufferList list;
+	for (int i=0; i<64; ++i)
+		list.Write(src, sizeof(src));
+
+	std::vector<asd::Span> spans;
+	uint64_t bytes = 0;
+	for (size_t i=0; i<a_ops; ++i) {
+		spans.clear();
+		bytes += list.PeekSpans(spans);
+		asdbench::DoNotOptimize(spans);
+	}
+	return bytes;
+}
+
+
+// 풀에서 고정 크기 버퍼를 할당/반납
+asdbench_Define(NewBuffer_Static_2KB)
+{
+	for (size_t i=0; i<a_ops; ++i) {
+		auto buf = asd::NewBuffer<2 * 1024>();
+		asdbench::DoNotOptimize(buf);
+	}
+	return 0;
+}
+
+
+// 런타임 크기 요청 (size class 풀)
+asdbench_Define(NewBuffer_SizeClass_Mixed)
+{
+	const size_t sizes[] = {64, 100, 300, 1000, 1500, 4000, 9000, 20000};
+	const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+	for (size_t i=0; i<a_ops; ++i) {
+		auto buf = asd::NewBuffer(sizes[i % count]);
+		asdbench::DoNotOptimize(buf);
+	}
+	return 0;
+}
+
+
+// 한번에 여러 버퍼를 잡고 있다가 반납 (풀 churn)
+asdbench_Define(NewBuffer_Churn_64x1KB)
+{
+	const size_t Batch = 64;
+	std::vector<asd::Buffer_ptr> bufs;
+	bufs.reserve(Batch);
+	for (size_t i=0; i<a_ops; ++i) {
+		bufs.emplace_back(asd::NewBuffer(1024));
+		if (bufs.size() == Batch)
+			bufs.clear();
+	}
+	return 0;
+}
+
+
+// 쓰기 도중 실패하여 롤백하는 경우
+asdbench_Define(Transactional_Write_Rollback)
+{
+	uint8_t src[64] = {0};
+	asd::BufferList list;
+	for (size_t i=0; i<a_ops; ++i) {
+		{
+			asd::Transactional<asd::BufOp::Write> tran(list);
+			list.Write(src, sizeof(src));
+			list.Write(src, sizeof(src));
+		}
+		asdbench::DoNotOptimize(list);
+	}
+	return 0;
+}
+
+
+// 데이터가 부족하여 읽기를 롤백하는 경우 (덜 수신된 메시지)
+asdbench_Define(Transactional_Read_Rollback)
+{
+	uint8_t src[64] = {0};
+	uint8_t dst[128];
+	asd::BufferList list;
+	list.Write(src, sizeof(src));
+	for (size_t i=0; i<a_ops; ++i) {
+		asd::Transactional<asd::BufOp::Read> tran(list);
+		list.Read(dst, sizeof(src));
+		if (list.Readable(sizeof(src)))
+			tran.SetResult(list.Read(dst + sizeof(src), sizeof(src)));
+		asdbench::DoNotOptimize(dst);
+	}
+	return 0;
+}
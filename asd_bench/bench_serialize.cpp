@@ -0,0 +1,135 @@
+﻿#include "stdafx.h"
+#include "bench.h"
+#include "asd/serialize.h"
+#include <vector>
+#include <map>
+#include <string>
+
+
+namespace asdbench
+{
+	// a_data를 쓰고 다시 읽는 왕복 1회를 연산 1회로 측정
+	template <typename T>
+	static uint64_t RoundTrip(const T& a_data,
+							  size_t a_ops)
+	{
+		asd::BufferList list;
+		T out = T();
+		uint64_t bytes = 0;
+		for (size_t i=0; i<a_ops; ++i) {
+			bytes += asd::Write(list, a_data);
+			asd::Read(list, out);
+			DoNotOptimize(out);
+			Recycle(list);
+		}
+		return bytes;
+	}
+
+
+	struct FixedMessage
+	{
+		int32_t m_id;
+		uint16_t m_type;
+		double m_x, m_y, m_z;
+		uint64_t m_time;
+		asd_Serialize_Fields(m_id, m_type, m_x, m_y, m_z, m_time)
+	};
+
+	struct MixedMessage
+	{
+		int32_t m_id;
+		std::string m_name;
+		std::vector<int32_t> m_values;
+		uint64_t m_time;
+		asd_Serialize_Fields(m_id, m_name, m_values, m_time)
+	};
+}
+
+
+
+asdbench_Define(Serialize_Primitive_int32)
+{
+	return asdbench::RoundTrip((int32_t)0x12345678, a_ops);
+}
+
+asdbench_Define(Serialize_Primitive_double)
+{
+	return asdbench::RoundTrip(3.141592, a_ops);
+}
+
+asdbench_Define(Serialize_Compact_uint32)
+{
+	asd::BufferList list;
+	uint32_t out = 0;
+	uint64_t bytes = 0;
+	for (size_t i=0; i<a_ops; ++i) {
+		bytes += asd::Write(list, asd::Compact((uint32_t)(i & 0xFFFFF)));
+		asd::Read(list, asd::Compact(out));
+		asdbench::DoNotOptimize(out);
+		asdbench::Recycle(list);
+	}
+	return bytes;
+}
+
+asdbench_Define(Serialize_String_32)
+{
+	return asdbench::RoundTrip(std::string(32, 'a'), a_ops);
+}
+
+asdbench_Define(Serialize_Vector_int32_256)
+{
+	return asdbench::RoundTrip(std::vector<int32_t>(256, 7), a_ops);
+}
+
+asdbench_Define(Serialize_Vector_String_16)
+{
+	return asdbench::RoundTrip(std::vector<std::string>(16, "0123456789"), a_ops);
+}
+
+asdbench_Define(Serialize_Map_int32_String_16)
+{
+	std::map<int32_t, std::string> data;
+	for (int32_t i=0; i<16; ++i)
+		data[i] = "value";
+	return asdbench::RoundTrip(data, a_ops);
+}
+
+asdbench_Define(Serialize_Fields_Fixed)
+{
+	asdbench::FixedMessage data = {1, 2, 1.0, 2.0, 3.0, 12345};
+	return asdbench::RoundTrip(data, a_ops);
+}
+
+asdbench_Define(Serialize_Fields_Mixed)
+{
+	asdbench::MixedMessage data = {1, "name", std::vector<int32_t>(8, 1), 12345};
+	return asdbench::RoundTrip(data, a_ops);
+}
+
+
+// 정확한 크기의 버퍼 하나로 직렬화 (송신용 메시지 생성)
+asdbench_Define(Serialize_SingleBuffer_Mixed)
+{
+	asdbench::MixedMessage data = {1, "name", std::vector<int32_t>(8, 1), 12345};
+	uint64_t bytes = 0;
+	for (size_t i=0; i<a_ops; ++i) {
+		auto buf = asd::Serialize(data);
+		bytes += buf->GetSize();
+		asdbench::DoNotOptimize(buf);
+	}
+	return bytes;
+}
+
+
+// 벡터 읽기 도중 데이터가 부족하여 롤백하는 경우
+asdbench_Define(Serialize_Vector_Read_Rollback)
+{
+	asd::BufferList list;
+	asd::Write(list, (uint32_t)1000);
+	std::vector<int32_t> out;
+	for (size_t i=0; i<a_ops; ++i) {
+		asd::Read(list, out);
+		asdbench::DoNotOptimize(out);
+	}
+	return 0;
+}
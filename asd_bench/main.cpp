@@ -0,0 +1,80 @@
+﻿#include "stdafx.h"
+#include "bench.h"
+#include <cstdlib>
+#include <new>
+/*
+사용법
+	asd_bench [필터]
+
+	필터가 이름에 포함된 벤치마크만 실행한다.
+	예) asd_bench Serialize_
+	    asd_bench BufferList
+
+출력
+	ops       : 측정에 사용한 연산 횟수
+	ns/op     : 연산 1회당 평균 소요시간
+	MB/s      : 초당 처리한 바이트 수
+	allocs/op : 연산 1회당 평균 operator new 호출 횟수 (풀에서 재사용된 버퍼는 세지 않음)
+
+성능 측정이므로 Release 빌드로 실행해야 의미가 있다.
+*/
+
+
+// 힙 할당 횟수를 세기 위해 전역 operator new를 재정의한다.
+// asd_core는 정적 라이브러리이므로 라이브러리 내부의 할당도 모두 여기로 온다.
+void* operator new(size_t a_bytes)
+{
+	asdbench::g_allocCount.fetch_add(1, std::memory_order_relaxed);
+	void* p = std::malloc(a_bytes > 0 ? a_bytes : 1);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t a_bytes)
+{
+	return operator new(a_bytes);
+}
+
+void* operator new(size_t a_bytes, const std::nothrow_t&) noexcept
+{
+	asdbench::g_allocCount.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(a_bytes > 0 ? a_bytes : 1);
+}
+
+void* operator new[](size_t a_bytes, const std::nothrow_t& a_nothrow) noexcept
+{
+	return operator new(a_bytes, a_nothrow);
+}
+
+void operator delete(void* a_ptr) noexcept
+{
+	std::free(a_ptr);
+}
+
+void operator delete[](void* a_ptr) noexcept
+{
+	std::free(a_ptr);
+}
+
+void operator delete(void* a_ptr, size_t) noexcept
+{
+	std::free(a_ptr);
+}
+
+void operator delete[](void* a_ptr, size_t) noexcept
+{
+	std::free(a_ptr);
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	size_t count = asdbench::RunAll(filter);
+	if (count == 0) {
+		std::printf("no benchmark matched '%s'\n", filter);
+		return 1;
+	}
+	return 0;
+}
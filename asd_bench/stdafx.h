@@ -0,0 +1,10 @@
+﻿#pragma once
+
+#if defined(_MSC_VER)
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include "asd/exception.h"
@@ -238,7 +238,7 @@ namespace asd
 
 			mutable std::shared_ptr<Mutex> m_lock;
 			Context* m_owner = nullptr;
-			std::unordered_set<Ctx> m_loops;
+			std::unordered_set<Ctx, std::hash<Ctx>, std::equal_to<Ctx>, PoolAllocator<Ctx>> m_loops;
 			bool m_fin = false;
 			size_t m_cur = 0;
 			std::deque<Task> m_tasks;
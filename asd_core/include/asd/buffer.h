@@ -3,9 +3,12 @@
 #include "classutil.h"
 #include "objpool.h"
 #include "util.h"
+#include "container.h"
 #include <array>
 #include <vector>
 #include <deque>
+#include <functional>
+#include <cstring>
 
 #define asd_Support_FlatBuffers 1
 #if asd_Support_FlatBuffers
@@ -49,6 +52,15 @@ namespace asd
 	template<>
 	struct IsDirectSerializableType<uint8_t> { static constexpr bool Value = true; };
 
+	template<>
+	struct IsDirectSerializableType<char> { static constexpr bool Value = true; };
+
+	template<>
+	struct IsDirectSerializableType<char16_t> { static constexpr bool Value = true; };
+
+	template<>
+	struct IsDirectSerializableType<char32_t> { static constexpr bool Value = true; };
+
 	template<>
 	struct IsDirectSerializableType<int16_t> { static constexpr bool Value = true; };
 
@@ -78,6 +90,8 @@ namespace asd
 
 
 
+	class FileBuffer;
+
 	class BufferInterface
 	{
 	public:
@@ -86,6 +100,12 @@ namespace asd
 		virtual size_t GetSize() const = 0;
 		virtual bool SetSize(size_t a_bytes) = 0;
 
+		// 파일 기반 버퍼이면 자신을 리턴 (송신 시 sendfile 사용 여부 판단용)
+		virtual const FileBuffer* GetFile() const
+		{
+			return nullptr;
+		}
+
 		inline size_t GetReserve() const
 		{
 			const auto capacity = Capacity();
@@ -144,6 +164,48 @@ namespace asd
 
 
 
+	// 풀링하지 않는 가변크기 버퍼
+	// size class 범위를 넘어서는 큰 버퍼 요청에 사용
+	struct HeapBuffer
+		: public BufferInterface
+	{
+		std::unique_ptr<uint8_t[]> m_data;
+		size_t m_capacity;
+		size_t m_size = 0;
+
+		inline HeapBuffer(size_t a_capacity)
+			: m_data(new uint8_t[a_capacity])
+			, m_capacity(a_capacity)
+		{
+		}
+
+		virtual uint8_t* GetBuffer() const override
+		{
+			return m_data.get();
+		}
+
+		virtual size_t Capacity() const override
+		{
+			return m_capacity;
+		}
+
+		virtual size_t GetSize() const override
+		{
+			asd_DAssert(m_size <= m_capacity);
+			return m_size;
+		}
+
+		virtual bool SetSize(size_t a_bytes) override
+		{
+			if (a_bytes > m_capacity)
+				return false;
+			m_size = a_bytes;
+			return true;
+		}
+	};
+
+
+
 	template <
 		typename T,
 		typename... Args
@@ -255,18 +317,104 @@ namespace asd
 
 
 
+	// 런타임에 크기가 결정되는 버퍼 요청을 위한 size class 목록
+	// 2의 거듭제곱 구간을 4등분한 크기들로 구성된다.
+	//   64, 80, 96, 112, 128, 160, 192, 224, 256, ... , 1MB
+	// 각 size class는 NewBuffer<BYTES>()의 풀을 그대로 사용한다.
+	struct BufferSizeClass
+	{
+		#define asd_BufferSizeClass_MinBits		6	// 64 B
+		#define asd_BufferSizeClass_MaxBits		20	// 1 MB
+
+		static constexpr size_t MinSize = (size_t)1 << asd_BufferSizeClass_MinBits;
+		static constexpr size_t MaxSize = (size_t)1 << asd_BufferSizeClass_MaxBits;
+		static constexpr size_t Count = (asd_BufferSizeClass_MaxBits - asd_BufferSizeClass_MinBits) * 4 + 1;
+
+		// a_index번째 size class의 크기
+		static constexpr size_t GetSize(size_t a_index)
+		{
+			return ((size_t)1 << (asd_BufferSizeClass_MinBits + a_index/4))
+				 + ((a_index % 4) << (asd_BufferSizeClass_MinBits + a_index/4 - 2));
+		}
+
+		// a_bytes 이상인 가장 작은 size class의 인덱스
+		// a_bytes가 MaxSize보다 크면 Count를 리턴
+		static inline size_t GetIndex(size_t a_bytes)
+		{
+			if (a_bytes <= MinSize)
+				return 0;
+			if (a_bytes > MaxSize)
+				return Count;
+
+			const size_t n = a_bytes - 1;
+			size_t bits = 0;
+			while ((n >> bits) > 1)
+				++bits;
+			const size_t quarter = (n >> (bits - 2)) & 3;
+			return (bits - asd_BufferSizeClass_MinBits) * 4 + quarter + 1;
+		}
+
+		// a_bytes를 size class 크기로 올림
+		static inline size_t RoundUp(size_t a_bytes)
+		{
+			const size_t index = GetIndex(a_bytes);
+			return index < Count ? GetSize(index) : a_bytes;
+		}
+	};
+
+
+	// a_bytes 이상의 용량을 가진 버퍼를 할당
+	// size class 범위 내의 요청은 해당 class의 풀에서 할당되고,
+	// 범위를 넘어서는 요청은 풀링하지 않는 HeapBuffer로 할당된다.
+	Buffer_ptr NewBuffer(size_t a_bytes);
+
+
+
+	// 연속된 메모리 구간 (소유권 없음)
+	struct Span
+	{
+		const uint8_t*	Data = nullptr;
+		size_t			Size = 0;
+
+		Span() {}
+
+		Span(const void* a_data,
+			 size_t a_size)
+			: Data((const uint8_t*)a_data)
+			, Size(a_size)
+		{
+		}
+
+		inline bool Empty() const
+		{
+			return Size == 0;
+		}
+	};
+
+
+
+	// 버퍼 큐 (BufferList, 송신큐)
+	// 메시지 하나에 버퍼가 몇 개 되지 않는 경우가 대부분이므로 그만큼은 힙 할당 없이 담는다.
+	#define asd_BufferQueue_InlineCount		4
+	typedef InlineDeque<Buffer_ptr, asd_BufferQueue_InlineCount> BufferQueue;
+
+
+
 	class BufferList;
 	typedef UniquePtr<BufferList> BufferList_ptr;
 
 	// gather-scatter를 고려한 버퍼 목록
 	class BufferList
-		: protected std::deque<Buffer_ptr>
+		: protected BufferQueue
 	{
 	public:
-		typedef std::deque<Buffer_ptr> BaseType;
+		typedef BufferQueue BaseType;
 		template<BufOp Operation> friend class Transactional;
 		friend class AsyncSocket;
+		friend class SharedBuffer;
+		friend class MessageView;
 		#define asd_BufferList_DefaultWriteBufferSize	( 16 * 1024 )
+		#define asd_BufferList_MinWriteBufferSize		(       256 )
 		#define asd_BufferList_DefaultReadBufferSize	(  2 * 1024 )
 
 
@@ -276,6 +424,7 @@ namespace asd
 		size_t m_total_capacity;	// 여분을 포함한 버퍼 용량 총합 (bytes)
 		size_t m_total_write;		// 여분을 제외하고 쓰여진 버퍼 크기 총합 (bytes)
 		size_t m_total_read;		// 현재까지 읽은 바이트 수 (bytes)
+		size_t m_viewCount = 0;		// 버퍼를 직접 가리키는 MessageView 개수
 
 
 	public:
@@ -294,6 +443,9 @@ namespace asd
 
 		size_t GetTotalSize() const;
 
+		// 여유공간이 a_bytes 이상이 되도록 버퍼를 추가한다.
+		// 추가되는 버퍼의 크기는 부족분과 현재 총 용량 중 큰 값을 size class로 올린 크기이며,
+		// 작은 메시지는 작은 버퍼를, 큰 메시지는 적은 수의 큰 버퍼를 사용하게 된다.
 		void ReserveBuffer(size_t a_bytes = asd_BufferList_DefaultWriteBufferSize);
 
 		void ReserveBuffer(Buffer_ptr&& a_buffer);
@@ -320,6 +472,28 @@ namespace asd
 		size_t Read(void* a_data /*Out*/,
 					const size_t a_bytes);
 
+		// 읽기 오프셋부터 최대 a_maxBytes 까지의 데이터를 복사 없이 구간 목록으로 얻는다. (iovec 형태)
+		// 읽기 오프셋은 변하지 않으며, 리턴값은 a_spans에 담긴 총 바이트 수
+		size_t PeekSpans(std::vector<Span>& a_spans /*Out*/,
+						 const size_t a_maxBytes = std::numeric_limits<size_t>::max()) const;
+
+		// 읽기 오프셋부터 시작하는 첫번째 연속 구간 (읽을 데이터가 없으면 빈 구간)
+		Span PeekContiguous() const;
+
+		// 복사 없이 읽기 오프셋만 a_bytes 만큼 전진 (Read와 같이 Transactional로 되돌릴 수 있음)
+		size_t Advance(const size_t a_bytes);
+
+		// 0이 아니면 버퍼를 직접 가리키는 뷰가 살아있으므로 Flush, Clear 해서는 안된다.
+		inline size_t GetViewCount() const
+		{
+			return m_viewCount;
+		}
+
+		// 호출자 소유의 메모리를 복사 없이 뒤에 연결한다.
+		// 연결된 버퍼가 해제될 때 a_releaser가 호출되며, 그 전까지 메모리는 유효해야 한다.
+		void AppendExternal(const Span& a_span,
+							std::function<void()>&& a_releaser = nullptr);
+
 		using BaseType::begin;
 		using BaseType::end;
 		using BaseType::rbegin;
@@ -329,6 +503,99 @@ namespace asd
 	};
 
 
+	// 여러 곳에서 동시에 참조하는 불변 버퍼
+	// 한번 직렬화한 데이터를 여러 소켓에 송신할 때 복사 없이 참조카운트 증가만으로 공유한다.
+	// 원본 버퍼는 마지막 참조가 해제될 때 원래의 deleter로 반납된다.
+	class SharedBuffer
+	{
+	public:
+		SharedBuffer();
+
+		// a_buffer의 소유권을 가져온다.
+		explicit SharedBuffer(Buffer_ptr&& a_buffer);
+
+		// 읽지 않은 데이터가 여러 버퍼에 나뉘어 있으면 하나의 버퍼로 합친다.
+		explicit SharedBuffer(BufferList&& a_bufferList);
+
+		const uint8_t* GetBuffer() const;
+
+		size_t GetSize() const;
+
+		long UseCount() const;
+
+		// [a_offset, a_offset + a_bytes) 구간을 가리키는 참조
+		SharedBuffer Slice(size_t a_offset,
+						   size_t a_bytes) const;
+
+		// 송신큐와 같이 Buffer_ptr을 받는 곳에 넘기기 위한 참조
+		// 반환된 버퍼는 SetSize가 불가능하다.
+		Buffer_ptr NewRef() const;
+
+		inline explicit operator bool() const
+		{
+			return m_buffer != nullptr;
+		}
+
+	private:
+		std::shared_ptr<BufferInterface> m_buffer;
+		size_t m_offset = 0;
+		size_t m_size = 0;
+	};
+
+
+
+	// 스트림 수신용 링버퍼
+	// 읽을 수 있는 데이터가 항상 하나의 연속된 구간에 위치하므로
+	// 디코더가 Peek()으로 얻은 메모리를 복사 없이 바로 파싱하고 Consume()할 수 있다.
+	// 끝에 공간이 부족하면 wrap-around 대신 읽지 않은 데이터를 앞으로 당기고(compaction),
+	// 그래도 부족하면 더 큰 size class의 버퍼로 옮긴다.
+	class RingBuffer
+	{
+	public:
+		#define asd_RingBuffer_DefaultLimit		( 1024 * 1024 )
+
+		RingBuffer(size_t a_limit = asd_RingBuffer_DefaultLimit);
+
+		// 읽을 수 있는 구간
+		Span Peek() const;
+
+		size_t GetSize() const;
+
+		size_t Capacity() const;
+
+		inline size_t GetLimit() const
+		{
+			return m_limit;
+		}
+
+		// 앞에서부터 a_bytes 만큼 읽은 것으로 처리
+		void Consume(size_t a_bytes);
+
+		// 쓰기 공간이 a_bytes 이상이 되도록 확보한다. (단, 총 크기는 limit을 넘지 않는다)
+		// 읽지 않은 데이터가 이미 limit에 도달하여 공간을 확보할 수 없으면 false
+		bool Reserve(size_t a_bytes);
+
+		uint8_t* GetWritePtr();
+
+		size_t GetWritable() const;
+
+		// GetWritePtr()에 a_bytes 만큼 기록했음을 알림
+		void Commit(size_t a_bytes);
+
+		// 비어있는 상태에서 a_keep 보다 큰 버퍼를 잡고 있으면 반납한다.
+		void Shrink(size_t a_keep = 0);
+
+		void Clear();
+
+	private:
+		Buffer_ptr m_buffer;
+		size_t m_read = 0;
+		size_t m_write = 0;
+		const size_t m_limit;
+	};
+
+
+
 	template <BufOp Operation>
 	class Transactional final
 	{
@@ -359,5 +626,136 @@ namespace asd
 	};
 
 
+#if asd_Support_FlatBuffers
+	// 수신한 FlatBuffers 메시지 (FlatBuffersData의 수신측)
+	// 메시지를 정렬된 연속 메모리에 두고 그 자리에서 Verifier로 검증한 후 루트 포인터를 제공한다.
+	#define asd_FlatBuffers_Alignment	8	// sizeof(flatbuffers::largest_scalar_t)
+
+	template <typename RootType>
+	class FlatBuffersMessage
+	{
+	public:
+		// a_frame이 정렬되어 있으면 복사 없이 그 자리에서 검증하므로
+		// a_frame의 원본이 유효한 동안만 사용할 수 있다. (예: IOEvent::OnMessage 콜백 안)
+		// 정렬되어 있지 않으면 풀에서 할당한 버퍼로 복사한다.
+		bool Assign(const Span& a_frame,
+					const char* a_identifier = nullptr)
+		{
+			Reset();
+			if (a_frame.Empty())
+				return false;
+
+			if (IsAligned(a_frame.Data))
+				return Verify(a_frame, a_identifier);
+
+			uint8_t* dst = Alloc(a_frame.Size);
+			std::memcpy(dst, a_frame.Data, a_frame.Size);
+			return Verify(Span(dst, a_frame.Size), a_identifier);
+		}
+
+		// 수신 버퍼 하나가 메시지 전체인 경우 (RecvMode::Chunk) 버퍼의 소유권을 가져온다.
+		bool Assign(Buffer_ptr&& a_buffer,
+					const char* a_identifier = nullptr)
+		{
+			Reset();
+			if (a_buffer == nullptr)
+				return false;
+
+			const Span data(a_buffer->GetBuffer(), a_buffer->GetSize());
+			if (data.Empty())
+				return false;
+
+			if (IsAligned(data.Data) == false)
+				return Assign(data, a_identifier);
+
+			m_buffer = std::move(a_buffer);
+			return Verify(data, a_identifier);
+		}
+
+		// a_bufferList의 읽기 오프셋부터 a_bytes를 하나의 정렬된 버퍼로 모아서 검증한다.
+		// 실패하면 읽기 오프셋은 변하지 않는다.
+		bool Read(BufferList& a_bufferList,
+				  size_t a_bytes,
+				  const char* a_identifier = nullptr)
+		{
+			Reset();
+			if (a_bytes == 0 || a_bufferList.Readable(a_bytes) == false)
+				return false;
+
+			Transactional<BufOp::Read> tran(a_bufferList);
+			uint8_t* dst = Alloc(a_bytes);
+			if (a_bufferList.Read(dst, a_bytes) != a_bytes)
+				return false;
+
+			if (Verify(Span(dst, a_bytes), a_identifier) == false)
+				return false;
+
+			tran.SetResult(a_bytes);
+			return true;
+		}
+
+		void Reset()
+		{
+			m_buffer.reset();
+			m_data = Span();
+			m_root = nullptr;
+		}
+
+		// 검증된 메시지 전체
+		inline const Span& GetData() const
+		{
+			return m_data;
+		}
+
+		inline const RootType* GetRoot() const
+		{
+			return m_root;
+		}
+
+		inline const RootType* operator -> () const
+		{
+			asd_DAssert(m_root != nullptr);
+			return m_root;
+		}
+
+		inline explicit operator bool() const
+		{
+			return m_root != nullptr;
+		}
+
+	private:
+		static inline bool IsAligned(const uint8_t* a_ptr)
+		{
+			return ((uintptr_t)a_ptr & (asd_FlatBuffers_Alignment - 1)) == 0;
+		}
+
+		uint8_t* Alloc(size_t a_bytes)
+		{
+			m_buffer = NewBuffer(a_bytes + asd_FlatBuffers_Alignment - 1);
+			uintptr_t ptr = (uintptr_t)m_buffer->GetBuffer();
+			ptr = (ptr + asd_FlatBuffers_Alignment - 1) & ~(uintptr_t)(asd_FlatBuffers_Alignment - 1);
+			return (uint8_t*)ptr;
+		}
+
+		// 상대방이 보낸 데이터이므로 실패해도 assert 하지 않는다.
+		bool Verify(const Span& a_data,
+					const char* a_identifier)
+		{
+			flatbuffers::Verifier verifier(a_data.Data, a_data.Size);
+			if (verifier.template VerifyBuffer<RootType>(a_identifier) == false) {
+				Reset();
+				return false;
+			}
+			m_data = a_data;
+			m_root = flatbuffers::GetRoot<RootType>(a_data.Data);
+			return true;
+		}
+
+		Buffer_ptr m_buffer;	// 메시지를 담고 있는 버퍼 (뷰를 그대로 검증한 경우 nullptr)
+		Span m_data;
+		const RootType* m_root = nullptr;
+	};
+
+#endif
 
 }
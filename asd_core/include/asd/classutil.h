@@ -21,6 +21,18 @@ namespace asd
 
 
 
+	// 컴파일 타임 정수 시퀀스 (C++11에서 std::index_sequence 대신 사용)
+	template <size_t... Remains>
+	struct seq {};
+
+	template <size_t N, size_t... Remains>
+	struct gen_seq : gen_seq<N-1, N-1, Remains...> {};
+
+	template <size_t... Remains>
+	struct gen_seq<0, Remains...> : seq <Remains...> {};
+
+
+
 	template <typename T>
 	class Global
 	{
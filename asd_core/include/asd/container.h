@@ -4,6 +4,8 @@
 #include "util.h"
 #include <map>
 #include <unordered_map>
+#include <iterator>
+#include <type_traits>
 
 namespace asd
 {
@@ -64,6 +66,34 @@ namespace asd
 		}
 
 
+		// 키로 조회할 필요가 없는 데이터(통계, free list 등)를 담는 경우
+		// 키 대신 현재 CPU(또는 쓰레드)를 기준으로 샤드를 선택한다.
+		inline Container* GetLocalShard(ShardPolicy a_policy = ShardPolicy::CurrentCpu)
+		{
+			return &m_shards[GetShardSeed(a_policy) % m_shardCount];
+		}
+
+
+		inline size_t GetShardCount() const
+		{
+			return m_shardCount;
+		}
+
+
+		inline Container* GetShardByIndex(size_t a_index)
+		{
+			asd_DAssert(a_index < m_shardCount);
+			return &m_shards[a_index];
+		}
+
+
+		inline const Container* GetShardByIndex(size_t a_index) const
+		{
+			asd_DAssert(a_index < m_shardCount);
+			return &m_shards[a_index];
+		}
+
+
 		inline void clear()
 		{
 			for (size_t i=0; i<m_shardCount; ++i)
@@ -156,4 +186,292 @@ namespace asd
 
 	template <typename KEY, typename VALUE, typename... ARGS>
 	using ShardedHashMap = ShardedMapTemplate<KEY, VALUE, std::unordered_map<KEY, std::shared_ptr<VALUE>, ARGS...>>;
+
+
+	// 원소가 적을 때 힙 할당을 하지 않는 deque
+	// INLINE_COUNT 개 까지는 객체 내부 공간을 링버퍼로 사용하고,
+	// 넘어서면 2배씩 늘어나는 힙 링버퍼로 옮긴다.
+	// (std::deque는 원소가 1개라도 map과 block을 할당한다)
+	template <typename T, size_t INLINE_COUNT = 4>
+	class InlineDeque
+	{
+		static_assert(INLINE_COUNT>0 && (INLINE_COUNT & (INLINE_COUNT-1))==0,
+					  "INLINE_COUNT must be a power of 2");
+
+	public:
+		typedef T			value_type;
+		typedef size_t		size_type;
+		typedef ptrdiff_t	difference_type;
+		typedef T&			reference;
+		typedef const T&	const_reference;
+
+		template <typename Owner, typename Value>
+		class Iterator
+		{
+		public:
+			typedef std::random_access_iterator_tag			iterator_category;
+			typedef typename std::remove_const<Value>::type	value_type;
+			typedef ptrdiff_t								difference_type;
+			typedef Value*									pointer;
+			typedef Value&									reference;
+
+			Owner* m_owner = nullptr;
+			size_t m_index = 0;
+
+			inline Iterator() {}
+
+			inline Iterator(Owner* a_owner,
+							size_t a_index)
+				: m_owner(a_owner)
+				, m_index(a_index)
+			{
+			}
+
+			// iterator -> const_iterator
+			template <typename O, typename V>
+			inline Iterator(const Iterator<O, V>& a_other)
+				: m_owner(a_other.m_owner)
+				, m_index(a_other.m_index)
+			{
+			}
+
+			inline reference operator*() const						{ return (*m_owner)[m_index]; }
+			inline pointer operator->() const						{ return &(*m_owner)[m_index]; }
+			inline reference operator[](difference_type a_n) const	{ return (*m_owner)[m_index + a_n]; }
+
+			inline Iterator& operator++()							{ ++m_index; return *this; }
+			inline Iterator& operator--()							{ --m_index; return *this; }
+			inline Iterator operator++(int)							{ Iterator r = *this; ++m_index; return r; }
+			inline Iterator operator--(int)							{ Iterator r = *this; --m_index; return r; }
+			inline Iterator& operator+=(difference_type a_n)		{ m_index += a_n; return *this; }
+			inline Iterator& operator-=(difference_type a_n)		{ m_index -= a_n; return *this; }
+			inline Iterator operator+(difference_type a_n) const	{ return Iterator(m_owner, m_index + a_n); }
+			inline Iterator operator-(difference_type a_n) const	{ return Iterator(m_owner, m_index - a_n); }
+			inline difference_type operator-(const Iterator& a_other) const
+			{
+				return (difference_type)m_index - (difference_type)a_other.m_index;
+			}
+
+			inline bool operator==(const Iterator& a_other) const	{ return m_index == a_other.m_index; }
+			inline bool operator!=(const Iterator& a_other) const	{ return m_index != a_other.m_index; }
+			inline bool operator<(const Iterator& a_other) const	{ return m_index < a_other.m_index; }
+			inline bool operator>(const Iterator& a_other) const	{ return m_index > a_other.m_index; }
+			inline bool operator<=(const Iterator& a_other) const	{ return m_index <= a_other.m_index; }
+			inline bool operator>=(const Iterator& a_other) const	{ return m_index >= a_other.m_index; }
+		};
+
+		typedef Iterator<InlineDeque, T>					iterator;
+		typedef Iterator<const InlineDeque, const T>		const_iterator;
+		typedef std::reverse_iterator<iterator>				reverse_iterator;
+		typedef std::reverse_iterator<const_iterator>		const_reverse_iterator;
+
+
+	private:
+		typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+		Storage m_inline[INLINE_COUNT];
+		T* m_data = reinterpret_cast<T*>(m_inline);
+		size_t m_capacity = INLINE_COUNT;
+		size_t m_head = 0;
+		size_t m_size = 0;
+
+		inline bool IsInline() const
+		{
+			return m_data == reinterpret_cast<const T*>(m_inline);
+		}
+
+		inline T* Slot(size_t a_index) const
+		{
+			return m_data + ((m_head + a_index) & (m_capacity - 1));
+		}
+
+		void Reallocate(size_t a_capacity)
+		{
+			asd_DAssert(a_capacity >= m_size);
+			asd_DAssert((a_capacity & (a_capacity-1)) == 0);
+
+			T* newData = a_capacity > INLINE_COUNT
+				? static_cast<T*>(::operator new(sizeof(T) * a_capacity))
+				: reinterpret_cast<T*>(m_inline);
+			asd_DAssert(newData != m_data);
+
+			for (size_t i=0; i<m_size; ++i) {
+				T* src = Slot(i);
+				new(newData + i) T(std::move(*src));
+				src->~T();
+			}
+
+			if (IsInline() == false)
+				::operator delete(m_data);
+			m_data = newData;
+			m_capacity = a_capacity;
+			m_head = 0;
+		}
+
+		inline void Reserve1()
+		{
+			if (m_size == m_capacity)
+				Reallocate(m_capacity * 2);
+		}
+
+		void MoveFrom(InlineDeque& a_other)
+		{
+			asd_DAssert(m_size == 0);
+			if (a_other.IsInline()) {
+				for (size_t i=0; i<a_other.m_size; ++i)
+					emplace_back(std::move(a_other[i]));
+				a_other.clear();
+				return;
+			}
+
+			if (IsInline() == false)
+				::operator delete(m_data);
+			m_data = a_other.m_data;
+			m_capacity = a_other.m_capacity;
+			m_head = a_other.m_head;
+			m_size = a_other.m_size;
+
+			a_other.m_data = reinterpret_cast<T*>(a_other.m_inline);
+			a_other.m_capacity = INLINE_COUNT;
+			a_other.m_head = 0;
+			a_other.m_size = 0;
+		}
+
+
+	public:
+		inline InlineDeque()
+		{
+		}
+
+		inline InlineDeque(InlineDeque&& a_rval)
+		{
+			MoveFrom(a_rval);
+		}
+
+		inline InlineDeque& operator=(InlineDeque&& a_rval)
+		{
+			if (this != &a_rval) {
+				clear();
+				MoveFrom(a_rval);
+			}
+			return *this;
+		}
+
+		InlineDeque(const InlineDeque&) = delete;
+		InlineDeque& operator=(const InlineDeque&) = delete;
+
+		inline ~InlineDeque()
+		{
+			clear();
+			if (IsInline() == false)
+				::operator delete(m_data);
+		}
+
+		inline size_t size() const				{ return m_size; }
+		inline bool empty() const				{ return m_size == 0; }
+		inline size_t capacity() const			{ return m_capacity; }
+
+		inline T& operator[](size_t a_index)
+		{
+			asd_DAssert(a_index < m_size);
+			return *Slot(a_index);
+		}
+
+		inline const T& operator[](size_t a_index) const
+		{
+			asd_DAssert(a_index < m_size);
+			return *Slot(a_index);
+		}
+
+		inline T& at(size_t a_index)
+		{
+			asd_RAssert(a_index < m_size, "out of range, {} >= {}", a_index, m_size);
+			return *Slot(a_index);
+		}
+
+		inline const T& at(size_t a_index) const
+		{
+			asd_RAssert(a_index < m_size, "out of range, {} >= {}", a_index, m_size);
+			return *Slot(a_index);
+		}
+
+		inline T& front()						{ return (*this)[0]; }
+		inline const T& front() const			{ return (*this)[0]; }
+		inline T& back()						{ return (*this)[m_size - 1]; }
+		inline const T& back() const			{ return (*this)[m_size - 1]; }
+
+		template <typename... Args>
+		inline T& emplace_back(Args&&... a_args)
+		{
+			Reserve1();
+			T* p = Slot(m_size);
+			new(p) T(std::forward<Args>(a_args)...);
+			++m_size;
+			return *p;
+		}
+
+		template <typename... Args>
+		inline T& emplace_front(Args&&... a_args)
+		{
+			Reserve1();
+			const size_t head = (m_head + m_capacity - 1) & (m_capacity - 1);
+			T* p = m_data + head;
+			new(p) T(std::forward<Args>(a_args)...);
+			m_head = head;
+			++m_size;
+			return *p;
+		}
+
+		inline void push_back(T&& a_val)			{ emplace_back(std::move(a_val)); }
+		inline void push_front(T&& a_val)			{ emplace_front(std::move(a_val)); }
+
+		inline void pop_front()
+		{
+			asd_DAssert(m_size > 0);
+			Slot(0)->~T();
+			m_head = (m_head + 1) & (m_capacity - 1);
+			--m_size;
+		}
+
+		inline void pop_back()
+		{
+			asd_DAssert(m_size > 0);
+			Slot(m_size - 1)->~T();
+			--m_size;
+		}
+
+		void resize(size_t a_size)
+		{
+			while (m_size > a_size)
+				pop_back();
+			while (m_size < a_size)
+				emplace_back();
+		}
+
+		// 할당된 용량은 유지한다.
+		inline void clear()
+		{
+			resize(0);
+			m_head = 0;
+		}
+
+		// 원소 수가 INLINE_COUNT 이하면 힙 메모리를 반납하고 내부 공간으로 돌아간다.
+		void shrink_to_fit()
+		{
+			if (IsInline() || m_size > INLINE_COUNT)
+				return;
+			Reallocate(INLINE_COUNT);
+		}
+
+		inline iterator begin()							{ return iterator(this, 0); }
+		inline iterator end()							{ return iterator(this, m_size); }
+		inline const_iterator begin() const				{ return const_iterator(this, 0); }
+		inline const_iterator end() const				{ return const_iterator(this, m_size); }
+		inline const_iterator cbegin() const			{ return begin(); }
+		inline const_iterator cend() const				{ return end(); }
+		inline reverse_iterator rbegin()				{ return reverse_iterator(end()); }
+		inline reverse_iterator rend()					{ return reverse_iterator(begin()); }
+		inline const_reverse_iterator rbegin() const	{ return const_reverse_iterator(end()); }
+		inline const_reverse_iterator rend() const		{ return const_reverse_iterator(begin()); }
+	};
 }
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include "asdbase.h"
+#include "buffer.h"
+#include <mutex>
+
+namespace asd
+{
+	// 파일의 일부 구간을 가리키는 읽기 전용 버퍼
+	// GetBuffer()를 처음 호출할 때 해당 구간을 메모리에 매핑한다.
+	// 송신큐에 넣으면 epoll 백엔드는 매핑하지 않고 sendfile로 전송하므로 파일 내용이 유저 공간을 거치지 않는다.
+	class FileBuffer final
+		: public BufferInterface
+	{
+	public:
+#if defined(asd_Platform_Windows)
+		using Handle = void*;	// HANDLE
+
+#else
+		using Handle = int;
+
+#endif
+
+		// [a_offset, a_offset + a_bytes) 구간을 연다.
+		// a_bytes가 0이면 a_offset부터 파일 끝까지이며,
+		// 실패하거나 구간이 비어있으면 nullptr를 리턴한다.
+		static Buffer_ptr Open(const char* a_path,
+							   uint64_t a_offset = 0,
+							   size_t a_bytes = 0);
+
+		// 매핑에 실패하면 nullptr
+		virtual uint8_t* GetBuffer() const override;
+
+		virtual size_t Capacity() const override;
+
+		virtual size_t GetSize() const override;
+
+		virtual bool SetSize(size_t a_bytes) override;
+
+		virtual const FileBuffer* GetFile() const override;
+
+		inline Handle GetNativeHandle() const
+		{
+			return m_file;
+		}
+
+		inline uint64_t GetOffset() const
+		{
+			return m_offset;
+		}
+
+		virtual ~FileBuffer();
+
+	private:
+		FileBuffer();
+
+		void Map() const;
+
+		Handle m_file;
+		uint64_t m_offset = 0;
+		size_t m_size = 0;
+
+		mutable std::once_flag m_mapOnce;
+		mutable void* m_map = nullptr;		// 매핑된 시작주소 (매핑 단위로 정렬됨)
+		mutable size_t m_mapPadding = 0;	// m_map부터 m_offset까지의 거리
+	};
+}
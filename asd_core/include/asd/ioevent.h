@@ -2,9 +2,12 @@
 #include "asdbase.h"
 #include "socket.h"
 #include "buffer.h"
+#include "sysutil.h"
 #include "lock.h"
 #include "threadutil.h"
 #include "handle.h"
+#include <string>
+#include <deque>
 
 namespace asd
 {
@@ -12,17 +15,127 @@ namespace asd
 	class IOEventInternal;
 	class IOEventInternal_IOCP;
 	class IOEventInternal_EPOLL;
+	class IOEventInternal_URING;
+	class AsyncSocketDispatch;
+	class ThreadPool;
 
 	class AsyncSocket;
 	using AsyncSocketHandle = Handle<AsyncSocket, uintptr_t>;
 	using AsyncSocket_ptr = std::shared_ptr<AsyncSocket>;
 
+	// AsyncSocket::SetFraming()의 프레임 설정
+	struct FrameOption
+	{
+		#define asd_FrameOption_DefaultMaxFrameSize		( 64 * 1024 )
+
+		enum class Type : uint8_t
+		{
+			LengthPrefix,	// [본문 길이][본문]
+			Delimiter,		// [본문][구분자]
+		};
+
+		Type		FrameType		= Type::LengthPrefix;
+		uint8_t		PrefixBytes		= 4;				// 1, 2, 4
+		Endian		PrefixEndian	= Endian::Little;
+		std::string	Delimiter		= "\n";
+		size_t		MaxFrameSize	= asd_FrameOption_DefaultMaxFrameSize;	// 본문의 최대 크기
+	};
+
+
+	// IOEvent::Start()의 동작 설정
+	struct IOEventOption
+	{
+		#define asd_IOEventOption_DefaultPollBatchSize	128
+		#define asd_IOEventOption_DefaultEdgeBudget		16
+		#define asd_IOEventOption_DefaultRecvBufferMin	( 512 )
+		#define asd_IOEventOption_DefaultRecvBufferMax	( 64 * 1024 )
+		#define asd_IOEventOption_DefaultDatagramBatchSize	32
+		#define asd_IOEventOption_DefaultDatagramMaxSize	( 2 * 1024 )
+
+		enum class Backend : uint8_t
+		{
+			Native,		// 윈도우는 IOCP, 리눅스는 epoll
+			IOUring,	// (리눅스 전용) io_uring, 커널이 지원하지 않으면 Native를 사용한다.
+		};
+
+		// 사용할 IO 다중화 방식. 실제로 선택된 방식은 IOEvent::GetBackend()로 확인
+		Backend		BackendType		= Backend::Native;
+
+		// IO 쓰레드가 한번의 대기(epoll_wait 등)로 가져와 처리하는 최대 이벤트 수
+		uint32_t	PollBatchSize	= asd_IOEventOption_DefaultPollBatchSize;
+
+		// (epoll 전용) IO 쓰레드마다 별도의 epoll을 사용한다.
+		// 소켓은 등록된 쓰레드에서만 처리되고, 리스너는 SO_REUSEPORT로 쓰레드마다 하나씩 만들어
+		// accept한 쓰레드가 그 연결을 끝까지 담당한다.
+		bool		PerThreadPoller	= false;
+
+		// (epoll 전용) 소켓을 EPOLLET로 한번만 등록하고, 이벤트마다 EAGAIN이 될 때까지 recv/accept 한다.
+		// 이벤트마다 epoll_ctl로 다시 등록하지 않으며, 소켓별 원자적 상태로 한 쓰레드만 처리하도록 한다.
+		bool		EdgeTriggered	= false;
+
+		// EdgeTriggered 인 경우 한 소켓에서 연속으로 recv/accept 하는 최대 횟수
+		// 다 읽지 못한 소켓은 다른 소켓들을 처리한 뒤 이어서 읽는다.
+		uint32_t	EdgeBudget		= asd_IOEventOption_DefaultEdgeBudget;
+
+		// 설정하면 OnRecv, OnRecvFrom, OnAccept, OnClose를 IO 쓰레드에서 바로 호출하지 않고
+		// 소켓 핸들을 키로 PushSeq하여 이 쓰레드풀에서 소켓별 순서대로 호출한다.
+		// OnConnect, OnRecvRing, OnMessage는 그대로 IO 쓰레드에서 호출된다.
+		// 쓰레드풀은 IOEvent보다 먼저 Stop 해야 한다.
+		ThreadPool*	DispatchPool	= nullptr;
+
+		// RecvMode::Chunk 인 소켓의 수신 버퍼 크기 (bytes)
+		// 버퍼를 가득 채우는 수신이 나오면 RecvBufferMax까지 두 배로 늘리고,
+		// 절반도 채우지 못하는 수신이 연속되면 RecvBufferMin까지 절반으로 줄인다.
+		// 세 값이 모두 같으면 고정 크기로 동작한다.
+		uint32_t	RecvBufferMin	= asd_IOEventOption_DefaultRecvBufferMin;
+		uint32_t	RecvBufferInit	= asd_BufferList_DefaultReadBufferSize;
+		uint32_t	RecvBufferMax	= asd_IOEventOption_DefaultRecvBufferMax;
+
+		// true이면 수신을 기다리는 동안 소켓이 수신 버퍼를 들고 있지 않는다.
+		// epoll과 io_uring은 수신 가능 통지를 받은 뒤에 버퍼를 할당하고,
+		// IOCP는 0바이트 WSARecv로 대기한다. 유휴 연결이 많은 서버의 메모리 사용량을 줄인다.
+		bool		LazyRecvBuffer	= false;
+
+		// (리눅스 전용) UDP 소켓에서 recvmmsg/sendmmsg 한번으로 주고받는 최대 데이터그램 수
+		uint32_t	DatagramBatchSize	= asd_IOEventOption_DefaultDatagramBatchSize;
+
+		// UDP 소켓의 데이터그램 수신 버퍼 크기 (bytes), 이보다 큰 데이터그램은 버린다.
+		uint32_t	DatagramMaxSize		= asd_IOEventOption_DefaultDatagramMaxSize;
+
+		// 송신 대기량 수위의 기본값 (bytes), AsyncSocket::SetSendWatermark로 따로 설정하지 않은 소켓에 적용된다.
+		// SendHighWatermark가 0이면 제한하지 않는다.
+		size_t		SendHighWatermark	= 0;
+		size_t		SendLowWatermark	= 0;
+
+		// (epoll, io_uring) 송신큐에서 이웃한 이 크기(bytes) 미만의 버퍼들을 풀에서 할당한 블록 하나로 모아 보낸다.
+		// 작은 Send가 잦을 때 송신 시스템콜과 iovec 수를 줄인다. 0이면 모으지 않는다. (최대 asd_BufferList_DefaultWriteBufferSize)
+		uint32_t	SendCoalesceSize	= asd_BufferList_MinWriteBufferSize;
+
+		// (epoll 전용) 이 크기(bytes) 이상 남은 버퍼는 MSG_ZEROCOPY로 복사 없이 보낸다. 0이면 사용하지 않는다.
+		// 보낸 버퍼는 커널의 완료통지를 받을 때까지 유지되며, 정상 종료는 완료통지를 기다린다.
+		// 커널이 복사로 대체하는 경로(loopback 등)이면 그 소켓은 이후 writev를 사용한다.
+		uint32_t	ZeroCopyThreshold	= 0;
+	};
+
+
+	// AsyncSocket::GetSendStats()
+	// IOEventOption::SendCoalesceSize, ZeroCopyThreshold 가 적용된 횟수
+	struct SendStats
+	{
+		size_t	CoalescedBuffers	= 0;	// 블록에 모아서 보낸 작은 버퍼 수
+		size_t	ZeroCopySends		= 0;	// MSG_ZEROCOPY로 보낸 sendmsg 호출 수
+		size_t	ZeroCopyDone		= 0;	// 그 중 커널이 완료를 통지한 수 (복사로 대체된 것 포함)
+	};
+
+
 	class AsyncSocket : public Socket
 	{
 		friend class asd::IOEvent;
 		friend class asd::IOEventInternal;
 		friend class asd::IOEventInternal_IOCP;
 		friend class asd::IOEventInternal_EPOLL;
+		friend class asd::IOEventInternal_URING;
+		friend class asd::AsyncSocketDispatch;
 
 		enum class State : uint8_t
 		{
@@ -46,14 +159,77 @@ namespace asd
 		// 수신 버퍼
 		Buffer_ptr m_recvBuffer;
 
+		// 다음 수신 버퍼 크기 (0이면 IOEventOption::RecvBufferInit)
+		uint32_t m_recvSize = 0;
+
+		// 수신 버퍼의 절반도 채우지 못한 연속 수신 횟수
+		uint8_t m_recvShrink = 0;
+
+		// RecvMode::Ring, RecvMode::Frame 인 경우 사용하는 수신 링버퍼
+		std::unique_ptr<RingBuffer> m_recvRing;
+
+		// RecvMode::Frame 인 경우의 프레임 설정
+		std::unique_ptr<FrameOption> m_frameOption;
+
+		// 구분자 모드에서 구분자가 없음을 이미 확인한 바이트 수 (재검색 방지)
+		size_t m_frameScan = 0;
+
 		// 마지막에 발생한 소켓에러
 		Socket::Error m_lastError = 0;
 
+		// IOEventOption::PerThreadPoller 또는 io_uring 인 경우 이 소켓을 담당하는 IO 쓰레드 인덱스
+		// 등록할 때 정해지며, accept한 소켓은 리스너의 인덱스를 물려받는다.
+		uint32_t m_pollerIndex = std::numeric_limits<uint32_t>::max();
+
+		// IO 쓰레드마다 나눠 만든 리스너들 (원본 리스너에만 있음)
+		std::vector<AsyncSocketHandle> m_listenShards;
+
+		// 나눠 만든 리스너인 경우 원본 리스너
+		AsyncSocketHandle m_listenOwner;
+
+		// IOEventOption::EdgeTriggered 인 경우 처리를 기다리는 epoll 이벤트 비트
+		std::atomic<uint32_t> m_pollEvents{0};
+
+		// IOEventOption::EdgeTriggered 인 경우 이 소켓을 처리중인 IO 쓰레드가 있으면 true
+		std::atomic_bool m_pollOwned{false};
+
+		// IOEventOption::DispatchPool 인 경우 쓰레드풀로 넘길 콜백 큐
+		std::shared_ptr<AsyncSocketDispatch> m_dispatch;
+
 		// m_sendQueue와 m_sendSignal을 보호하는 락
 		mutable Mutex m_sendLock;
 
 		// 송신 큐
-		std::deque<Buffer_ptr> m_sendQueue;
+		BufferQueue m_sendQueue;
+
+		// m_sendQueue의 첫번째 버퍼에서 이미 송신한 바이트 수
+		size_t m_sendOffset = 0;
+
+		// 송신을 마치지 못한 바이트 수 (IOCP는 커널에 넘긴 뒤 완료되지 않은 것도 포함)
+		size_t m_sendBytes = 0;
+
+		// 송신 대기량의 높은 수위와 낮은 수위 (bytes), 높은 수위가 0이면 제한 없음
+		size_t m_sendHighWatermark = 0;
+		size_t m_sendLowWatermark = 0;
+
+		// 높은 수위에 도달한 뒤 낮은 수위까지 내려가기 전이면 true (Send를 받지 않음)
+		bool m_sendBlocked = false;
+
+		// 낮은 수위까지 내려가서 IO 쓰레드가 OnSendDrained를 호출해야 하면 true
+		bool m_sendDrained = false;
+
+		// 송신 방식별 통계
+		SendStats m_sendStats;
+
+		// UDP 송신 큐의 항목
+		struct Datagram
+		{
+			Buffer_ptr	m_data;
+			IpAddress	m_dst;
+		};
+
+		// UDP 송신 큐
+		std::deque<Datagram> m_sendToQueue;
 
 		// IO 쓰레드에게 송신 요청 전달하는 동안 true로 셋팅 (중복요청 방지를 위함)
 		bool m_sendSignal = false;
@@ -62,15 +238,53 @@ namespace asd
 		static std::shared_ptr<AsyncSocketNative> InitNative();
 		std::shared_ptr<AsyncSocketNative> m_native = InitNative();
 
+		// m_sendLock을 잡은 상태에서 a_push로 송신큐에 추가하고 IO 쓰레드에 송신을 요청한다.
+		// a_push는 추가한 버퍼 수를 리턴
+		template <typename Push>
+		bool SendInternal(Push&& a_push);
+
+		// 보내지 못한 데이터가 남아있으면 true, m_sendLock을 잡은 상태에서 호출
+		inline bool HasPendingSend() const
+		{
+			return m_sendQueue.empty() == false || m_sendToQueue.empty() == false;
+		}
+
 
 	public:
 		using Socket::Socket;
 
-		bool Send(std::deque<Buffer_ptr>&& a_data);
+		enum class RecvMode : uint8_t
+		{
+			Chunk,	// 수신할 때마다 새 버퍼를 IOEvent::OnRecv로 전달
+			Ring,	// 소켓별 링버퍼에 누적하여 IOEvent::OnRecvRing으로 전달
+			Frame,	// 링버퍼에서 완성된 프레임을 잘라 IOEvent::OnMessage로 전달 (SetFraming으로 설정)
+		};
+
+		// IOEvent에 등록되기 전에만 변경 가능하다.
+		// Ring 모드에서 처리되지 않고 쌓인 데이터가 a_ringLimit에 도달하면 소켓을 닫는다.
+		bool SetRecvMode(RecvMode a_mode,
+						 size_t a_ringLimit = asd_RingBuffer_DefaultLimit);
+
+		RecvMode GetRecvMode() const;
+
+		// 현재 잡고 있는 수신 버퍼의 크기, 없으면 0
+		// IOEventOption::LazyRecvBuffer 이면 수신할 데이터가 없는 동안에는 버퍼를 잡지 않는다.
+		size_t GetRecvBufferCapacity() const;
+
+		// 다음 수신에 사용할 버퍼 크기 (IOEventOption::RecvBufferMin ~ RecvBufferMax)
+		size_t GetRecvSize() const;
+
+
+		// RecvMode::Frame으로 설정한다. IOEvent에 등록되기 전에만 가능하다.
+		// IO 쓰레드에서 프레임을 조립하므로 프레임은 항상 연속된 메모리로 복사 없이 전달되며,
+		// 본문이 MaxFrameSize를 넘으면 EMSGSIZE 에러로 소켓을 닫는다.
+		bool SetFraming(const FrameOption& a_option);
+
+		bool Send(BufferQueue&& a_data);
 
 		inline bool Send(BufferList&& a_data)
 		{
-			std::deque<Buffer_ptr>& cast = a_data;
+			BufferQueue& cast = a_data;
 			if (Send(std::move(cast))) {
 				a_data.Clear();
 				return true;
@@ -78,11 +292,37 @@ namespace asd
 			return false;
 		}
 
-		inline bool Send(Buffer_ptr&& a_data)
+		bool Send(Buffer_ptr&& a_data);
+
+		// 여러 소켓에 같은 데이터를 보내는 경우 복사 없이 참조만 큐잉한다.
+		inline bool Send(const SharedBuffer& a_data)
+		{
+			return Send(a_data.NewRef());
+		}
+
+		// 송신 대기량이 a_high 이상이 되면 IOEvent::OnSendBlocked를 호출하고,
+		// 이후 a_low 이하로 내려가 IOEvent::OnSendDrained가 호출될 때까지 Send/SendTo는 false를 리턴한다.
+		// a_high가 0이면 제한하지 않는다.
+		void SetSendWatermark(size_t a_high,
+							  size_t a_low);
+
+		// 송신을 마치지 못한 바이트 수
+		size_t GetPendingSendBytes() const;
+
+		SendStats GetSendStats() const;
+
+		// 마지막에 발생한 소켓에러, 없으면 0
+		Socket::Error GetLastError() const;
+
+		// IOEvent::RegisterUDP로 등록한 소켓에서 a_data를 데이터그램 하나로 a_dst에게 보낸다.
+		// 보내지 못한 데이터그램(EMSGSIZE, ENETUNREACH 등)은 소켓을 닫지 않고 버리며, 그 에러는 GetLastError()로 확인한다.
+		bool SendTo(Buffer_ptr&& a_data,
+					const IpAddress& a_dst);
+
+		inline bool SendTo(const SharedBuffer& a_data,
+						   const IpAddress& a_dst)
 		{
-			std::deque<Buffer_ptr> list;
-			list.emplace_back(std::move(a_data));
-			return Send(std::move(list));
+			return SendTo(a_data.NewRef(), a_dst);
 		}
 
 
@@ -104,10 +344,14 @@ namespace asd
 	public:
 		virtual ~IOEvent();
 
-		void Start(uint32_t a_threadCount = Get_HW_Concurrency());
+		void Start(uint32_t a_threadCount = Get_HW_Concurrency(),
+				   const IOEventOption& a_option = IOEventOption());
 
 		void Stop();
 
+		// Start()에서 실제로 선택된 IO 다중화 방식
+		IOEventOption::Backend GetBackend() const;
+
 
 		bool RegisterListener(AsyncSocket_ptr& a_sock,
 							  const IpAddress& a_bind,
@@ -142,9 +386,23 @@ namespace asd
 		}
 
 
+		// a_bind에 바인드한 UDP 소켓을 등록한다. 수신한 데이터그램은 OnRecvFrom으로 전달된다.
+		// IOCP에서는 아직 지원하지 않으며 false를 리턴한다. (WSARecvFrom/WSASendTo 미구현)
+		bool RegisterUDP(AsyncSocket_ptr& a_sock,
+						 const IpAddress& a_bind);
+
+		inline bool RegisterUDP(AsyncSocketHandle a_sockHandle,
+								const IpAddress& a_bind)
+		{
+			auto sock = a_sockHandle.GetObj();
+			return RegisterUDP(sock, a_bind);
+		}
+
+
 		void Poll(uint32_t a_timeoutSec);
 
 
+		// IOEventOption::PerThreadPoller 인 경우 같은 리스너에 대해 여러 IO 쓰레드에서 동시에 호출될 수 있다.
 		virtual void OnAccept(AsyncSocket* a_listener,
 							  AsyncSocket_ptr&& a_newSock)
 		{
@@ -167,6 +425,49 @@ namespace asd
 			asd_DAssert(handle.IsValid());
 		}
 
+		// RegisterUDP로 등록한 소켓의 수신 콜백, a_data는 데이터그램 하나
+		virtual void OnRecvFrom(AsyncSocket* a_sock,
+								const IpAddress& a_src,
+								Buffer_ptr&& a_data)
+		{
+			auto handle = AsyncSocketHandle::GetHandle(a_sock);
+			asd_DAssert(handle.IsValid());
+		}
+
+		// 송신 대기량이 높은 수위에 도달함 (AsyncSocket::SetSendWatermark)
+		// 수위를 넘긴 Send를 호출한 쓰레드에서 호출되며, OnSendDrained 전까지 Send는 false를 리턴한다.
+		virtual void OnSendBlocked(AsyncSocket* a_sock)
+		{
+			auto handle = AsyncSocketHandle::GetHandle(a_sock);
+			asd_DAssert(handle.IsValid());
+		}
+
+		// 송신 대기량이 낮은 수위 이하로 내려가 다시 Send할 수 있음. IO 쓰레드에서 호출된다.
+		virtual void OnSendDrained(AsyncSocket* a_sock)
+		{
+			auto handle = AsyncSocketHandle::GetHandle(a_sock);
+			asd_DAssert(handle.IsValid());
+		}
+
+		// RecvMode::Ring 인 소켓의 수신 콜백
+		// 파싱한 만큼 a_data.Consume()하고 남은 데이터는 다음 수신 때 이어서 전달된다.
+		virtual void OnRecvRing(AsyncSocket* a_sock,
+								RingBuffer& a_data)
+		{
+			auto handle = AsyncSocketHandle::GetHandle(a_sock);
+			asd_DAssert(handle.IsValid());
+			a_data.Consume(a_data.GetSize());
+		}
+
+		// RecvMode::Frame 인 소켓의 수신 콜백
+		// a_frame은 구분자나 길이 헤더를 제외한 본문이며, 콜백 안에서만 유효하다.
+		virtual void OnMessage(AsyncSocket* a_sock,
+							   const Span& a_frame)
+		{
+			auto handle = AsyncSocketHandle::GetHandle(a_sock);
+			asd_DAssert(handle.IsValid());
+		}
+
 		virtual void OnClose(AsyncSocket* a_sock, 
 							 Socket::Error a_err)
 		{
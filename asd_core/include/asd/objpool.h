@@ -453,8 +453,10 @@ namespace asd
 
 
 
-	template <typename ObjectPoolType>
-	class ObjectPoolShardSet
+	template <
+		typename ObjectPoolType,
+		ShardPolicy SHARD_POLICY = ShardPolicy::CurrentCpu
+	> class ObjectPoolShardSet
 	{
 		static_assert(ObjectPoolType::IsThreadSafe, "thread unsafe pool");
 
@@ -495,13 +497,23 @@ namespace asd
 
 
 	public:
-		typedef ObjectPoolShardSet<ObjectPoolType>				ThisType;
-		typedef typename PoolTemplate<ObjectPoolType>::Type		Pool;
-		typedef typename Pool::Object							Object;
+		typedef ObjectPoolShardSet<ObjectPoolType, SHARD_POLICY>	ThisType;
+		typedef typename PoolTemplate<ObjectPoolType>::Type			Pool;
+		typedef typename Pool::Object								Object;
 
+		static constexpr ShardPolicy Policy = SHARD_POLICY;
 
 
-		ObjectPoolShardSet(size_t a_shardCount = 4*Get_HW_Concurrency(),
+
+		// CurrentCpu는 CPU 번호로 샤드를 고르므로 CPU 수보다 많은 샤드는 쓰이지 않는다.
+		static size_t DefaultShardCount()
+		{
+			return Policy == ShardPolicy::CurrentCpu ? Get_HW_Concurrency() : 4*Get_HW_Concurrency();
+		}
+
+
+
+		ObjectPoolShardSet(size_t a_shardCount = DefaultShardCount(),
 						   size_t a_totalLimitCount = std::numeric_limits<size_t>::max(),
 						   size_t a_initCount = 0)
 			: m_shardCount(max(1u, a_shardCount))
@@ -558,7 +570,7 @@ namespace asd
 			size_t index;
 			if (a_obj == nullptr) {
 				// alloc
-				index = GetCurrentThreadSequence() % m_shardCount;
+				index = GetShardSeed(Policy) % m_shardCount;
 			}
 			else {
 				// free
@@ -581,4 +593,107 @@ namespace asd
 		Pool*					m_shards;
 
 	};
+
+
+
+	// 크기별로 공유되는 메모리 블록 풀
+	// 프로그램 종료 시 전역 객체들의 소멸 순서와 무관하게 사용할 수 있도록 풀 자체는 해제하지 않는다.
+	template <size_t BYTES>
+	class RawMemoryPool
+	{
+	public:
+		static constexpr size_t Bytes = BYTES;
+
+		struct Block
+		{
+			uint8_t m_data[Bytes];
+		};
+
+		using PoolType = ObjectPoolShardSet< ObjectPool2<Block, true> >;
+
+		static PoolType& Instance()
+		{
+			static PoolType* s_pool = new PoolType;
+			return *s_pool;
+		}
+
+		inline static void* Alloc()
+		{
+			return Instance().Alloc();
+		}
+
+		inline static void Free(void* a_ptr)
+		{
+			Instance().Free((Block*)a_ptr);
+		}
+	};
+
+
+
+	// RawMemoryPool을 사용하는 STL 호환 allocator
+	// 노드 기반 컨테이너(map, set, unordered_map 등)의 노드 단위 할당을 풀링한다.
+	// 여러개를 한번에 할당하는 경우(버킷 배열 등)와 정렬 요구사항이 큰 타입은 기본 할당자를 사용한다.
+	template <typename T>
+	class PoolAllocator
+	{
+	public:
+		using value_type		= T;
+		using pointer			= T*;
+		using const_pointer		= const T*;
+		using reference			= T&;
+		using const_reference	= const T&;
+		using size_type			= size_t;
+		using difference_type	= ptrdiff_t;
+
+		using propagate_on_container_move_assignment = std::true_type;
+		using is_always_equal = std::true_type;
+
+		template <typename U>
+		struct rebind
+		{
+			using other = PoolAllocator<U>;
+		};
+
+		// 비슷한 크기의 타입끼리 풀을 공유하도록 16바이트 단위로 올림
+		static constexpr size_t BlockSize = (sizeof(T) + 15) & ~(size_t)15;
+		static constexpr bool Poolable = alignof(T) <= alignof(void*);
+		using Pool = RawMemoryPool<BlockSize>;
+
+		PoolAllocator() asd_noexcept
+		{
+		}
+
+		template <typename U>
+		PoolAllocator(const PoolAllocator<U>&) asd_noexcept
+		{
+		}
+
+		inline T* allocate(size_t a_count)
+		{
+			if (Poolable && a_count == 1)
+				return (T*)Pool::Alloc();
+			return (T*)::operator new(a_count * sizeof(T));
+		}
+
+		inline void deallocate(T* a_ptr,
+							   size_t a_count)
+		{
+			if (Poolable && a_count == 1)
+				Pool::Free(a_ptr);
+			else
+				::operator delete(a_ptr);
+		}
+
+		template <typename U>
+		inline bool operator==(const PoolAllocator<U>&) const
+		{
+			return true;
+		}
+
+		template <typename U>
+		inline bool operator!=(const PoolAllocator<U>&) const
+		{
+			return false;
+		}
+	};
 }
@@ -3,9 +3,15 @@
 #include "sysutil.h"
 #include "buffer.h"
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
 #include <utility>
+#include <tuple>
+#include <type_traits>
 #include <array>
 #include <vector>
+#include <string>
+#include <memory>
 #include <list>
 #include <set>
 #include <map>
@@ -18,6 +24,7 @@ namespace asd
 	typedef uint16_t			DefaultCountType;
 #define asd_Default_LimitCount	((DefaultCountType)std::numeric_limits<DefaultCountType>::max())
 #define asd_Default_Endian		asd::Endian::Little
+#define asd_Serialize_SwapChunkBytes	512
 
 
 	inline bool InvalidCount(size_t a_count)
@@ -40,6 +47,34 @@ namespace asd
 	}
 
 
+	// 메모리 레이아웃을 그대로 직렬화 포맷으로 사용하는 사용자 정의 POD 구조체
+	//  - 전역 namespace에서 asd_Declare_PodSerializable(Type) 으로 선언한다.
+	//  - 멤버 단위 endian 변환이나 패딩 처리를 하지 않으므로
+	//    같은 레이아웃, 같은 endian을 쓰는 프로그램끼리만 사용할 것
+	template <typename T>
+	struct IsPodSerializableType { static constexpr bool Value = false; };
+
+#define asd_Declare_PodSerializable(Type)											\
+	namespace asd {																	\
+		template <>																	\
+		struct IsPodSerializableType<Type>											\
+		{																			\
+			static_assert(std::is_trivially_copyable<Type>::value, "invalid type");	\
+			static constexpr bool Value = true;										\
+		};																			\
+	}																				\
+
+
+	// 원소 단위가 아닌 배열 전체를 한번에 복사할 수 있는 타입
+	template <typename T>
+	struct IsBulkSerializableType
+	{
+		static constexpr bool Value = IsDirectSerializableType<T>::Value
+								   || IsPodSerializableType<T>::Value;
+	};
+
+
+
 	template<
 		Endian BufferEndian,
 		typename DataType
@@ -50,14 +85,90 @@ namespace asd
 
 
 
+	inline uint16_t ByteSwap(uint16_t a_src)
+	{
+#if asd_Compiler_MSVC
+		return _byteswap_ushort(a_src);
+#else
+		return __builtin_bswap16(a_src);
+#endif
+	}
+
+	inline uint32_t ByteSwap(uint32_t a_src)
+	{
+#if asd_Compiler_MSVC
+		return _byteswap_ulong(a_src);
+#else
+		return __builtin_bswap32(a_src);
+#endif
+	}
+
+	inline uint64_t ByteSwap(uint64_t a_src)
+	{
+#if asd_Compiler_MSVC
+		return _byteswap_uint64(a_src);
+#else
+		return __builtin_bswap64(a_src);
+#endif
+	}
+
+
+	// 크기가 2,4,8 바이트인 타입은 같은 크기의 정수로 옮겨서 intrinsic으로 뒤집는다.
+	template <typename T, size_t Bytes = sizeof(T)>
+	struct Reverser
+	{
+		static T Do(T a_src)
+		{
+			auto src = (const uint8_t*)(&a_src);
+			uint8_t dst[sizeof(T)];
+			for (size_t i=0; i<sizeof(T); ++i)
+				dst[i] = src[(sizeof(T)-1) - i];
+			std::memcpy(&a_src, dst, sizeof(T));
+			return a_src;
+		}
+	};
+
+	template <typename T>
+	struct Reverser<T, 1>
+	{
+		static T Do(T a_src) { return a_src; }
+	};
+
+#define asd_Define_Reverser(Bytes, UInt)						\
+	template <typename T>										\
+	struct Reverser<T, Bytes>									\
+	{															\
+		static T Do(T a_src)									\
+		{														\
+			UInt u;												\
+			std::memcpy(&u, &a_src, Bytes);						\
+			u = ByteSwap(u);									\
+			std::memcpy(&a_src, &u, Bytes);						\
+			return a_src;										\
+		}														\
+	};															\
+
+	asd_Define_Reverser(2, uint16_t);
+	asd_Define_Reverser(4, uint32_t);
+	asd_Define_Reverser(8, uint64_t);
+
+
 	template <typename T>
 	inline T Reverse(T a_src)
 	{
-		auto src = (const uint8_t*)(&a_src);
-		uint8_t dst[sizeof(T)];
-		for (size_t i=0; i<sizeof(T); ++i)
-			dst[i] = src[(sizeof(T)-1) - i];
-		return *((T*)dst);
+		return Reverser<T>::Do(a_src);
+	}
+
+
+	// 분기 없는 단순 루프라서 컴파일러가 SIMD 셔플로 벡터화한다.
+	// a_src와 a_dst가 같아도 된다.
+	template <typename T>
+	inline void ReverseArray(const T* a_src,
+							 T* a_dst /*Out*/,
+							 const size_t a_count)
+	{
+		for (size_t i=0; i<a_count; ++i)
+			a_dst[i] = Reverse(a_src[i]);
 	}
 
 
@@ -110,11 +221,17 @@ namespace asd
 		if (EndianFree<BufferEndian, DataType>())
 			return a_buffer.Write(a_data, TotalBytes);
 
+		// 스택의 임시 영역에서 묶음 단위로 뒤집은 후 한번에 복사
+		const size_t ChunkCount = asd_Serialize_SwapChunkBytes / sizeof(DataType);
+		static_assert(ChunkCount > 0, "invalid ChunkCount");
+		DataType chunk[ChunkCount];
+
 		a_buffer.ReserveBuffer(TotalBytes);
 		size_t ret = 0;
-		for (size_t i=0; i<a_count; ++i) {
-			DataType reverse = Reverse(a_data[i]);
-			ret += a_buffer.Write(&reverse, sizeof(DataType));
+		for (size_t i=0; i<a_count; i+=ChunkCount) {
+			const size_t cnt = std::min(ChunkCount, a_count - i);
+			ReverseArray(a_data + i, chunk, cnt);
+			ret += a_buffer.Write(chunk, sizeof(DataType) * cnt);
 		}
 		asd_DAssert(TotalBytes == ret);
 		return TotalBytes;
@@ -133,10 +250,8 @@ namespace asd
 		const size_t TotalBytes = sizeof(DataType) * a_count;
 		size_t ret = a_buffer.Read(a_data, TotalBytes);
 		if (ret > 0) {
-			if (EndianFree<BufferEndian, DataType>() == false) {
-				for (size_t i=0; i<a_count; ++i)
-					a_data[i] = Reverse(a_data[i]);
-			}
+			if (EndianFree<BufferEndian, DataType>() == false)
+				ReverseArray(a_data, a_data, a_count);
 			asd_DAssert(ret == TotalBytes);
 		}
 		return ret;
@@ -144,6 +259,77 @@ namespace asd
 
 
 
+	// PodType
+	template <typename DataType>
+	inline size_t Write_PodArray(BufferList& a_buffer,
+								 const DataType* a_data,
+								 const size_t a_count)
+	{
+		static_assert(IsPodSerializableType<DataType>::Value, "invalid type");
+		asd_DAssert(GetNativeEndian() == asd_Default_Endian);
+		return a_buffer.Write(a_data, sizeof(DataType) * a_count);
+	}
+
+
+	template <typename DataType>
+	inline size_t Read_PodArray(BufferList& a_buffer,
+								DataType* a_data /*Out*/,
+								const size_t a_count)
+	{
+		static_assert(IsPodSerializableType<DataType>::Value, "invalid type");
+		asd_DAssert(GetNativeEndian() == asd_Default_Endian);
+		return a_buffer.Read(a_data, sizeof(DataType) * a_count);
+	}
+
+
+
+	template <
+		Endian BufferEndian,
+		typename DataType
+	> inline size_t Write_BulkArray(BufferList& a_buffer,
+									const DataType* a_data,
+									const size_t a_count,
+									std::true_type /*IsDirectSerializableType*/)
+	{
+		return Write_PrimitiveArray<BufferEndian, DataType>(a_buffer, a_data, a_count);
+	}
+
+	template <
+		Endian BufferEndian,
+		typename DataType
+	> inline size_t Write_BulkArray(BufferList& a_buffer,
+									const DataType* a_data,
+									const size_t a_count,
+									std::false_type /*IsDirectSerializableType*/)
+	{
+		return Write_PodArray<DataType>(a_buffer, a_data, a_count);
+	}
+
+	template <
+		Endian BufferEndian,
+		typename DataType
+	> inline size_t Read_BulkArray(BufferList& a_buffer,
+								   DataType* a_data /*Out*/,
+								   const size_t a_count,
+								   std::true_type /*IsDirectSerializableType*/)
+	{
+		return Read_PrimitiveArray<BufferEndian, DataType>(a_buffer, a_data, a_count);
+	}
+
+	template <
+		Endian BufferEndian,
+		typename DataType
+	> inline size_t Read_BulkArray(BufferList& a_buffer,
+								   DataType* a_data /*Out*/,
+								   const size_t a_count,
+								   std::false_type /*IsDirectSerializableType*/)
+	{
+		return Read_PodArray<DataType>(a_buffer, a_data, a_count);
+	}
+
+
+
+	// 개수를 기록한 후 원소 전체를 한번에 복사
 	template <
 		Endian BufferEndian,
 		typename DataType,
@@ -151,7 +337,7 @@ namespace asd
 	> inline size_t Write_PrimitiveVector(BufferList& a_buffer,
 										  const std::vector<DataType, Args...>& a_data)
 	{
-		static_assert(IsDirectSerializableType<DataType>::Value, "invalid type");
+		static_assert(IsBulkSerializableType<DataType>::Value, "invalid type");
 
 		const auto count = a_data.size();
 		if (InvalidCount(count))
@@ -167,9 +353,11 @@ namespace asd
 		if (count == 0)
 			return tran.SetResult(ret1);
 
-		size_t ret2 = Write_PrimitiveArray<BufferEndian, DataType>(a_buffer,
-																   a_data.data(),
-																   a_data.size());
+		typedef std::integral_constant<bool, IsDirectSerializableType<DataType>::Value> Tag;
+		size_t ret2 = Write_BulkArray<BufferEndian, DataType>(a_buffer,
+															  a_data.data(),
+															  a_data.size(),
+															  Tag());
 		if (ret2 == 0)
 			return 0;
 
@@ -184,7 +372,7 @@ namespace asd
 	> inline size_t Read_PrimitiveVector(BufferList& a_buffer,
 										 std::vector<DataType, Args...>& a_data /*Out*/)
 	{
-		static_assert(IsDirectSerializableType<DataType>::Value, "invalid type");
+		static_assert(IsBulkSerializableType<DataType>::Value, "invalid type");
 
 		Transactional<BufOp::Read> tran(a_buffer);
 
@@ -200,11 +388,17 @@ namespace asd
 		if (count == 0)
 			return tran.SetResult(ret1);
 
+		// 데이터 전체가 도착했는지 한번만 검사
+		if (a_buffer.Readable(sizeof(DataType) * count) == false)
+			return 0;
+
 		const auto OrgCount = a_data.size();
 		a_data.resize(OrgCount + count);
-		size_t ret2 = Read_PrimitiveArray<BufferEndian, DataType>(a_buffer,
-																  &a_data[OrgCount],
-																  count);
+		typedef std::integral_constant<bool, IsDirectSerializableType<DataType>::Value> Tag;
+		size_t ret2 = Read_BulkArray<BufferEndian, DataType>(a_buffer,
+															 &a_data[OrgCount],
+															 count,
+															 Tag());
 		if (ret2 == 0) {
 			// rollback
 			a_data.resize(OrgCount);
@@ -283,6 +477,9 @@ namespace asd
 	}																					\
 
 
+	asd_Define_Write_And_Read_PrimitiveType(char);
+	asd_Define_Write_And_Read_PrimitiveType(char16_t);
+	asd_Define_Write_And_Read_PrimitiveType(char32_t);
 	asd_Define_Write_And_Read_PrimitiveType(int8_t);
 	asd_Define_Write_And_Read_PrimitiveType(uint8_t);
 	asd_Define_Write_And_Read_PrimitiveType(int16_t);
@@ -296,20 +493,102 @@ namespace asd
 
 
 
+	// PodType
+	template <typename DataType>
+	inline typename std::enable_if<IsPodSerializableType<DataType>::Value, size_t>::type
+	Write(BufferList& a_buffer,
+		  const DataType* a_data,
+		  const size_t a_count)
+	{
+		return Write_PodArray<DataType>(a_buffer,
+										a_data,
+										a_count);
+	}
+
+
+	template <typename DataType, size_t Count>
+	inline typename std::enable_if<IsPodSerializableType<DataType>::Value, size_t>::type
+	Write(BufferList& a_buffer,
+		  const std::array<DataType, Count>& a_data)
+	{
+		return Write_PodArray<DataType>(a_buffer,
+										a_data.data(),
+										Count);
+	}
+
+
+	template <typename DataType>
+	inline typename std::enable_if<IsPodSerializableType<DataType>::Value, size_t>::type
+	Read(BufferList& a_buffer,
+		 DataType* a_data /*Out*/,
+		 const size_t a_count)
+	{
+		return Read_PodArray<DataType>(a_buffer,
+									   a_data,
+									   a_count);
+	}
+
+
+	template <typename DataType, size_t Count>
+	inline typename std::enable_if<IsPodSerializableType<DataType>::Value, size_t>::type
+	Read(BufferList& a_buffer,
+		 std::array<DataType, Count>& a_data /*Out*/)
+	{
+		return Read_PodArray<DataType>(a_buffer,
+									   a_data.data(),
+									   Count);
+	}
+
+
+
 	// Default
+	template <typename CustomSerializableType>
+	inline size_t Write_Custom(BufferList& a_buffer,
+							   const CustomSerializableType& a_data,
+							   std::true_type /*IsPodSerializableType*/)
+	{
+		return Write_PodArray<CustomSerializableType>(a_buffer, &a_data, 1);
+	}
+
+	template <typename CustomSerializableType>
+	inline size_t Write_Custom(BufferList& a_buffer,
+							   const CustomSerializableType& a_data,
+							   std::false_type /*IsPodSerializableType*/)
+	{
+		return a_data.WriteTo(a_buffer);
+	}
+
 	template <typename CustomSerializableType>
 	inline size_t Write(BufferList& a_buffer,
 						const CustomSerializableType& a_data)
 	{
-		return a_data.WriteTo(a_buffer);
+		typedef std::integral_constant<bool, IsPodSerializableType<CustomSerializableType>::Value> Tag;
+		return Write_Custom(a_buffer, a_data, Tag());
+	}
+
+
+	template <typename CustomSerializableType>
+	inline size_t Read_Custom(BufferList& a_buffer,
+							  CustomSerializableType& a_data /*Out*/,
+							  std::true_type /*IsPodSerializableType*/)
+	{
+		return Read_PodArray<CustomSerializableType>(a_buffer, &a_data, 1);
 	}
 
+	template <typename CustomSerializableType>
+	inline size_t Read_Custom(BufferList& a_buffer,
+							  CustomSerializableType& a_data /*Out*/,
+							  std::false_type /*IsPodSerializableType*/)
+	{
+		return a_data.ReadFrom(a_buffer);
+	}
 
 	template <typename CustomSerializableType>
 	inline size_t Read(BufferList& a_buffer,
 					   CustomSerializableType& a_data /*Out*/)
 	{
-		return a_data.ReadFrom(a_buffer);
+		typedef std::integral_constant<bool, IsPodSerializableType<CustomSerializableType>::Value> Tag;
+		return Read_Custom(a_buffer, a_data, Tag());
 	}
 
 
@@ -495,7 +774,45 @@ namespace asd
 	inline size_t Read(BufferList& a_buffer,									\
 					   Container<Args...>& a_data /*Out*/)						\
 
-	asd_Define_Write_And_Read_StdContainer(std::vector)
+	// vector : POD 원소는 한번에 복사, 나머지는 원소 단위로 처리
+	template <typename DataType, typename... Args>
+	inline size_t Write_Vector(BufferList& a_buffer,
+							   const std::vector<DataType, Args...>& a_data,
+							   std::true_type /*IsPodSerializableType*/)
+	{
+		return Write_PrimitiveVector<asd_Default_Endian, DataType, Args...>(a_buffer,
+																			a_data);
+	}
+
+	template <typename DataType, typename... Args>
+	inline size_t Write_Vector(BufferList& a_buffer,
+							   const std::vector<DataType, Args...>& a_data,
+							   std::false_type /*IsPodSerializableType*/)
+	{
+		return Write_StdContainer(a_buffer, a_data);
+	}
+
+	template <typename DataType, typename... Args>
+	inline size_t Write(BufferList& a_buffer,
+						const std::vector<DataType, Args...>& a_data)
+	{
+		typedef std::integral_constant<bool, IsPodSerializableType<DataType>::Value> Tag;
+		return Write_Vector(a_buffer, a_data, Tag());
+	}
+
+	template <typename DataType, typename... Args>
+	inline size_t Read_Vector(BufferList& a_buffer,
+							  std::vector<DataType, Args...>& a_data /*Out*/,
+							  std::true_type /*IsPodSerializableType*/)
+	{
+		return Read_PrimitiveVector<asd_Default_Endian, DataType, Args...>(a_buffer,
+																		   a_data);
+	}
+
+	template <typename DataType, typename... Args>
+	inline size_t Read_Vector(BufferList& a_buffer,
+							  std::vector<DataType, Args...>& a_data /*Out*/,
+							  std::false_type /*IsPodSerializableType*/)
 	{
 		Transactional<BufOp::Read> tran(a_buffer);
 
@@ -525,6 +842,14 @@ namespace asd
 		return tran.SetResult(ret);
 	}
 
+	template <typename DataType, typename... Args>
+	inline size_t Read(BufferList& a_buffer,
+					   std::vector<DataType, Args...>& a_data /*Out*/)
+	{
+		typedef std::integral_constant<bool, IsPodSerializableType<DataType>::Value> Tag;
+		return Read_Vector(a_buffer, a_data, Tag());
+	}
+
 	asd_Define_Write_And_Read_StdContainer(std::list)
 	{
 		Transactional<BufOp::Read> tran(a_buffer);
@@ -786,7 +1111,1237 @@ namespace asd
 #endif
 
 
-	// TODO string
+	// 가변길이 정수 (LEB128)
+	// 작은 값일수록 적은 바이트를 사용하며, 부호있는 타입은 zigzag로 변환하여 작은 음수도 짧게 인코딩한다.
+	#define asd_Varint_MaxBytes		10
 
-}
+	template <typename T>
+	struct IsVarintType
+	{
+		static constexpr bool Value = std::is_integral<T>::value && !std::is_same<T, bool>::value;
+	};
+
+
+	inline uint64_t ZigzagEncode(int64_t a_value)
+	{
+		return ((uint64_t)a_value << 1) ^ (uint64_t)(a_value >> 63);
+	}
+
+
+	inline int64_t ZigzagDecode(uint64_t a_value)
+	{
+		return (int64_t)(a_value >> 1) ^ -(int64_t)(a_value & 1);
+	}
+
+
+	// a_dst에 인코딩하고 사용한 바이트 수를 리턴
+	inline size_t EncodeVarint(uint64_t a_value,
+							   uint8_t (&a_dst)[asd_Varint_MaxBytes] /*Out*/)
+	{
+		size_t i = 0;
+		while (a_value >= 0x80) {
+			a_dst[i++] = (uint8_t)(a_value | 0x80);
+			a_value >>= 7;
+		}
+		a_dst[i++] = (uint8_t)a_value;
+		return i;
+	}
+
+
+	// a_src에서 디코딩하고 사용한 바이트 수를 리턴
+	// 데이터가 부족하거나 잘못된 경우 0
+	inline size_t DecodeVarint(const uint8_t* a_src,
+							   size_t a_bytes,
+							   uint64_t& a_value /*Out*/)
+	{
+		const size_t limit = min(a_bytes, (size_t)asd_Varint_MaxBytes);
+		uint64_t v = 0;
+		for (size_t i=0; i<limit; ++i) {
+			const uint64_t b = a_src[i];
+			v |= (b & 0x7F) << (7 * i);
+			if ((b & 0x80) == 0) {
+				if (i == asd_Varint_MaxBytes-1 && b > 1)
+					return 0; // overflow
+				a_value = v;
+				return i + 1;
+			}
+		}
+		return 0;
+	}
+
+
+	template <typename T>
+	inline size_t VarintSize(T a_data)
+	{
+		static_assert(IsVarintType<T>::Value, "invalid type");
+
+		uint64_t v = std::is_signed<T>::value
+			? ZigzagEncode((int64_t)a_data)
+			: (uint64_t)a_data;
+		size_t ret = 1;
+		for (; v >= 0x80; v >>= 7)
+			++ret;
+		return ret;
+	}
+
+
+	template <typename T>
+	inline size_t WriteVarint(BufferList& a_buffer,
+							  T a_data)
+	{
+		static_assert(IsVarintType<T>::Value, "invalid type");
+
+		uint8_t buf[asd_Varint_MaxBytes];
+		const uint64_t v = std::is_signed<T>::value
+			? ZigzagEncode((int64_t)a_data)
+			: (uint64_t)a_data;
+		return a_buffer.Write(buf, EncodeVarint(v, buf));
+	}
+
+
+	// 크기 확인 없이 a_dst에 바로 쓴다.
+	template <typename T>
+	inline void PackVarint(uint8_t*& a_dst /*Out*/,
+						   T a_data)
+	{
+		static_assert(IsVarintType<T>::Value, "invalid type");
+
+		uint8_t buf[asd_Varint_MaxBytes];
+		const uint64_t v = std::is_signed<T>::value
+			? ZigzagEncode((int64_t)a_data)
+			: (uint64_t)a_data;
+		const size_t bytes = EncodeVarint(v, buf);
+		std::memcpy(a_dst, buf, bytes);
+		a_dst += bytes;
+	}
+
+
+	template <typename T>
+	inline size_t ReadVarint(BufferList& a_buffer,
+							 T& a_data /*Out*/)
+	{
+		static_assert(IsVarintType<T>::Value, "invalid type");
+
+		uint64_t v = 0;
+		size_t ret;
+		const Span span = a_buffer.PeekContiguous();
+		if (span.Size >= asd_Varint_MaxBytes || (span.Size > 0 && (span.Data[span.Size-1] & 0x80) == 0)) {
+			// 현재 버퍼 안에서 끝나므로 버퍼 메모리에서 바로 디코딩
+			ret = DecodeVarint(span.Data, span.Size, v);
+		}
+		else {
+			// 버퍼 경계에 걸친 경우 바이트를 모아서 디코딩
+			uint8_t buf[asd_Varint_MaxBytes];
+			size_t n = 0;
+			{
+				Transactional<BufOp::Read> tran(a_buffer); // 읽기 오프셋은 롤백된다.
+				while (n < asd_Varint_MaxBytes && a_buffer.Read(&buf[n], 1) == 1) {
+					if ((buf[n++] & 0x80) == 0)
+						break;
+				}
+			}
+			ret = DecodeVarint(buf, n, v);
+		}
+		if (ret == 0)
+			return 0;
+
+		T data;
+		if (std::is_signed<T>::value) {
+			const int64_t sv = ZigzagDecode(v);
+			data = (T)sv;
+			if ((int64_t)data != sv)
+				return 0; // overflow
+		}
+		else {
+			data = (T)v;
+			if ((uint64_t)data != v)
+				return 0; // overflow
+		}
+
+		a_buffer.Advance(ret);
+		a_data = data;
+		return ret;
+	}
+
+
+
+	template <typename DataType>
+	inline size_t SerializedSize(const DataType& a_data);
+
+	template <typename T, typename = void>
+	struct SerializedSizeOf;
+
+
+
+	// 가변길이 인코딩 래퍼
+	// 정수는 varint로, 컨테이너는 원소 수를 varint로 기록한다.
+	//   Write(buffer, Compact(id));
+	//   Read(buffer, Compact(id));
+	template <typename T>
+	class CompactRef
+	{
+	public:
+		inline CompactRef(T& a_ref)
+			: m_ref(a_ref)
+		{
+		}
+
+		inline size_t WriteTo(BufferList& a_buffer) const
+		{
+			return WriteTo(a_buffer, IsVarintTag());
+		}
+
+		inline size_t ReadFrom(BufferList& a_buffer)
+		{
+			static_assert(std::is_const<T>::value == false, "can not read to const type");
+			return ReadFrom(a_buffer, IsVarintTag());
+		}
+
+		inline size_t SerializedSize() const
+		{
+			return SerializedSize(IsVarintTag());
+		}
+
+	private:
+		template <typename U, bool = IsVarintType<U>::Value>
+		struct IsPackable
+		{
+			static constexpr bool Value = true;
+		};
+
+		template <typename U>
+		struct IsPackable<U, false>
+		{
+			static constexpr bool Value = SerializedSizeOf<typename std::remove_const<typename U::value_type>::type>::IsPackable;
+		};
+
+	public:
+		template <typename U = typename std::remove_const<T>::type>
+		inline typename std::enable_if<IsPackable<U>::Value, bool>::type PackTo(uint8_t*& a_dst /*Out*/) const
+		{
+			return PackTo(a_dst, IsVarintTag());
+		}
+
+	private:
+		typedef typename std::remove_const<T>::type Type;
+		typedef std::integral_constant<bool, IsVarintType<Type>::Value> IsVarintTag;
+
+		T& m_ref;
+
+		// 정수
+		inline size_t WriteTo(BufferList& a_buffer, std::true_type) const
+		{
+			return WriteVarint(a_buffer, m_ref);
+		}
+
+		inline size_t ReadFrom(BufferList& a_buffer, std::true_type)
+		{
+			return ReadVarint(a_buffer, m_ref);
+		}
+
+		inline size_t SerializedSize(std::true_type) const
+		{
+			return VarintSize(m_ref);
+		}
+
+		inline bool PackTo(uint8_t*& a_dst, std::true_type) const
+		{
+			PackVarint(a_dst, m_ref);
+			return true;
+		}
+
+		// 컨테이너
+		size_t WriteTo(BufferList& a_buffer, std::false_type) const
+		{
+			const auto count = m_ref.size();
+			if (InvalidCount(count))
+				return 0;
+
+			Transactional<BufOp::Write> tran(a_buffer);
+
+			size_t ret = WriteVarint(a_buffer, count);
+			if (ret == 0)
+				return 0;
+
+			for (const auto& elem : m_ref) {
+				size_t r = Write(a_buffer, elem);
+				if (r == 0)
+					return 0;
+				ret += r;
+			}
+			return tran.SetResult(ret);
+		}
+
+		size_t ReadFrom(BufferList& a_buffer, std::false_type)
+		{
+			Transactional<BufOp::Read> tran(a_buffer);
+
+			size_t count;
+			size_t ret = ReadVarint(a_buffer, count);
+			if (ret == 0)
+				return 0;
+
+			// 상대방이 보낸 값이므로 assert 없이 실패로 처리한다. (InvalidCount를 쓰지 않음)
+			// 원소는 최소 1바이트 이상이므로, 남은 데이터로 읽을 수 없는 개수이면 임시 컨테이너를 만들기 전에 거부한다.
+			typedef typename std::remove_const<typename Type::value_type>::type Elem;
+			typedef SerializedSizeOf<Elem> ElemSize;
+			const size_t minElemSize = ElemSize::IsFixed && ElemSize::Value > 0 ? ElemSize::Value : 1;
+			if (count > asd_Default_LimitCount || a_buffer.Readable(count * minElemSize) == false)
+				return 0;
+
+			// 실패 시 a_data가 변하지 않도록 임시 컨테이너에 읽은 후 옮긴다.
+			std::vector<Elem> temp(count);
+			for (auto& elem : temp) {
+				size_t r = Read(a_buffer, elem);
+				if (r == 0)
+					return 0;
+				ret += r;
+			}
+			for (auto& elem : temp)
+				m_ref.insert(m_ref.end(), std::move(elem));
+			return tran.SetResult(ret);
+		}
+
+		size_t SerializedSize(std::false_type) const
+		{
+			size_t ret = VarintSize(m_ref.size());
+			for (const auto& elem : m_ref)
+				ret += asd::SerializedSize(elem);
+			return ret;
+		}
+
+		bool PackTo(uint8_t*& a_dst, std::false_type) const
+		{
+			typedef SerializedSizeOf<typename std::remove_const<typename Type::value_type>::type> ElemSize;
+
+			const auto count = m_ref.size();
+			if (InvalidCount(count))
+				return false;
+
+			PackVarint(a_dst, count);
+			for (const auto& elem : m_ref) {
+				if (ElemSize::Pack(a_dst, elem) == false)
+					return false;
+			}
+			return true;
+		}
+	};
+
+
+	template <typename T>
+	inline CompactRef<typename std::remove_reference<T>::type> Compact(T&& a_ref)
+	{
+		return CompactRef<typename std::remove_reference<T>::type>(a_ref);
+	}
 
+
+
+	// string (std::vector<CharType>과 같은 포맷)
+	template <
+		typename CharType,
+		typename... Args
+	> inline size_t Write(BufferList& a_buffer,
+						  const std::basic_string<CharType, Args...>& a_data)
+	{
+		static_assert(IsDirectSerializableType<CharType>::Value, "invalid type");
+
+		const auto count = a_data.size();
+		if (InvalidCount(count))
+			return 0;
+
+		Transactional<BufOp::Write> tran(a_buffer);
+
+		size_t ret1 = Write_PrimitiveType<asd_Default_Endian, DefaultCountType>(a_buffer,
+																				static_cast<DefaultCountType>(count));
+		if (ret1 == 0)
+			return 0;
+
+		if (count == 0)
+			return tran.SetResult(ret1);
+
+		size_t ret2 = Write_PrimitiveArray<asd_Default_Endian, CharType>(a_buffer,
+																		 a_data.data(),
+																		 count);
+		if (ret2 == 0)
+			return 0;
+
+		return tran.SetResult(ret1 + ret2);
+	}
+
+
+	template <
+		typename CharType,
+		typename... Args
+	> inline size_t Read(BufferList& a_buffer,
+						 std::basic_string<CharType, Args...>& a_data /*Out*/)
+	{
+		static_assert(IsDirectSerializableType<CharType>::Value, "invalid type");
+
+		Transactional<BufOp::Read> tran(a_buffer);
+
+		DefaultCountType count;
+		size_t ret1 = Read_PrimitiveType<asd_Default_Endian, DefaultCountType>(a_buffer,
+																			   count);
+		if (ret1 == 0)
+			return 0;
+
+		if (a_buffer.Readable(sizeof(CharType) * count) == false)
+			return 0;
+
+		a_data.resize(count);
+		if (count == 0)
+			return tran.SetResult(ret1);
+
+		size_t ret2 = Read_PrimitiveArray<asd_Default_Endian, CharType>(a_buffer,
+																		&a_data[0],
+																		count);
+		asd_DAssert(ret2 == sizeof(CharType) * count);
+		return tran.SetResult(ret1 + ret2);
+	}
+
+
+
+	// 수신 버퍼를 직접 가리키는 문자열 (복사 없음, null 종료 아님)
+	struct StringView
+	{
+		const char*	Data = nullptr;
+		size_t		Size = 0;
+
+		StringView() = default;
+
+		StringView(const char* a_data,
+				   size_t a_size)
+			: Data(a_data)
+			, Size(a_size)
+		{
+		}
+
+		inline bool Empty() const
+		{
+			return Size == 0;
+		}
+
+		inline std::string ToString() const
+		{
+			return std::string(Data, Size);
+		}
+
+		inline bool operator == (const StringView& a_other) const
+		{
+			return Size == a_other.Size && std::memcmp(Data, a_other.Data, Size) == 0;
+		}
+
+		inline bool operator == (const char* a_str) const
+		{
+			return *this == StringView(a_str, std::strlen(a_str));
+		}
+
+		inline bool operator == (const std::string& a_str) const
+		{
+			return *this == StringView(a_str.data(), a_str.size());
+		}
+
+		template <typename T>
+		inline bool operator != (const T& a_other) const
+		{
+			return !(*this == a_other);
+		}
+	};
+
+
+
+	// 힙 할당 없이 BufferList의 메시지를 파싱하기 위한 뷰
+	//  - Read(Span&), Read(StringView&) 는 std::vector<uint8_t>, std::string 포맷의 데이터를
+	//    복사 없이 수신 버퍼를 직접 가리키는 뷰로 읽는다.
+	//  - 데이터가 여러 버퍼에 걸쳐 있으면 scratch 영역에 복사하며,
+	//    인라인 영역이 부족할 때만 힙을 사용한다.
+	//  - 얻은 뷰는 MessageView가 살아있는 동안에만 유효하다.
+	//    그 동안 BufferList의 Flush, Clear, 소멸은 assert로 검출한다.
+	class MessageView
+	{
+	public:
+		#define asd_MessageView_InlineScratch	256
+
+		explicit MessageView(BufferList& a_buffer)
+			: m_buffer(a_buffer)
+		{
+			++m_buffer.m_viewCount;
+		}
+
+		~MessageView()
+		{
+			asd_DAssert(m_buffer.m_viewCount > 0);
+			--m_buffer.m_viewCount;
+		}
+
+		MessageView(const MessageView&) = delete;
+		MessageView& operator = (const MessageView&) = delete;
+
+		inline BufferList& GetBuffer()
+		{
+			return m_buffer;
+		}
+
+		inline size_t Read(Span& a_view /*Out*/)
+		{
+			return ReadBytes(a_view);
+		}
+
+		inline size_t Read(StringView& a_view /*Out*/)
+		{
+			Span span;
+			size_t ret = ReadBytes(span);
+			if (ret > 0)
+				a_view = StringView(reinterpret_cast<const char*>(span.Data), span.Size);
+			return ret;
+		}
+
+		// 뷰가 아닌 타입은 일반적인 Read와 같다.
+		template <typename DataType>
+		inline size_t Read(DataType& a_data /*Out*/)
+		{
+			return asd::Read(m_buffer, a_data);
+		}
+
+
+	private:
+		size_t ReadBytes(Span& a_view /*Out*/)
+		{
+			Transactional<BufOp::Read> tran(m_buffer);
+
+			DefaultCountType count;
+			size_t ret = asd::Read(m_buffer, count);
+			if (ret == 0)
+				return 0;
+
+			if (m_buffer.Readable(count) == false)
+				return 0;
+
+			if (count == 0) {
+				a_view = Span();
+				return tran.SetResult(ret);
+			}
+
+			const Span contiguous = m_buffer.PeekContiguous();
+			if (contiguous.Size >= count) {
+				a_view = Span(contiguous.Data, count);
+				m_buffer.Advance(count);
+			}
+			else {
+				// 버퍼 경계에 걸쳐 있으므로 복사
+				uint8_t* scratch = AllocScratch(count);
+				m_buffer.Read(scratch, count);
+				a_view = Span(scratch, count);
+			}
+			return tran.SetResult(ret + count);
+		}
+
+		uint8_t* AllocScratch(size_t a_bytes)
+		{
+			if (asd_MessageView_InlineScratch - m_inlineUsed >= a_bytes) {
+				uint8_t* ret = m_inline + m_inlineUsed;
+				m_inlineUsed += a_bytes;
+				return ret;
+			}
+
+			// 이전에 얻은 뷰가 유효해야 하므로 재할당하지 않고 블록을 추가한다.
+			m_heap.emplace_back(new uint8_t[a_bytes]);
+			return m_heap.back().get();
+		}
+
+		BufferList& m_buffer;
+		size_t m_inlineUsed = 0;
+		uint8_t m_inline[asd_MessageView_InlineScratch];
+		std::vector<std::unique_ptr<uint8_t[]>> m_heap;
+	};
+
+
+	template <typename DataType>
+	inline void PackField(uint8_t*& a_dst /*Out*/,
+						  DataType a_data,
+						  std::true_type /*IsDirectSerializableType*/)
+	{
+		if (EndianFree<asd_Default_Endian, DataType>() == false)
+			a_data = Reverse(a_data);
+		std::memcpy(a_dst, &a_data, sizeof(DataType));
+		a_dst += sizeof(DataType);
+	}
+
+	template <typename DataType>
+	inline void PackField(uint8_t*& a_dst /*Out*/,
+						  const DataType& a_data,
+						  std::false_type /*IsDirectSerializableType*/)
+	{
+		asd_DAssert(GetNativeEndian() == asd_Default_Endian);
+		std::memcpy(a_dst, &a_data, sizeof(DataType));
+		a_dst += sizeof(DataType);
+	}
+
+	// 크기 확인 없이 a_dst에 배열 전체를 쓴다.
+	template <typename DataType>
+	inline void PackArray(uint8_t*& a_dst /*Out*/,
+						  const DataType* a_data,
+						  const size_t a_count)
+	{
+		typedef std::integral_constant<bool, IsDirectSerializableType<DataType>::Value> Tag;
+		if (Tag::value == false || EndianFree<asd_Default_Endian, DataType>()) {
+			const size_t bytes = sizeof(DataType) * a_count;
+			std::memcpy(a_dst, a_data, bytes);
+			a_dst += bytes;
+			return;
+		}
+		for (size_t i=0; i<a_count; ++i)
+			PackField(a_dst, a_data[i], Tag());
+	}
+
+
+	// 직렬화 크기 계산
+	// Write()와 같은 구조를 따르며, 값과 무관하게 크기가 정해지는 타입은
+	// IsFixed가 true이고 Value로 컴파일 타임에 크기를 얻을 수 있다.
+	//
+	// 사용자 정의 타입은 size_t SerializedSize() const 멤버를 구현하면 그것을 사용하고,
+	// 구현하지 않았다면 임시 BufferList에 직접 써서 크기를 잰다. (느림)
+	//
+	// IsPackable이 true인 타입은 Pack()으로 Get() 크기의 메모리에 용량 확인 없이 바로 쓸 수 있다. (Serialize()용)
+	// 사용자 정의 타입은 bool PackTo(uint8_t*&) const 멤버를 구현하면 IsPackable이 된다.
+	// (asd_Serialize_Fields는 모든 필드가 IsPackable이면 PackTo를 만들어준다)
+
+
+	template <typename T>
+	struct HasSerializedSizeMember
+	{
+		template <typename U>
+		static auto Test(int) -> decltype(std::declval<const U&>().SerializedSize(), std::true_type());
+
+		template <typename U>
+		static std::false_type Test(...);
+
+		static constexpr bool Value = decltype(Test<T>(0))::value;
+	};
+
+
+	template <typename T>
+	struct HasPackToMember
+	{
+		template <typename U>
+		static auto Test(int) -> decltype(std::declval<const U&>().PackTo(std::declval<uint8_t*&>()), std::true_type());
+
+		template <typename U>
+		static std::false_type Test(...);
+
+		static constexpr bool Value = decltype(Test<T>(0))::value;
+	};
+
+
+	// Default
+	template <typename T, typename>
+	struct SerializedSizeOf
+	{
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Value = 0;
+		static constexpr bool IsPackable = HasPackToMember<T>::Value;
+
+		static inline size_t Get(const T& a_data)
+		{
+			return Get(a_data, std::integral_constant<bool, HasSerializedSizeMember<T>::Value>());
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const T& a_data)
+		{
+			return a_data.PackTo(a_dst);
+		}
+
+	private:
+		static inline size_t Get(const T& a_data, std::true_type)
+		{
+			return a_data.SerializedSize();
+		}
+
+		static inline size_t Get(const T& a_data, std::false_type)
+		{
+			BufferList temp;
+			return Write(temp, a_data);
+		}
+	};
+
+
+	// PrimitiveType, PodType
+	template <typename T>
+	struct SerializedSizeOf<T, typename std::enable_if<IsBulkSerializableType<T>::Value>::type>
+	{
+		static constexpr bool IsFixed = true;
+		static constexpr size_t Value = sizeof(T);
+		static constexpr bool IsPackable = true;
+
+		static inline size_t Get(const T&)
+		{
+			return Value;
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const T& a_data)
+		{
+			PackField(a_dst, a_data, std::integral_constant<bool, IsDirectSerializableType<T>::Value>());
+			return true;
+		}
+	};
+
+
+	// array
+	template <typename T, size_t Count>
+	struct SerializedSizeOf<std::array<T, Count>>
+	{
+		static_assert(IsBulkSerializableType<T>::Value, "invalid type");
+
+		static constexpr bool IsFixed = true;
+		static constexpr size_t Value = sizeof(T) * Count;
+		static constexpr bool IsPackable = true;
+
+		static inline size_t Get(const std::array<T, Count>&)
+		{
+			return Value;
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const std::array<T, Count>& a_data)
+		{
+			PackArray(a_dst, a_data.data(), Count);
+			return true;
+		}
+	};
+
+
+	// pair
+	template <typename First, typename Second>
+	struct SerializedSizeOf<std::pair<First, Second>>
+	{
+		typedef SerializedSizeOf<typename std::remove_const<First>::type> FirstSize;
+		typedef SerializedSizeOf<typename std::remove_const<Second>::type> SecondSize;
+
+		static constexpr bool IsFixed = FirstSize::IsFixed && SecondSize::IsFixed;
+		static constexpr size_t Value = IsFixed ? FirstSize::Value + SecondSize::Value : 0;
+		static constexpr bool IsPackable = FirstSize::IsPackable && SecondSize::IsPackable;
+
+		static inline size_t Get(const std::pair<First, Second>& a_data)
+		{
+			if (IsFixed)
+				return Value;
+			return FirstSize::Get(a_data.first) + SecondSize::Get(a_data.second);
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const std::pair<First, Second>& a_data)
+		{
+			return FirstSize::Pack(a_dst, a_data.first)
+				&& SecondSize::Pack(a_dst, a_data.second);
+		}
+	};
+
+
+	// tuple
+	template <typename... Args>
+	struct SerializedSizeOf_TupleElems;
+
+	template <>
+	struct SerializedSizeOf_TupleElems<>
+	{
+		static constexpr bool IsFixed = true;
+		static constexpr size_t Value = 0;
+		static constexpr bool IsPackable = true;
+	};
+
+	template <typename Head, typename... Tail>
+	struct SerializedSizeOf_TupleElems<Head, Tail...>
+	{
+		static constexpr bool IsFixed = SerializedSizeOf<Head>::IsFixed
+									 && SerializedSizeOf_TupleElems<Tail...>::IsFixed;
+		static constexpr size_t Value = IsFixed
+									  ? SerializedSizeOf<Head>::Value + SerializedSizeOf_TupleElems<Tail...>::Value
+									  : 0;
+		static constexpr bool IsPackable = SerializedSizeOf<Head>::IsPackable
+										&& SerializedSizeOf_TupleElems<Tail...>::IsPackable;
+	};
+
+	template <typename... Args>
+	struct SerializedSizeOf<std::tuple<Args...>>
+	{
+		typedef std::tuple<Args...> Tuple;
+		typedef SerializedSizeOf_TupleElems<Args...> Elems;
+
+		static constexpr bool IsFixed = Elems::IsFixed;
+		static constexpr size_t Value = Elems::Value;
+		static constexpr bool IsPackable = Elems::IsPackable;
+
+		static inline size_t Get(const Tuple& a_data)
+		{
+			if (IsFixed)
+				return Value;
+			return Sum(a_data, gen_seq<sizeof...(Args)>());
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const Tuple& a_data)
+		{
+			return Pack(a_dst, a_data, gen_seq<sizeof...(Args)>());
+		}
+
+	private:
+		template <size_t... Index>
+		static inline size_t Sum(const Tuple& a_data,
+								 seq<Index...>)
+		{
+			size_t ret = 0;
+			const size_t sizes[] = { 0, SerializedSizeOf<Args>::Get(std::get<Index>(a_data))... };
+			for (auto sz : sizes)
+				ret += sz;
+			return ret;
+		}
+
+		template <size_t... Index>
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const Tuple& a_data,
+								seq<Index...>)
+		{
+			bool ok = true;
+			const int expand[] = { 0, (ok = ok && SerializedSizeOf<Args>::Pack(a_dst, std::get<Index>(a_data)), 0)... };
+			(void)expand;
+			return ok;
+		}
+	};
+
+
+	// string
+	template <typename CharType, typename... Args>
+	struct SerializedSizeOf<std::basic_string<CharType, Args...>>
+	{
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Value = 0;
+		static constexpr bool IsPackable = true;
+
+		static inline size_t Get(const std::basic_string<CharType, Args...>& a_data)
+		{
+			return sizeof(DefaultCountType) + sizeof(CharType) * a_data.size();
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const std::basic_string<CharType, Args...>& a_data)
+		{
+			const auto count = a_data.size();
+			if (InvalidCount(count))
+				return false;
+			PackField(a_dst, static_cast<DefaultCountType>(count), std::true_type());
+			PackArray(a_dst, a_data.data(), count);
+			return true;
+		}
+	};
+
+
+	// std container
+	template <typename Container>
+	struct SerializedSizeOf_StdContainer
+	{
+		typedef typename Container::value_type Elem;
+		typedef SerializedSizeOf<typename std::remove_const<Elem>::type> ElemSize;
+
+		static constexpr bool IsFixed = false;
+		static constexpr size_t Value = 0;
+		static constexpr bool IsPackable = ElemSize::IsPackable;
+
+		static inline size_t Get(const Container& a_data)
+		{
+			if (ElemSize::IsFixed)
+				return sizeof(DefaultCountType) + ElemSize::Value * a_data.size();
+
+			size_t ret = sizeof(DefaultCountType);
+			for (const auto& elem : a_data)
+				ret += ElemSize::Get(elem);
+			return ret;
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const Container& a_data)
+		{
+			const auto count = a_data.size();
+			if (InvalidCount(count))
+				return false;
+			PackField(a_dst, static_cast<DefaultCountType>(count), std::true_type());
+			for (const auto& elem : a_data) {
+				if (ElemSize::Pack(a_dst, elem) == false)
+					return false;
+			}
+			return true;
+		}
+	};
+
+	// vector : Primitive/POD 원소는 한번에 복사
+	template <typename T, typename... Args>
+	struct SerializedSizeOf<std::vector<T, Args...>>
+		: public SerializedSizeOf_StdContainer<std::vector<T, Args...>>
+	{
+		typedef std::vector<T, Args...> Container;
+		typedef SerializedSizeOf_StdContainer<Container> BaseType;
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const Container& a_data)
+		{
+			return Pack(a_dst, a_data, std::integral_constant<bool, IsBulkSerializableType<T>::Value>());
+		}
+
+	private:
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const Container& a_data,
+								std::true_type /*IsBulkSerializableType*/)
+		{
+			const auto count = a_data.size();
+			if (InvalidCount(count))
+				return false;
+			PackField(a_dst, static_cast<DefaultCountType>(count), std::true_type());
+			PackArray(a_dst, a_data.data(), count);
+			return true;
+		}
+
+		static inline bool Pack(uint8_t*& a_dst /*Out*/,
+								const Container& a_data,
+								std::false_type /*IsBulkSerializableType*/)
+		{
+			return BaseType::Pack(a_dst, a_data);
+		}
+	};
+
+	template <typename... Args>
+	struct SerializedSizeOf<std::list<Args...>>
+		: public SerializedSizeOf_StdContainer<std::list<Args...>> {};
+
+	template <typename... Args>
+	struct SerializedSizeOf<std::set<Args...>>
+		: public SerializedSizeOf_StdContainer<std::set<Args...>> {};
+
+	template <typename... Args>
+	struct SerializedSizeOf<std::unordered_set<Args...>>
+		: public SerializedSizeOf_StdContainer<std::unordered_set<Args...>> {};
+
+	template <typename... Args>
+	struct SerializedSizeOf<std::map<Args...>>
+		: public SerializedSizeOf_StdContainer<std::map<Args...>> {};
+
+	template <typename... Args>
+	struct SerializedSizeOf<std::unordered_map<Args...>>
+		: public SerializedSizeOf_StdContainer<std::unordered_map<Args...>> {};
+
+
+	template <typename DataType>
+	inline size_t SerializedSize(const DataType& a_data)
+	{
+		return SerializedSizeOf<DataType>::Get(a_data);
+	}
+
+
+	template <typename DataType>
+	inline size_t SerializedSize(const DataType*,
+								 const size_t a_count)
+	{
+		static_assert(IsBulkSerializableType<DataType>::Value, "invalid type");
+		return sizeof(DataType) * a_count;
+	}
+
+
+
+	// SerializedSize() 크기의 버퍼 하나에 직렬화한다.
+	// 미리 정확한 크기를 확보하므로 쓰는 도중 버퍼 추가나 경계에서의 분할 복사가 없다.
+	// SerializedSizeOf<DataType>::IsPackable이면 필드마다 용량을 확인하지 않고 바로 쓴다.
+	// 실패하면 nullptr
+	template <typename DataType>
+	inline Buffer_ptr Serialize_Internal(const DataType& a_data,
+										 const size_t a_bytes,
+										 std::true_type /*IsPackable*/)
+	{
+		Buffer_ptr buf = NewBuffer(a_bytes);
+		uint8_t* const begin = buf->GetBuffer();
+		uint8_t* dst = begin;
+		if (SerializedSizeOf<DataType>::Pack(dst, a_data) == false)
+			return nullptr;
+
+		// 사용자 정의 SerializedSize()/PackTo()가 서로 어긋난 경우
+		const size_t ret = dst - begin;
+		if (ret != a_bytes) {
+			asd_OnErr("SerializedSize mismatch, expected:{}, written:{}", a_bytes, ret);
+			return nullptr;
+		}
+		buf->SetSize(ret);
+		return buf;
+	}
+
+	template <typename DataType>
+	inline Buffer_ptr Serialize_Internal(const DataType& a_data,
+										 const size_t a_bytes,
+										 std::false_type /*IsPackable*/)
+	{
+		BufferList temp;
+		temp.ReserveBuffer(NewBuffer(a_bytes));
+		const size_t ret = Write(temp, a_data);
+		if (ret == 0)
+			return nullptr;
+
+		asd_DAssert(ret == a_bytes);
+		if (temp.end() - temp.begin() == 1)
+			return std::move(temp[0]);
+
+		// 크기 예측이 빗나가 여러 버퍼로 나뉘었으면 하나로 합친다.
+		Buffer_ptr buf = NewBuffer(ret);
+		if (temp.Read(buf->GetBuffer(), ret) != ret)
+			return nullptr;
+		buf->SetSize(ret);
+		return buf;
+	}
+
+	template <typename DataType>
+	inline Buffer_ptr Serialize(const DataType& a_data)
+	{
+		const size_t bytes = SerializedSize(a_data);
+		if (bytes == 0)
+			return nullptr;
+
+		typedef std::integral_constant<bool, SerializedSizeOf<DataType>::IsPackable> Tag;
+		return Serialize_Internal(a_data, bytes, Tag());
+	}
+
+
+	// 구조체 필드 목록 직렬화
+	//   struct Packet
+	//   {
+	//       int32_t id;
+	//       std::vector<uint8_t> data;
+	//       asd_Serialize_Fields(id, data)
+	//   };
+	// 필드마다 Transactional과 크기 확인을 하는 대신
+	// 구조체 단위로 한번에 크기를 확인(확보)하고 롤백 지점도 하나만 둔다.
+	// 모든 필드가 Primitive/POD 타입이면 스택에서 하나로 합친 후 한번에 복사한다.
+#define asd_Serialize_Fields(...)															\
+	inline size_t WriteTo(asd::BufferList& a_buffer) const									\
+	{																						\
+		return asd::WriteFields(a_buffer, __VA_ARGS__);										\
+	}																						\
+																							\
+	inline size_t ReadFrom(asd::BufferList& a_buffer)										\
+	{																						\
+		return asd::ReadFields(a_buffer, __VA_ARGS__);										\
+	}																						\
+																							\
+	inline size_t SerializedSize() const													\
+	{																						\
+		return asd::SerializedSizeFields(__VA_ARGS__);										\
+	}																						\
+																							\
+	template <typename asd_Fields = decltype(std::forward_as_tuple(__VA_ARGS__))>			\
+	inline typename std::enable_if<asd::IsPackableFields<asd_Fields>::Value, bool>::type	\
+	PackTo(uint8_t*& a_dst /*Out*/) const													\
+	{																						\
+		return asd::PackFields(a_dst, __VA_ARGS__);											\
+	}																						\
+
+
+	template <typename... Fields>
+	struct IsBulkFields;
+
+	template <>
+	struct IsBulkFields<>
+	{
+		static constexpr bool Value = true;
+	};
+
+	template <typename Head, typename... Tail>
+	struct IsBulkFields<Head, Tail...>
+	{
+		static constexpr bool Value = IsBulkSerializableType<Head>::Value
+								   && IsBulkFields<Tail...>::Value;
+	};
+
+
+	// 크기가 고정된 필드들의 크기 합 (읽기 전 최소 크기 확인용)
+	template <typename... Fields>
+	struct FixedFieldsSize;
+
+	template <>
+	struct FixedFieldsSize<>
+	{
+		static constexpr size_t Value = 0;
+	};
+
+	template <typename Head, typename... Tail>
+	struct FixedFieldsSize<Head, Tail...>
+	{
+		static constexpr size_t Value = SerializedSizeOf<Head>::Value
+									  + FixedFieldsSize<Tail...>::Value;
+	};
+
+
+	template <typename DataType>
+	inline void UnpackField(const uint8_t*& a_src,
+							DataType& a_data /*Out*/,
+							std::true_type /*IsDirectSerializableType*/)
+	{
+		std::memcpy(&a_data, a_src, sizeof(DataType));
+		if (EndianFree<asd_Default_Endian, DataType>() == false)
+			a_data = Reverse(a_data);
+		a_src += sizeof(DataType);
+	}
+
+	template <typename DataType>
+	inline void UnpackField(const uint8_t*& a_src,
+							DataType& a_data /*Out*/,
+							std::false_type /*IsDirectSerializableType*/)
+	{
+		asd_DAssert(GetNativeEndian() == asd_Default_Endian);
+		std::memcpy(&a_data, a_src, sizeof(DataType));
+		a_src += sizeof(DataType);
+	}
+
+
+	template <typename DataType>
+	inline bool WriteField(BufferList& a_buffer,
+						   const DataType& a_data,
+						   size_t& a_sum /*Out*/)
+	{
+		const size_t ret = Write(a_buffer, a_data);
+		a_sum += ret;
+		return ret > 0;
+	}
+
+	template <typename DataType>
+	inline bool ReadField(BufferList& a_buffer,
+						  DataType& a_data /*Out*/,
+						  size_t& a_sum /*Out*/)
+	{
+		const size_t ret = Read(a_buffer, a_data);
+		a_sum += ret;
+		return ret > 0;
+	}
+
+
+	template <typename... Fields>
+	inline size_t SerializedSizeFields(const Fields&... a_fields)
+	{
+		size_t sum = 0;
+		const int expand[] = { 0, (sum += SerializedSize(a_fields), 0)... };
+		(void)expand;
+		return sum;
+	}
+
+
+	// 크기 확인 없이 a_dst에 모든 필드를 쓴다. (Serialize()용)
+	template <typename... Fields>
+	inline bool PackFields(uint8_t*& a_dst /*Out*/,
+						   const Fields&... a_fields)
+	{
+		bool ok = true;
+		const int expand[] = { 0, (ok = ok && SerializedSizeOf<Fields>::Pack(a_dst, a_fields), 0)... };
+		(void)expand;
+		return ok;
+	}
+
+
+	template <typename FieldsTuple>
+	struct IsPackableFields;
+
+	template <typename... Fields>
+	struct IsPackableFields<std::tuple<Fields...>>
+	{
+		static constexpr bool Value = SerializedSizeOf_TupleElems<typename std::decay<Fields>::type...>::IsPackable;
+	};
+
+
+	// 모든 필드가 Primitive/POD
+	template <typename... Fields>
+	inline size_t WriteFields_Internal(BufferList& a_buffer,
+									   std::true_type /*IsBulkFields*/,
+									   const Fields&... a_fields)
+	{
+		const size_t Bytes = SerializedSizeOf_TupleElems<Fields...>::Value;
+		uint8_t temp[Bytes];
+		uint8_t* dst = temp;
+		const int expand[] = { 0, (PackField(dst, a_fields, std::integral_constant<bool, IsDirectSerializableType<Fields>::Value>()), 0)... };
+		(void)expand;
+		asd_DAssert(dst == temp + Bytes);
+		return a_buffer.Write(temp, Bytes);
+	}
+
+	template <typename... Fields>
+	inline size_t WriteFields_Internal(BufferList& a_buffer,
+									   std::false_type /*IsBulkFields*/,
+									   const Fields&... a_fields)
+	{
+		a_buffer.ReserveBuffer(SerializedSizeFields(a_fields...));
+
+		Transactional<BufOp::Write> tran(a_buffer);
+		size_t sum = 0;
+		bool ok = true;
+		const int expand[] = { 0, (ok = ok && WriteField(a_buffer, a_fields, sum), 0)... };
+		(void)expand;
+		if (ok == false)
+			return 0;
+		return tran.SetResult(sum);
+	}
+
+	template <typename... Fields>
+	inline size_t ReadFields_Internal(BufferList& a_buffer,
+									  std::true_type /*IsBulkFields*/,
+									  Fields&... a_fields)
+	{
+		const size_t Bytes = SerializedSizeOf_TupleElems<Fields...>::Value;
+		if (a_buffer.Readable(Bytes) == false)
+			return 0;
+
+		// 연속된 구간이면 버퍼에서 바로 읽는다.
+		uint8_t temp[Bytes];
+		const Span contiguous = a_buffer.PeekContiguous();
+		const uint8_t* src;
+		if (contiguous.Size >= Bytes) {
+			src = contiguous.Data;
+			a_buffer.Advance(Bytes);
+		}
+		else {
+			a_buffer.Read(temp, Bytes);
+			src = temp;
+		}
+		const int expand[] = { 0, (UnpackField(src, a_fields, std::integral_constant<bool, IsDirectSerializableType<Fields>::Value>()), 0)... };
+		(void)expand;
+		return Bytes;
+	}
+
+	template <typename... Fields>
+	inline size_t ReadFields_Internal(BufferList& a_buffer,
+									  std::false_type /*IsBulkFields*/,
+									  Fields&... a_fields)
+	{
+		if (a_buffer.Readable(FixedFieldsSize<Fields...>::Value) == false)
+			return 0;
+
+		Transactional<BufOp::Read> tran(a_buffer);
+		size_t sum = 0;
+		bool ok = true;
+		const int expand[] = { 0, (ok = ok && ReadField(a_buffer, a_fields, sum), 0)... };
+		(void)expand;
+		if (ok == false)
+			return 0;
+		return tran.SetResult(sum);
+	}
+
+
+	template <typename... Fields>
+	inline size_t WriteFields(BufferList& a_buffer,
+							  const Fields&... a_fields)
+	{
+		typedef std::integral_constant<bool, IsBulkFields<Fields...>::Value> Tag;
+		return WriteFields_Internal(a_buffer, Tag(), a_fields...);
+	}
+
+	template <typename... Fields>
+	inline size_t ReadFields(BufferList& a_buffer,
+							 Fields&... a_fields /*Out*/)
+	{
+		typedef std::integral_constant<bool, IsBulkFields<Fields...>::Value> Tag;
+		return ReadFields_Internal(a_buffer, Tag(), a_fields...);
+	}
+
+}
@@ -198,6 +198,10 @@ namespace asd
 		Error SetSockOpt_ReuseAddr(bool a_set);
 		Error GetSockOpt_ReuseAddr(bool& a_result /*Out*/) const;
 
+		// 여러 소켓이 같은 주소에 bind하여 커널이 연결을 분산하도록 한다. (Windows 미지원)
+		Error SetSockOpt_ReusePort(bool a_set);
+		Error GetSockOpt_ReusePort(bool& a_result /*Out*/) const;
+
 		Error SetSockOpt_UseNagle(bool a_set);
 		Error GetSockOpt_UseNagle(bool& a_result /*Out*/) const;
 
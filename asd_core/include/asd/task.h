@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "asdbase.h"
 #include "objpool.h"
+#include "classutil.h"
 
 
 namespace asd
@@ -19,6 +20,11 @@ namespace asd
 		// 실행 (1회만 실행하는 것을 보장)
 		void Execute();
 
+	protected:
+		// 실행이 끝난 task를 다시 큐잉할 수 있도록 되돌린다.
+		// 같은 task 객체를 반복해서 큐잉하는 경우에 사용
+		void Rearm();
+
 	private:
 		virtual void OnExecute() = 0;
 		std::atomic_bool m_cancel;
@@ -42,15 +48,6 @@ namespace asd
 		Func m_func;
 		Params m_params;
 
-		template<size_t... Remains>
-		struct seq {};
-
-		template <size_t N, size_t... Remains>
-		struct gen_seq : gen_seq<N-1, N-1, Remains...> {};
-
-		template <size_t... Remains>
-		struct gen_seq<0, Remains...> : seq <Remains...> {};
-
 		template <size_t... Is>
 		inline void Call(seq<Is...>)
 		{
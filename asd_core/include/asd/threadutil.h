@@ -9,10 +9,32 @@ namespace asd
 
 	uint32_t GetCurrentThreadSequence();
 
+	// 현재 쓰레드가 실행중인 CPU 번호
+	// OS에서 조회할 수 없는 경우 GetCurrentThreadSequence()로 대체된다.
+	uint32_t GetCurrentCpuIndex();
+
 	uint32_t Get_HW_Concurrency();
 
 	size_t GetAliveThreadCount();
 
 	void KillThread(uint32_t a_threadSequence);
 
+
+	// 샤드를 선택하는 기준
+	enum class ShardPolicy : uint8_t
+	{
+		ThreadSequence,	// 쓰레드 순번, 쓰레드 수가 샤드 수보다 많으면 무관한 쓰레드끼리 충돌할 수 있음
+		CurrentCpu,		// 실행중인 CPU 번호, 경합이 실제로 동시에 실행중인 코어 수를 따라간다.
+	};
+
+	inline uint32_t GetShardSeed(ShardPolicy a_policy)
+	{
+		switch (a_policy) {
+			case ShardPolicy::CurrentCpu:
+				return GetCurrentCpuIndex();
+			default:
+				return GetCurrentThreadSequence();
+		}
+	}
+
 }
\ No newline at end of file
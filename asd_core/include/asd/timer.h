@@ -66,9 +66,16 @@ namespace asd
 
 		void PollLoop();
 
+		using TaskList = std::map<
+			TimePoint,
+			std::deque<Task_ptr>,
+			std::less<TimePoint>,
+			PoolAllocator<std::pair<const TimePoint, std::deque<Task_ptr>>>
+		>;
+
 		Mutex m_lock;
 		bool m_run = true;
-		std::map<TimePoint, std::deque<Task_ptr>> m_taskList;
+		TaskList m_taskList;
 		TimePoint m_offset;
 		std::thread m_thread;
 	};
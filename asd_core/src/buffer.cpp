@@ -1,11 +1,41 @@
 ﻿#include "stdafx.h"
 #include "asd/buffer.h"
+#include <utility>
 
 namespace asd
 {
+	constexpr size_t BufferSizeClass::MinSize;
+	constexpr size_t BufferSizeClass::MaxSize;
+	constexpr size_t BufferSizeClass::Count;
+
+
+	typedef Buffer_ptr(*NewBufferFunction)();
+	typedef std::array<NewBufferFunction, BufferSizeClass::Count> NewBufferTable;
+
+	template <size_t... Index>
+	inline NewBufferTable MakeNewBufferTable(seq<Index...>)
+	{
+		return NewBufferTable{{ &NewBuffer<BufferSizeClass::GetSize(Index)>... }};
+	}
+
+
+	Buffer_ptr NewBuffer(size_t a_bytes)
+	{
+		static const NewBufferTable s_table = MakeNewBufferTable(gen_seq<BufferSizeClass::Count>());
+
+		const size_t index = BufferSizeClass::GetIndex(a_bytes);
+		if (index < BufferSizeClass::Count)
+			return s_table[index]();
+
+		// size class 범위를 넘어서는 경우 풀링하지 않는다.
+		return Buffer_ptr(new HeapBuffer(a_bytes));
+	}
+
+
+
 	BufferList_ptr BufferList::New()
 	{
-		typedef ObjectPool2<BufferList, true> BufferListPool; // deque의 capacity를 보존하기 위해 소멸자 호출을 하지 않는다.
+		typedef ObjectPool2<BufferList, true> BufferListPool; // 큐의 capacity를 보존하기 위해 소멸자 호출을 하지 않는다.
 		static ObjectPoolShardSet<BufferListPool> g_bufferListPool;
 
 		auto newList = g_bufferListPool.Alloc();
@@ -27,18 +57,17 @@ namespace asd
 
 	BufferList::~BufferList()
 	{
+		asd_DAssert(m_viewCount == 0);
 	}
 
 
 	void BufferList::Clear()
 	{
+		asd_DAssert(m_viewCount == 0);
 		const size_t CapacityLimit = 1024;
-		if (size() <= CapacityLimit)
-			resize(0);
-		else {
-			std::deque<Buffer_ptr>* _this = this;
-			Reset(*_this);
-		}
+		clear();
+		if (capacity() > CapacityLimit)
+			shrink_to_fit();
 
 		m_readOffset = Offset();
 		m_writeOffset = 0;
@@ -60,8 +89,16 @@ namespace asd
 		asd_DAssert(size() >= m_writeOffset);
 
 		while (m_total_capacity - m_total_write < a_bytes) {
-			m_total_capacity += asd_BufferList_DefaultWriteBufferSize;
-			emplace_back(NewWriteBuffer());
+			// 부족분만큼 할당하되,
+			// 쓰기가 계속되는 경우를 고려하여 현재 총 용량만큼 늘려나간다.
+			const size_t shortage = a_bytes - (m_total_capacity - m_total_write);
+			size_t bytes = max(shortage, min(m_total_capacity, (size_t)asd_BufferList_DefaultWriteBufferSize));
+			bytes = max(bytes, (size_t)asd_BufferList_MinWriteBufferSize);
+			bytes = min(bytes, BufferSizeClass::MaxSize);
+
+			auto newBuf = NewBuffer(bytes);
+			m_total_capacity += newBuf->Capacity();
+			emplace_back(std::move(newBuf));
 		}
 	}
 
@@ -207,6 +244,7 @@ namespace asd
 
 	void BufferList::Flush()
 	{
+		asd_DAssert(m_viewCount == 0);
 		asd_DAssert(size() >= m_readOffset.Row);
 		for (; m_readOffset.Row!=0; --m_readOffset.Row) {
 			const auto sz = at(0)->GetSize();
@@ -317,6 +355,359 @@ namespace asd
 	}
 
 
+	size_t BufferList::PeekSpans(std::vector<Span>& a_spans /*Out*/,
+								 const size_t a_maxBytes /*= std::numeric_limits<size_t>::max()*/) const
+	{
+		a_spans.clear();
+		asd_DAssert(m_total_write >= m_total_read);
+
+		size_t total = 0;
+		size_t col = m_readOffset.Col;
+		const size_t limit = min(a_maxBytes, m_total_write - m_total_read);
+		for (size_t row = m_readOffset.Row; row<size() && total<limit; ++row, col=0) {
+			const BufferInterface* buf = at(row).get();
+			asd_DAssert(buf != nullptr);
+			asd_DAssert(buf->GetSize() >= col);
+
+			const size_t sz = min(buf->GetSize() - col, limit - total);
+			if (sz == 0)
+				continue;
+			a_spans.emplace_back(buf->GetBuffer() + col, sz);
+			total += sz;
+		}
+		return total;
+	}
+
+
+	Span BufferList::PeekContiguous() const
+	{
+		asd_DAssert(m_total_write >= m_total_read);
+		const size_t remain = m_total_write - m_total_read;
+		size_t col = m_readOffset.Col;
+		for (size_t row = m_readOffset.Row; row<size() && remain>0; ++row, col=0) {
+			const BufferInterface* buf = at(row).get();
+			asd_DAssert(buf->GetSize() >= col);
+			const size_t sz = min(buf->GetSize() - col, remain);
+			if (sz > 0)
+				return Span(buf->GetBuffer() + col, sz);
+		}
+		return Span();
+	}
+
+
+	size_t BufferList::Advance(const size_t a_bytes)
+	{
+		if (Readable(a_bytes) == false)
+			return 0;
+
+		for (size_t remain = a_bytes;;) {
+			const size_t sz = at(m_readOffset.Row)->GetSize() - m_readOffset.Col;
+			if (sz >= remain) {
+				m_readOffset.Col += remain;
+				break;
+			}
+			remain -= sz;
+			m_readOffset.Col = 0;
+			++m_readOffset.Row;
+			asd_DAssert(size() > m_readOffset.Row);
+		}
+
+		m_total_read += a_bytes;
+		return a_bytes;
+	}
+
+
+
+	// BufferList::AppendExternal()로 연결된 호출자 소유의 메모리
+	struct ExternalBuffer final
+		: public BufferInterface
+	{
+		Span m_span;
+		std::function<void()> m_releaser;
+
+		virtual uint8_t* GetBuffer() const override
+		{
+			return const_cast<uint8_t*>(m_span.Data);
+		}
+
+		virtual size_t Capacity() const override
+		{
+			return m_span.Size;
+		}
+
+		virtual size_t GetSize() const override
+		{
+			return m_span.Size;
+		}
+
+		virtual bool SetSize(size_t a_bytes) override
+		{
+			return a_bytes == m_span.Size; // 외부 메모리에는 쓰지 않는다.
+		}
+
+		virtual ~ExternalBuffer()
+		{
+			if (m_releaser != nullptr)
+				m_releaser();
+		}
+	};
+
+
+	void BufferList::AppendExternal(const Span& a_span,
+									std::function<void()>&& a_releaser /*= nullptr*/)
+	{
+		typedef ObjectPoolShardSet< ObjectPool2<ExternalBuffer> > PoolType;
+		typedef Global<PoolType> Pool;
+
+		if (a_span.Empty()) {
+			if (a_releaser != nullptr)
+				a_releaser();
+			return;
+		}
+
+		auto buf = Pool::Instance().Alloc();
+		buf->m_span = a_span;
+		buf->m_releaser = std::move(a_releaser);
+		PushBack(Buffer_ptr(buf, [](BufferInterface* a_ptr)
+		{
+			auto cast = static_cast<ExternalBuffer*>(a_ptr);
+			Pool::Instance().Free(cast);
+		}));
+	}
+
+
+
+	// SharedBuffer::NewRef()가 반환하는 참조 객체
+	struct SharedBufferRef final
+		: public BufferInterface
+	{
+		SharedBuffer m_ref;
+
+		virtual uint8_t* GetBuffer() const override
+		{
+			return const_cast<uint8_t*>(m_ref.GetBuffer());
+		}
+
+		virtual size_t Capacity() const override
+		{
+			return m_ref.GetSize();
+		}
+
+		virtual size_t GetSize() const override
+		{
+			return m_ref.GetSize();
+		}
+
+		virtual bool SetSize(size_t /*a_bytes*/) override
+		{
+			return false; // immutable
+		}
+	};
+
+
+	SharedBuffer::SharedBuffer()
+	{
+	}
+
+
+	SharedBuffer::SharedBuffer(Buffer_ptr&& a_buffer)
+	{
+		if (a_buffer == nullptr)
+			return;
+		m_size = a_buffer->GetSize();
+		auto deleter = a_buffer.get_deleter();
+		m_buffer.reset(a_buffer.release(), deleter);
+	}
+
+
+	SharedBuffer::SharedBuffer(BufferList&& a_bufferList)
+	{
+		auto& list = a_bufferList;
+		const size_t total = list.m_total_write - list.m_total_read;
+		if (total == 0) {
+			list.Clear();
+			return;
+		}
+
+		Buffer_ptr buf;
+		const size_t row = list.m_readOffset.Row;
+		if (list.at(row)->GetSize() - list.m_readOffset.Col == total) {
+			// 하나의 버퍼에 모두 들어있으므로 그대로 공유
+			m_offset = list.m_readOffset.Col;
+			buf = std::move(list.at(row));
+		}
+		else {
+			buf = NewBuffer(total);
+			asd_RAssert(list.Read(buf->GetBuffer(), total) == total, "fail Read({})", total);
+			asd_RAssert(buf->SetSize(total), "fail SetSize({})", total);
+		}
+		list.Clear();
+
+		m_size = total;
+		auto deleter = buf.get_deleter();
+		m_buffer.reset(buf.release(), deleter);
+	}
+
+
+	const uint8_t* SharedBuffer::GetBuffer() const
+	{
+		if (m_buffer == nullptr)
+			return nullptr;
+		return m_buffer->GetBuffer() + m_offset;
+	}
+
+
+	size_t SharedBuffer::GetSize() const
+	{
+		return m_size;
+	}
+
+
+	long SharedBuffer::UseCount() const
+	{
+		return m_buffer.use_count();
+	}
+
+
+	SharedBuffer SharedBuffer::Slice(size_t a_offset,
+									 size_t a_bytes) const
+	{
+		SharedBuffer ret;
+		if (a_offset > m_size || a_bytes > m_size - a_offset) {
+			asd_OnErr("out of range, size:{}, offset:{}, bytes:{}", m_size, a_offset, a_bytes);
+			return ret;
+		}
+		ret.m_buffer = m_buffer;
+		ret.m_offset = m_offset + a_offset;
+		ret.m_size = a_bytes;
+		return ret;
+	}
+
+
+	Buffer_ptr SharedBuffer::NewRef() const
+	{
+		typedef ObjectPoolShardSet< ObjectPool2<SharedBufferRef> > PoolType;
+		typedef Global<PoolType> Pool;
+
+		if (m_buffer == nullptr)
+			return nullptr;
+
+		auto ref = Pool::Instance().Alloc();
+		ref->m_ref = *this;
+		return Buffer_ptr(ref, [](BufferInterface* a_ptr)
+		{
+			auto cast = static_cast<SharedBufferRef*>(a_ptr);
+			Pool::Instance().Free(cast);
+		});
+	}
+
+
+
+	RingBuffer::RingBuffer(size_t a_limit /*= asd_RingBuffer_DefaultLimit*/)
+		: m_limit(a_limit)
+	{
+		asd_RAssert(m_limit > 0, "invalid limit");
+	}
+
+
+	Span RingBuffer::Peek() const
+	{
+		if (m_buffer == nullptr)
+			return Span();
+		return Span(m_buffer->GetBuffer() + m_read, m_write - m_read);
+	}
+
+
+	size_t RingBuffer::GetSize() const
+	{
+		return m_write - m_read;
+	}
+
+
+	size_t RingBuffer::Capacity() const
+	{
+		if (m_buffer == nullptr)
+			return 0;
+		return m_buffer->Capacity();
+	}
+
+
+	void RingBuffer::Consume(size_t a_bytes)
+	{
+		asd_RAssert(a_bytes <= GetSize(), "overflow, {} > {}", a_bytes, GetSize());
+		m_read += min(a_bytes, GetSize());
+		if (m_read == m_write)
+			m_read = m_write = 0;
+	}
+
+
+	bool RingBuffer::Reserve(size_t a_bytes)
+	{
+		const size_t size = GetSize();
+		if (size >= m_limit)
+			return false;
+		a_bytes = max(min(a_bytes, m_limit - size), (size_t)1);
+
+		const size_t cap = Capacity();
+		if (cap - m_write >= a_bytes)
+			return true;
+
+		// compaction
+		if (cap - size >= a_bytes) {
+			uint8_t* buf = m_buffer->GetBuffer();
+			std::memmove(buf, buf + m_read, size);
+			m_read = 0;
+			m_write = size;
+			return true;
+		}
+
+		// grow
+		const size_t bytes = min(max(size + a_bytes, cap * 2), m_limit);
+		auto newBuffer = NewBuffer(bytes);
+		if (size > 0)
+			std::memcpy(newBuffer->GetBuffer(), m_buffer->GetBuffer() + m_read, size);
+		m_buffer = std::move(newBuffer);
+		m_read = 0;
+		m_write = size;
+		return true;
+	}
+
+
+	uint8_t* RingBuffer::GetWritePtr()
+	{
+		if (m_buffer == nullptr)
+			return nullptr;
+		return m_buffer->GetBuffer() + m_write;
+	}
+
+
+	size_t RingBuffer::GetWritable() const
+	{
+		return Capacity() - m_write;
+	}
+
+
+	void RingBuffer::Commit(size_t a_bytes)
+	{
+		asd_RAssert(a_bytes <= GetWritable(), "overflow, {} > {}", a_bytes, GetWritable());
+		m_write += min(a_bytes, GetWritable());
+	}
+
+
+	void RingBuffer::Shrink(size_t a_keep /*= 0*/)
+	{
+		if (GetSize() == 0 && Capacity() > a_keep)
+			Clear();
+	}
+
+
+	void RingBuffer::Clear()
+	{
+		m_buffer.reset();
+		m_read = m_write = 0;
+	}
+
+
 
 	template<>
 	Transactional<BufOp::Write>::Transactional(BufferList& a_bufferList)
@@ -356,5 +747,11 @@ namespace asd
 	void Transactional<BufOp::Read>::Rollback()
 	{
 		m_bufferList.m_readOffset = m_rollbackPoint;
+
+		// 읽은 바이트 수도 롤백 지점 기준으로 되돌린다.
+		size_t total_read = m_rollbackPoint.Col;
+		for (size_t i=0; i<m_rollbackPoint.Row; ++i)
+			total_read += m_bufferList[i]->GetSize();
+		m_bufferList.m_total_read = total_read;
 	}
 }
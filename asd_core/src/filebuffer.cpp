@@ -0,0 +1,180 @@
+﻿#include "stdafx.h"
+#include "asd/filebuffer.h"
+
+#if !defined(asd_Platform_Windows)
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#
+#endif
+
+
+namespace asd
+{
+#if defined(asd_Platform_Windows)
+	const FileBuffer::Handle InvalidFileHandle = INVALID_HANDLE_VALUE;
+
+#else
+	const FileBuffer::Handle InvalidFileHandle = -1;
+
+#endif
+
+
+	FileBuffer::FileBuffer()
+		: m_file(InvalidFileHandle)
+	{
+	}
+
+
+	Buffer_ptr FileBuffer::Open(const char* a_path,
+								uint64_t a_offset /*= 0*/,
+								size_t a_bytes /*= 0*/)
+	{
+		std::unique_ptr<FileBuffer> ret(new FileBuffer);
+		uint64_t fileSize;
+
+#if defined(asd_Platform_Windows)
+		ret->m_file = ::CreateFileA(a_path,
+									GENERIC_READ,
+									FILE_SHARE_READ,
+									NULL,
+									OPEN_EXISTING,
+									FILE_ATTRIBUTE_NORMAL,
+									NULL);
+		if (ret->m_file == InvalidFileHandle) {
+			asd_OnErr("fail CreateFileA({}), GetLastError:{}", a_path, ::GetLastError());
+			return nullptr;
+		}
+
+		LARGE_INTEGER li;
+		if (::GetFileSizeEx(ret->m_file, &li) == FALSE) {
+			asd_OnErr("fail GetFileSizeEx({}), GetLastError:{}", a_path, ::GetLastError());
+			return nullptr;
+		}
+		fileSize = (uint64_t)li.QuadPart;
+
+#else
+		ret->m_file = ::open(a_path, O_RDONLY | O_CLOEXEC);
+		if (ret->m_file == InvalidFileHandle) {
+			asd_OnErr("fail open({}), errno:{}", a_path, errno);
+			return nullptr;
+		}
+
+		struct stat st;
+		if (::fstat(ret->m_file, &st) != 0) {
+			asd_OnErr("fail fstat({}), errno:{}", a_path, errno);
+			return nullptr;
+		}
+		fileSize = (uint64_t)st.st_size;
+
+#endif
+		if (a_offset >= fileSize)
+			return nullptr;
+
+		const uint64_t remain = fileSize - a_offset;
+		if (a_bytes == 0 || a_bytes > remain)
+			a_bytes = (size_t)min(remain, (uint64_t)std::numeric_limits<size_t>::max());
+
+		ret->m_offset = a_offset;
+		ret->m_size = a_bytes;
+		return Buffer_ptr(ret.release());
+	}
+
+
+	void FileBuffer::Map() const
+	{
+#if defined(asd_Platform_Windows)
+		SYSTEM_INFO si;
+		::GetSystemInfo(&si);
+		const uint64_t granularity = si.dwAllocationGranularity;
+		const uint64_t begin = m_offset - (m_offset % granularity);
+		const size_t padding = (size_t)(m_offset - begin);
+
+		HANDLE mapping = ::CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) {
+			asd_OnErr("fail CreateFileMappingA, GetLastError:{}", ::GetLastError());
+			return;
+		}
+		void* p = ::MapViewOfFile(mapping,
+								  FILE_MAP_READ,
+								  (DWORD)(begin >> 32),
+								  (DWORD)(begin & 0xFFFFFFFF),
+								  padding + m_size);
+		::CloseHandle(mapping); // view가 매핑을 참조하고 있으므로 닫아도 된다.
+		if (p == NULL) {
+			asd_OnErr("fail MapViewOfFile, GetLastError:{}", ::GetLastError());
+			return;
+		}
+
+#else
+		const uint64_t pageSize = (uint64_t)::sysconf(_SC_PAGESIZE);
+		const uint64_t begin = m_offset - (m_offset % pageSize);
+		const size_t padding = (size_t)(m_offset - begin);
+
+		void* p = ::mmap(nullptr,
+						 padding + m_size,
+						 PROT_READ,
+						 MAP_SHARED,
+						 m_file,
+						 (off_t)begin);
+		if (p == MAP_FAILED) {
+			asd_OnErr("fail mmap, errno:{}", errno);
+			return;
+		}
+
+#endif
+		m_map = p;
+		m_mapPadding = padding;
+	}
+
+
+	uint8_t* FileBuffer::GetBuffer() const
+	{
+		std::call_once(m_mapOnce, [this]() { Map(); });
+		if (m_map == nullptr)
+			return nullptr;
+		return (uint8_t*)m_map + m_mapPadding;
+	}
+
+
+	size_t FileBuffer::Capacity() const
+	{
+		return m_size;
+	}
+
+
+	size_t FileBuffer::GetSize() const
+	{
+		return m_size;
+	}
+
+
+	bool FileBuffer::SetSize(size_t a_bytes)
+	{
+		return a_bytes == m_size; // read only
+	}
+
+
+	const FileBuffer* FileBuffer::GetFile() const
+	{
+		return this;
+	}
+
+
+	FileBuffer::~FileBuffer()
+	{
+#if defined(asd_Platform_Windows)
+		if (m_map != nullptr)
+			::UnmapViewOfFile(m_map);
+		if (m_file != InvalidFileHandle)
+			::CloseHandle(m_file);
+
+#else
+		if (m_map != nullptr)
+			::munmap(m_map, m_mapPadding + m_size);
+		if (m_file != InvalidFileHandle)
+			::close(m_file);
+
+#endif
+	}
+}
@@ -1,10 +1,13 @@
 ﻿#include "stdafx.h"
 #include "asd/ioevent.h"
+#include "asd/filebuffer.h"
 #include "asd/objpool.h"
 #include "asd/trace.h"
+#include "asd/threadpool.h"
 #include <vector>
 #include <unordered_map>
 #include <bitset>
+#include <algorithm>
 
 
 #if defined(asd_Platform_Windows)
@@ -16,11 +19,38 @@
 #	include <sys/types.h>
 #	include <sys/socket.h>
 #	include <sys/uio.h>
+#	include <sys/sendfile.h>
+#	include <netinet/in.h>
 #	include <limits.h>
 #	include <sys/eventfd.h>
+#	include <sys/syscall.h>
+#	include <sys/mman.h>
+#	include <poll.h>
+#	if defined(__has_include)
+#		if __has_include(<linux/io_uring.h>)
+#			include <linux/io_uring.h>
+#			if defined(IORING_FEAT_EXT_ARG) && defined(__NR_io_uring_setup)
+#				define asd_Support_IOUring 1
+#			endif
+#		endif
+#		if __has_include(<linux/errqueue.h>)
+#			include <linux/errqueue.h>
+#			if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#				define asd_Support_ZeroCopy 1
+#			endif
+#		endif
+#	endif
 #
 #endif
 
+#if !defined(asd_Support_IOUring)
+#	define asd_Support_IOUring 0
+#endif
+
+#if !defined(asd_Support_ZeroCopy)
+#	define asd_Support_ZeroCopy 0
+#endif
+
 
 namespace asd
 {
@@ -32,7 +62,7 @@ namespace asd
 
 		// N-Send
 		ObjectPool<WSAOVERLAPPED, NoLock, true> m_sendov_pool = ObjectPool<WSAOVERLAPPED, NoLock, true>(100);
-		std::unordered_map<WSAOVERLAPPED*, std::deque<Buffer_ptr>> m_sendProgress;
+		std::unordered_map<WSAOVERLAPPED*, BufferQueue> m_sendProgress;
 
 		// 1-Recv
 		WSAOVERLAPPED m_recvov;
@@ -78,6 +108,50 @@ namespace asd
 #else
 	class AsyncSocketNative final
 	{
+	public:
+#if asd_Support_IOUring
+		// io_uring에 제출한 요청 하나 (user_data로 이 객체의 주소를 넘긴다)
+		// 완료될 때까지 커널이 소켓의 버퍼를 참조하므로 m_ref로 소켓을 살려둔다.
+		struct UringOp final
+		{
+			AsyncSocket_ptr m_ref;
+			uint8_t m_type = 0;
+		};
+
+		UringOp m_recvOp;			// recv, accept(멀티샷), connect
+		UringOp m_sendOp;			// sendmsg, poll(POLLOUT)
+		UringOp m_signalOp;			// PostSignal
+		bool m_recvPending = false;	// m_recvOp 진행중
+		bool m_sendPending = false;	// m_sendOp 진행중
+
+		msghdr m_sendMsg;
+		std::vector<iovec> m_sendIov;
+
+		// connect 목적지
+		sockaddr_storage m_addr;
+#endif
+
+#if asd_Support_ZeroCopy
+		// IOEventOption::ZeroCopyThreshold
+		// MSG_ZEROCOPY로 보낸 버퍼는 커널이 완료를 알릴 때까지 페이지를 참조하므로 여기서 들고 있는다.
+		struct ZeroCopy
+		{
+			uint32_t	m_id;		// 이 버퍼를 마지막으로 보낸 sendmsg의 순번
+			Buffer_ptr	m_data;
+		};
+
+		enum class ZeroCopyState : uint8_t
+		{
+			Unknown,	// 아직 SO_ZEROCOPY를 설정하지 않음
+			On,
+			Off,		// 지원하지 않거나 커널이 복사로 대체함
+		};
+
+		ZeroCopyState m_zcState = ZeroCopyState::Unknown;
+		std::deque<ZeroCopy> m_zcPending;
+		uint32_t m_zcNextId = 0;		// 다음 MSG_ZEROCOPY sendmsg의 순번 (커널과 같이 성공한 호출만 센다)
+		bool m_zcFrontPinned = false;	// 송신큐의 첫번째 버퍼를 MSG_ZEROCOPY로 일부 보냈음
+#endif
 	};
 
 	std::shared_ptr<AsyncSocketNative> AsyncSocket::InitNative()
@@ -105,6 +179,11 @@ namespace asd
 #elif defined(asd_Platform_Linux) || defined(asd_Platform_Android)
 		int m_error = 0;
 		epoll_event m_epollEvent;
+#if asd_Support_IOUring
+		uint8_t m_uringOp = 0;
+		int m_uringRes = 0;
+		bool m_uringMore = false;	// IORING_CQE_F_MORE, 멀티샷 요청이 계속 유지됨
+#endif
 
 #else
 	#error This platform is not supported.
@@ -114,6 +193,115 @@ namespace asd
 
 
 
+	// IOEventOption::DispatchPool로 유저 콜백을 넘기는 소켓별 큐
+	// IO 쓰레드는 큐에 넣기만 하고, 큐가 비어있었던 경우에만 자기 자신(task)을 PushSeq 한다.
+	// task 한번에 그동안 쌓인 콜백을 모두 처리하며, 큐와 task 객체를 재사용하므로 평상시에는 할당이 없다.
+	class AsyncSocketDispatch final
+		: public Task
+	{
+	public:
+		enum class Type : uint8_t
+		{
+			Recv,
+			RecvFrom,
+			Accept,
+			Close,
+		};
+
+		struct Item
+		{
+			Type			m_type;
+			Socket::Error	m_error = 0;
+			Buffer_ptr		m_data;		// Recv, RecvFrom
+			IpAddress		m_addr;		// RecvFrom
+			AsyncSocket_ptr	m_newSock;	// Accept
+		};
+
+		AsyncSocket* const	m_owner;
+		IOEvent* const		m_event;
+		ThreadPool* const	m_pool;
+		const size_t		m_hash;
+
+		Mutex				m_lock;
+		std::vector<Item>	m_queue;		// IO 쓰레드가 채우는 큐
+		std::vector<Item>	m_running;		// 쓰레드풀에서 처리중인 큐 (m_queue와 교체하며 사용)
+		bool				m_scheduled = false;
+		AsyncSocket_ptr		m_self;			// 처리가 끝날 때까지 소켓을 살려둔다.
+
+
+		AsyncSocketDispatch(AsyncSocket* a_owner,
+							IOEvent* a_event,
+							ThreadPool* a_pool)
+			: m_owner(a_owner)
+			, m_event(a_event)
+			, m_pool(a_pool)
+			, m_hash((size_t)AsyncSocketHandle::GetID(a_owner))
+		{
+		}
+
+
+		void Push(Item&& a_item)
+		{
+			bool alive;
+			{
+				auto lock = GetLock(m_lock);
+				m_queue.emplace_back(std::move(a_item));
+				if (m_scheduled)
+					return;
+				m_scheduled = true;
+				m_self = AsyncSocketHandle::GetHandle(m_owner).GetObj();
+				alive = m_self != nullptr;
+			}
+
+			Rearm();
+			Task_ptr task = m_owner->m_dispatch;
+			asd_DAssert(task.get() == this);
+
+			// 소멸중인 소켓이거나 쓰레드풀이 멈춘 경우 바로 처리
+			if (alive == false || m_pool->PushSeq(m_hash, task) == nullptr)
+				Execute();
+		}
+
+
+		virtual void OnExecute() override
+		{
+			AsyncSocket_ptr self;
+			for (;;) {
+				{
+					auto lock = GetLock(m_lock);
+					if (m_queue.empty()) {
+						m_scheduled = false;
+						self = std::move(m_self);
+						break;
+					}
+					m_queue.swap(m_running);
+				}
+
+				for (auto& item : m_running) {
+					switch (item.m_type) {
+						case Type::Recv:
+							m_event->OnRecv(m_owner, std::move(item.m_data));
+							break;
+						case Type::RecvFrom:
+							m_event->OnRecvFrom(m_owner, item.m_addr, std::move(item.m_data));
+							break;
+						case Type::Accept:
+							m_event->OnAccept(m_owner, std::move(item.m_newSock));
+							break;
+						case Type::Close:
+							m_event->OnClose(m_owner, item.m_error);
+							AsyncSocketHandle::GetHandle(m_owner).Free();
+							break;
+					}
+				}
+				m_running.clear();
+			}
+			// 락을 놓은 뒤 소켓 참조 해제
+		}
+	};
+
+
+
 	class IOEventInternal
 	{
 	public:
@@ -121,13 +309,23 @@ namespace asd
 		std::atomic_bool			m_run;
 		std::vector<std::thread>	m_threads;
 		IOEvent*					m_event;
+		const IOEventOption			m_option;
+		const uint32_t				m_recvMin;		// 정리된 IOEventOption::RecvBufferMin
+		const uint32_t				m_recvMax;		// 정리된 IOEventOption::RecvBufferMax
+		const uint32_t				m_recvInit;		// 정리된 IOEventOption::RecvBufferInit
 
 		IOEventInternal(uint32_t a_threadCount,
-						IOEvent* a_event)
+						IOEvent* a_event,
+						const IOEventOption& a_option)
+			: m_option(a_option)
+			, m_recvMin(max<uint32_t>(a_option.RecvBufferMin, 1))
+			, m_recvMax(max<uint32_t>(a_option.RecvBufferMax, m_recvMin))
+			, m_recvInit(min<uint32_t>(max<uint32_t>(a_option.RecvBufferInit, m_recvMin), m_recvMax))
 		{
 			m_threads.resize(a_threadCount);
 			m_event = a_event;
 			asd_DAssert(m_event != nullptr);
+			asd_DAssert(m_option.PollBatchSize > 0);
 		}
 
 		virtual ~IOEventInternal()
@@ -138,11 +336,11 @@ namespace asd
 		void StartThread()
 		{
 			m_run = true;
-			for (auto& t : m_threads) {
-				t = std::thread([this]()
+			for (uint32_t i=0; i<m_threads.size(); ++i) {
+				m_threads[i] = std::thread([this, i]()
 				{
 					while (m_run)
-						Poll(std::numeric_limits<uint32_t>::max());
+						Poll(std::numeric_limits<uint32_t>::max(), i);
 				});
 			}
 		}
@@ -157,12 +355,26 @@ namespace asd
 			}
 		}
 
-		void Poll(uint32_t a_timeoutMs)
+		// a_threadIndex : 호출한 IO 쓰레드의 인덱스 (IOEventOption::PerThreadPoller 인 경우 사용)
+		void Poll(uint32_t a_timeoutMs,
+				  uint32_t a_threadIndex = 0)
 		{
 			// Wait
-			EventInfo event;
-			if (false == Wait(a_timeoutMs, event))
-				return;
+			thread_local std::vector<EventInfo> t_events;
+			const size_t batch = max<size_t>(m_option.PollBatchSize, 1);
+			if (t_events.size() < batch)
+				t_events.resize(batch);
+
+			const size_t count = WaitBatch(a_timeoutMs, t_events.data(), batch, a_threadIndex);
+			for (size_t i=0; i<count; ++i) {
+				Dispatch(t_events[i]);
+				t_events[i] = EventInfo();	// 소켓 참조 해제
+			}
+		}
+
+		// 이벤트 하나를 처리한다. 소켓별 락은 이벤트 단위로 잡는다.
+		void Dispatch(EventInfo& event)
+		{
 			if (event.m_timeout)
 				return;
 
@@ -182,16 +394,34 @@ namespace asd
 				sock->m_sendSignal = false;
 				switch (sock->m_state) {
 					case AsyncSocket::State::Connected:
-					case AsyncSocket::State::Closing:
-						sock->m_lastError = Send(sock);
-						if (sock->m_lastError != 0)
+					case AsyncSocket::State::Closing: {
+						// UDP는 버린 데이터그램의 에러를 m_lastError에 남기므로 성공(0)으로 덮어쓰지 않는다.
+						auto e = Send(sock);
+						if (e != 0) {
+							sock->m_lastError = e;
 							CloseSocket(sock, true);
+						}
 						break;
+					}
 				}
 			}
+			if (sock->m_sendDrained) {
+				// 그 사이에 다시 높은 수위에 도달했으면 알리지 않는다.
+				sock->m_sendDrained = false;
+				auto sendLock = GetLock(sock->m_sendLock);
+				const bool drained = sock->m_sendBlocked == false;
+				sendLock.unlock();
+				if (drained)
+					m_event->OnSendDrained(sock);
+			}
 			Poll_Finally(sock);
 		}
 
+		virtual IOEventOption::Backend GetBackend() const
+		{
+			return IOEventOption::Backend::Native;
+		}
+
 		virtual bool Register(AsyncSocket* a_sock)
 		{
 			asd_OnErr("not impl");
@@ -211,12 +441,32 @@ namespace asd
 			return false;
 		}
 
+		// 최대 a_maxCount개의 이벤트를 한번에 가져온다. 리턴값은 a_events에 채운 개수
+		// 기본 구현은 Wait()로 하나씩 가져온다.
+		virtual size_t WaitBatch(uint32_t a_timeoutMs,
+								 EventInfo* a_events /*Out*/,
+								 size_t a_maxCount,
+								 uint32_t a_threadIndex)
+		{
+			asd_DAssert(a_maxCount > 0);
+			if (false == Wait(a_timeoutMs, a_events[0]))
+				return 0;
+			return 1;
+		}
+
 		virtual void ProcEvent(EventInfo& a_event)
 		{
 			asd_OnErr("not impl");
 		}
 
-		virtual int Listen(AsyncSocket* a_sock)
+		// bind 하기 전에 호출된다.
+		virtual int PrepareListen(AsyncSocket* a_sock)
+		{
+			return 0;
+		}
+
+		virtual int Listen(AsyncSocket* a_sock,
+						   int a_backlog)
 		{
 			asd_OnErr("not impl");
 			return -1;
@@ -245,6 +495,400 @@ namespace asd
 		{
 			asd_OnErr("not impl");
 		}
+
+		// 소켓의 현재 수신 버퍼 크기로 새 버퍼를 할당한다.
+		Buffer_ptr NewRecvBuffer(AsyncSocket* a_sock) const
+		{
+			if (a_sock->m_recvSize == 0)
+				a_sock->m_recvSize = m_recvInit;
+			return NewBuffer(a_sock->m_recvSize);
+		}
+
+		// 수신한 양에 따라 다음 수신 버퍼 크기를 조절한다.
+		// 가득 채우면 바로 늘리고, 줄이는 것은 두 번 연속으로 작게 받았을 때만 한다.
+		void AdaptRecvSize(AsyncSocket* a_sock,
+						   size_t a_recved,
+						   size_t a_capacity) const
+		{
+			if (a_recved >= a_capacity) {
+				a_sock->m_recvShrink = 0;
+				if (a_sock->m_recvSize < m_recvMax)
+					a_sock->m_recvSize = (uint32_t)min<size_t>((size_t)a_sock->m_recvSize * 2, m_recvMax);
+			}
+			else if (a_recved*2 <= a_capacity && a_sock->m_recvSize > m_recvMin) {
+				if (++a_sock->m_recvShrink >= 2) {
+					a_sock->m_recvShrink = 0;
+					a_sock->m_recvSize = max<uint32_t>(a_sock->m_recvSize / 2, m_recvMin);
+				}
+			}
+			else {
+				a_sock->m_recvShrink = 0;
+			}
+		}
+
+		// 링버퍼에 쌓인 수신 데이터를 유저 콜백으로 전달한다.
+		// 프레임 규칙을 위반하면 a_sock->m_lastError를 셋팅하고 false를 리턴하며, 호출자가 소켓을 닫는다.
+		bool DeliverRing(AsyncSocket* a_sock,
+						 RingBuffer& a_ring)
+		{
+			const FrameOption* opt = a_sock->m_frameOption.get();
+			if (opt == nullptr) {
+				m_event->OnRecvRing(a_sock, a_ring);
+				return true;
+			}
+
+			for (;;) {
+				const Span data = a_ring.Peek();
+				size_t head = 0;	// 본문 앞에 붙는 바이트 수
+				size_t body = 0;	// 본문 바이트 수
+				size_t tail = 0;	// 본문 뒤에 붙는 바이트 수
+
+				if (opt->FrameType == FrameOption::Type::LengthPrefix) {
+					head = opt->PrefixBytes;
+					if (data.Size < head)
+						return true;
+
+					for (size_t i=0; i<head; ++i) {
+						const size_t shift = opt->PrefixEndian == Endian::Little
+										   ? 8 * i
+										   : 8 * (head - 1 - i);
+						body |= (size_t)data.Data[i] << shift;
+					}
+					if (body > opt->MaxFrameSize)
+						return FrameError(a_sock);
+					if (data.Size < head + body)
+						return true;
+				}
+				else {
+					const auto& delim = opt->Delimiter;
+					tail = delim.size();
+
+					// 이미 확인한 구간은 건너뛰되, 구분자가 걸쳐 있을 수 있으므로 그만큼은 다시 본다.
+					const size_t from = a_sock->m_frameScan > tail ? a_sock->m_frameScan - tail + 1 : 0;
+					const uint8_t* end = data.Data + data.Size;
+					const uint8_t* pos = std::search(data.Data + min(from, data.Size),
+													 end,
+													 delim.begin(),
+													 delim.end(),
+													 [](uint8_t a, char b) { return a == (uint8_t)b; });
+					if (pos == end) {
+						a_sock->m_frameScan = data.Size;
+						if (data.Size >= opt->MaxFrameSize + tail)
+							return FrameError(a_sock);
+						return true;
+					}
+					body = pos - data.Data;
+					if (body > opt->MaxFrameSize)
+						return FrameError(a_sock);
+				}
+
+				m_event->OnMessage(a_sock, Span(data.Data + head, body));
+				a_ring.Consume(head + body + tail);
+				a_sock->m_frameScan = 0;
+
+				// 유저 콜백에서 소켓을 닫은 경우
+				if (a_sock->m_state == AsyncSocket::State::Closed)
+					return true;
+			}
+		}
+
+		// 유저 콜백 호출
+		// 소켓에 m_dispatch가 있으면(IOEventOption::DispatchPool) 쓰레드풀로 넘긴다.
+		void CallOnRecv(AsyncSocket* a_sock,
+						Buffer_ptr&& a_data)
+		{
+			if (a_sock->m_dispatch == nullptr) {
+				m_event->OnRecv(a_sock, std::move(a_data));
+				return;
+			}
+			AsyncSocketDispatch::Item item;
+			item.m_type = AsyncSocketDispatch::Type::Recv;
+			item.m_data = std::move(a_data);
+			a_sock->m_dispatch->Push(std::move(item));
+		}
+
+		void CallOnRecvFrom(AsyncSocket* a_sock,
+							IpAddress&& a_src,
+							Buffer_ptr&& a_data)
+		{
+			if (a_sock->m_dispatch == nullptr) {
+				m_event->OnRecvFrom(a_sock, a_src, std::move(a_data));
+				return;
+			}
+			AsyncSocketDispatch::Item item;
+			item.m_type = AsyncSocketDispatch::Type::RecvFrom;
+			item.m_addr = std::move(a_src);
+			item.m_data = std::move(a_data);
+			a_sock->m_dispatch->Push(std::move(item));
+		}
+
+		void CallOnAccept(AsyncSocket* a_listener,
+						  AsyncSocket_ptr&& a_newSock)
+		{
+			if (a_listener->m_dispatch == nullptr) {
+				m_event->OnAccept(a_listener, std::move(a_newSock));
+				return;
+			}
+			AsyncSocketDispatch::Item item;
+			item.m_type = AsyncSocketDispatch::Type::Accept;
+			item.m_newSock = std::move(a_newSock);
+			a_listener->m_dispatch->Push(std::move(item));
+		}
+
+		// 닫힌 소켓의 OnClose를 호출하고 핸들을 해제한다.
+		// 쓰레드풀로 넘기는 경우 앞서 넘긴 콜백들이 모두 처리된 뒤에 호출되며, 핸들도 그 때 해제한다.
+		void NotifyClose(AsyncSocket* a_sock,
+						 bool a_callback = true)
+		{
+			if (a_callback && a_sock->m_dispatch != nullptr) {
+				AsyncSocketDispatch::Item item;
+				item.m_type = AsyncSocketDispatch::Type::Close;
+				item.m_error = a_sock->m_lastError;
+				a_sock->m_dispatch->Push(std::move(item));
+				return;
+			}
+
+			if (a_callback)
+				m_event->OnClose(a_sock, a_sock->m_lastError);
+			auto handle = AsyncSocketHandle::GetHandle(a_sock);
+			handle.Free();
+		}
+
+		// 송신을 마친 바이트 수를 송신 대기량에서 뺀다. m_sendLock을 잡은 상태에서 호출
+		// 낮은 수위 이하로 내려가면 Dispatch()에서 OnSendDrained를 호출하도록 표시한다.
+		static void ReleaseSendBytes(AsyncSocket* a_sock,
+									 size_t a_bytes)
+		{
+			asd_DAssert(a_sock->m_sendBytes >= a_bytes);
+			a_sock->m_sendBytes -= min(a_sock->m_sendBytes, a_bytes);
+			if (a_sock->m_sendBlocked && a_sock->m_sendBytes <= a_sock->m_sendLowWatermark) {
+				a_sock->m_sendBlocked = false;
+				a_sock->m_sendDrained = true;
+			}
+		}
+
+		// 송신한 만큼 송신큐에서 제거한다. m_sendLock을 잡은 상태에서 호출
+		static void PopSent(AsyncSocket* a_sock,
+							size_t a_sent)
+		{
+			ReleaseSendBytes(a_sock, a_sent);
+			auto& queue = a_sock->m_sendQueue;
+			while (queue.empty() == false) {
+				const size_t remain = queue.front()->GetSize() - a_sock->m_sendOffset;
+				if (remain > a_sent) {
+					a_sock->m_sendOffset += a_sent;
+					break;
+				}
+				a_sent -= remain;
+				a_sock->m_sendOffset = 0;
+				queue.pop_front();
+			}
+		}
+
+		// 송신큐에서 이웃한 작은 버퍼들(SendCoalesceSize 미만)을 풀에서 할당한 블록에 모아 담는다.
+		// iovec 슬롯을 아끼고, 작은 조각들이 따로 전송되지 않도록 한다. m_sendLock을 잡은 상태에서 호출
+		void CoalesceSendQueue(AsyncSocket* a_sock) const
+		{
+			const size_t limit = min<size_t>(m_option.SendCoalesceSize, asd_BufferList_DefaultWriteBufferSize);
+			auto& queue = a_sock->m_sendQueue;
+			if (limit == 0 || queue.size() < 2)
+				return;
+
+			auto isSmall = [limit](const Buffer_ptr& a_buf)
+			{
+				return a_buf->GetFile() == nullptr && a_buf->GetSize() < limit;
+			};
+
+			// 일부 송신한 첫번째 버퍼는 건드리지 않는다.
+			const size_t begin = a_sock->m_sendOffset == 0 ? 0 : 1;
+			size_t i = begin + 1;
+			for (; i<queue.size(); ++i) {
+				if (isSmall(queue[i-1]) && isSmall(queue[i]))
+					break;
+			}
+			if (i >= queue.size())
+				return;
+
+			// 앞에서부터 채워나가므로 쓰는 위치(w)는 읽는 위치(i)를 넘지 않는다.
+			Buffer_ptr block;
+			size_t w = 0;
+			for (i=0; i<queue.size(); ++i) {
+				auto& buf = queue[i];
+				if (i < begin || isSmall(buf) == false) {
+					if (block != nullptr)
+						queue[w++] = std::move(block);
+					queue[w++] = std::move(buf);
+					continue;
+				}
+
+				const size_t size = buf->GetSize();
+				if (block != nullptr && block->Capacity() - block->GetSize() < size)
+					queue[w++] = std::move(block);
+				if (block == nullptr) {
+					// 뒤에 합칠 버퍼가 없으면 그대로 둔다.
+					if (i+1 >= queue.size() || isSmall(queue[i+1]) == false) {
+						queue[w++] = std::move(buf);
+						continue;
+					}
+					block = NewBuffer<asd_BufferList_DefaultWriteBufferSize>();
+				}
+				std::memcpy(block->GetBuffer() + block->GetSize(), buf->GetBuffer(), size);
+				asd_RAssert(block->SetSize(block->GetSize() + size), "fail block->SetSize()");
+				++a_sock->m_sendStats.CoalescedBuffers;
+			}
+			if (block != nullptr)
+				queue[w++] = std::move(block);
+			while (queue.size() > w)
+				queue.pop_back();
+		}
+
+#if defined(asd_Platform_Linux) || defined(asd_Platform_Android)
+		// recvmmsg로 최대 DatagramBatchSize개의 데이터그램을 받아 OnRecvFrom으로 전달한다.
+		// 받을 데이터그램이 남아있을 수 있으면(배치를 가득 채움) a_more에 true를 셋팅
+		// 리턴값은 errno (EAGAIN이면 받을 것이 없음)
+		int RecvDatagrams(AsyncSocket* a_sock,
+						  bool& a_more /*Out*/)
+		{
+			// 수신 버퍼는 IO 쓰레드별로 가지고 있다가 받은 슬롯만 새로 채운다.
+			thread_local std::vector<Buffer_ptr> t_bufs;
+			thread_local std::vector<mmsghdr> t_msgs;
+			thread_local std::vector<iovec> t_iovs;
+			thread_local std::vector<sockaddr_storage> t_addrs;
+
+			const size_t batch = max<uint32_t>(m_option.DatagramBatchSize, 1);
+			const size_t bufSize = max<uint32_t>(m_option.DatagramMaxSize, 1);
+			if (t_msgs.size() < batch) {
+				t_bufs.resize(batch);
+				t_msgs.resize(batch);
+				t_iovs.resize(batch);
+				t_addrs.resize(batch);
+			}
+			for (size_t i=0; i<batch; ++i) {
+				auto& buf = t_bufs[i];
+				if (buf == nullptr || buf->Capacity() < bufSize)
+					buf = NewBuffer(bufSize);
+				t_iovs[i].iov_base = buf->GetBuffer();
+				t_iovs[i].iov_len = bufSize;
+
+				msghdr& hdr = t_msgs[i].msg_hdr;
+				std::memset(&hdr, 0, sizeof(hdr));
+				hdr.msg_name = &t_addrs[i];
+				hdr.msg_namelen = sizeof(sockaddr_storage);
+				hdr.msg_iov = &t_iovs[i];
+				hdr.msg_iovlen = 1;
+				t_msgs[i].msg_len = 0;
+			}
+
+			a_more = false;
+			auto r = ::recvmmsg(a_sock->GetNativeHandle(),
+								t_msgs.data(),
+								(unsigned int)batch,
+								MSG_DONTWAIT,
+								nullptr);
+			if (r < 0)
+				return errno;
+			if (r == 0)
+				return EAGAIN;
+
+			a_more = (size_t)r == batch;
+			for (int i=0; i<r; ++i) {
+				const msghdr& hdr = t_msgs[i].msg_hdr;
+				if (hdr.msg_flags & MSG_TRUNC)
+					continue;	// DatagramMaxSize보다 큰 데이터그램은 버린다.
+
+				IpAddress src;
+				switch (t_addrs[i].ss_family) {
+					case AF_INET:
+						src = *(const sockaddr_in*)&t_addrs[i];
+						break;
+					case AF_INET6:
+						src = *(const sockaddr_in6*)&t_addrs[i];
+						break;
+				}
+
+				auto data = std::move(t_bufs[i]);
+				asd_RAssert(data->SetSize(t_msgs[i].msg_len), "fail data->SetSize({})", t_msgs[i].msg_len);
+				CallOnRecvFrom(a_sock, std::move(src), std::move(data));
+				if (a_sock->m_state != AsyncSocket::State::Connected)
+					break;
+			}
+
+			// LazyRecvBuffer 이면 유휴 상태에서 버퍼를 들고 있지 않는다.
+			if (m_option.LazyRecvBuffer && a_more == false) {
+				for (auto& buf : t_bufs)
+					buf.reset();
+			}
+			return 0;
+		}
+
+		// m_sendToQueue의 데이터그램들을 sendmmsg로 보낸다. m_sendLock을 잡은 상태에서 호출
+		// 송신버퍼가 가득 차면 m_sendSignal을 셋팅하고 0을 리턴한다.
+		// 데이터그램 하나의 실패로는 소켓을 닫지 않으며, 그 데이터그램을 버리고 m_lastError에 남긴다.
+		int SendDatagrams(AsyncSocket* a_sock)
+		{
+			thread_local std::vector<mmsghdr> t_msgs;
+			thread_local std::vector<iovec> t_iovs;
+
+			auto& queue = a_sock->m_sendToQueue;
+			const size_t batch = max<uint32_t>(m_option.DatagramBatchSize, 1);
+			if (t_msgs.size() < batch) {
+				t_msgs.resize(batch);
+				t_iovs.resize(batch);
+			}
+
+			while (queue.empty() == false) {
+				const size_t count = min(queue.size(), batch);
+				for (size_t i=0; i<count; ++i) {
+					auto& dgram = queue[i];
+					t_iovs[i].iov_base = dgram.m_data->GetBuffer();
+					t_iovs[i].iov_len = dgram.m_data->GetSize();
+
+					msghdr& hdr = t_msgs[i].msg_hdr;
+					std::memset(&hdr, 0, sizeof(hdr));
+					hdr.msg_name = (void*)(const sockaddr*)dgram.m_dst;
+					hdr.msg_namelen = dgram.m_dst.GetAddrLen();
+					hdr.msg_iov = &t_iovs[i];
+					hdr.msg_iovlen = 1;
+				}
+
+				auto r = ::sendmmsg(a_sock->GetNativeHandle(),
+									t_msgs.data(),
+									(unsigned int)count,
+									MSG_DONTWAIT | MSG_NOSIGNAL);
+				if (r < 0) {
+					auto e = errno;
+					switch (e) {
+						case EINTR: // 인터럽트
+							continue;
+						case EAGAIN: // 송신버퍼 부족
+							a_sock->m_sendSignal = true;
+							return 0;
+						default: // 맨 앞의 데이터그램을 보낼 수 없음
+							a_sock->m_lastError = e;
+							ReleaseSendBytes(a_sock, queue.front().m_data->GetSize());
+							queue.pop_front();
+							continue;
+					}
+				}
+				for (int i=0; i<r; ++i) {
+					ReleaseSendBytes(a_sock, queue.front().m_data->GetSize());
+					queue.pop_front();
+				}
+			}
+			return 0;
+		}
+#endif
+
+		// 상대방이 보낸 잘못된 데이터이므로 assert 없이 OnClose의 에러코드로만 알린다.
+		bool FrameError(AsyncSocket* a_sock)
+		{
+#if defined(asd_Platform_Windows)
+			a_sock->m_lastError = WSAEMSGSIZE;
+#else
+			a_sock->m_lastError = EMSGSIZE;
+#endif
+			return false;
+		}
 	};
 
 
@@ -258,8 +902,9 @@ namespace asd
 
 
 		IOEventInternal_IOCP(uint32_t a_threadCount,
-							 IOEvent* a_event)
-			: IOEventInternal(a_threadCount, a_event)
+							 IOEvent* a_event,
+							 const IOEventOption& a_option)
+			: IOEventInternal(a_threadCount, a_event, a_option)
 		{
 			m_iocp = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE,
 											  NULL,
@@ -285,6 +930,12 @@ namespace asd
 
 		virtual bool Register(AsyncSocket* a_sock) override
 		{
+			if (a_sock->GetSocektType() == Socket::Type::UDP) {
+				asd_OnErr("UDP is not supported on IOCP yet");
+				a_sock->m_lastError = WSAEOPNOTSUPP;
+				return false;
+			}
+
 			if (a_sock->m_native == nullptr) {
 				a_sock->m_lastError = -1;
 				asd_OnErr("empty native data");
@@ -326,14 +977,69 @@ namespace asd
 
 
 
-		int WSARecv(AsyncSocket* a_sock)
+		// 0바이트 수신이 완료된 소켓에서 실제로 읽는다.
+		// 소켓을 닫았으면 false를 리턴
+		bool RecvLazy(AsyncSocket* a_sock)
 		{
-			asd_RAssert(a_sock->m_recvBuffer == nullptr, "unknown logic error");
-			a_sock->m_recvBuffer = NewBuffer<asd_BufferList_DefaultReadBufferSize>();
+			auto data = NewRecvBuffer(a_sock);
+			auto r = ::recv(a_sock->GetNativeHandle(),
+							(char*)data->GetBuffer(),
+							(int)data->Capacity(),
+							0);
+			if (r > 0) {
+				AdaptRecvSize(a_sock, r, data->Capacity());
+				asd_RAssert(data->SetSize(r), "fail data->SetSize({})", r);
+				CallOnRecv(a_sock, std::move(data));
+				return true;
+			}
+			if (r == 0) {
+				// fin
+				CloseSocket(a_sock, true);
+				return false;
+			}
+
+			auto e = ::WSAGetLastError();
+			switch (e) {
+				case WSAEWOULDBLOCK: // 다시 대기
+					return true;
+				case WSAECONNABORTED:
+				case WSAECONNRESET: // 상대방이 끊음 (RST)
+					CloseSocket(a_sock, true);
+					return false;
+				default:
+					asd_OnErr("fail recv, WSAGetLastError:{}", e);
+					a_sock->m_lastError = e;
+					CloseSocket(a_sock);
+					return false;
+			}
+		}
 
+
+
+		int WSARecv(AsyncSocket* a_sock)
+		{
 			WSABUF wsabuf;
-			wsabuf.buf = (CHAR*)a_sock->m_recvBuffer->GetBuffer();
-			wsabuf.len = (ULONG)a_sock->m_recvBuffer->Capacity();
+			RingBuffer* ring = a_sock->m_recvRing.get();
+			if (ring != nullptr) {
+				if (ring->Reserve(asd_BufferList_DefaultReadBufferSize) == false) {
+					asd_OnErr("recv ring buffer is full, limit:{}", ring->GetLimit());
+					return WSAENOBUFS;
+				}
+				wsabuf.buf = (CHAR*)ring->GetWritePtr();
+				wsabuf.len = (ULONG)ring->GetWritable();
+			}
+			else if (m_option.LazyRecvBuffer) {
+				// 0바이트 수신으로 수신 가능 여부만 기다린다.
+				asd_RAssert(a_sock->m_recvBuffer == nullptr, "unknown logic error");
+				wsabuf.buf = nullptr;
+				wsabuf.len = 0;
+			}
+			else {
+				asd_RAssert(a_sock->m_recvBuffer == nullptr, "unknown logic error");
+				a_sock->m_recvBuffer = NewRecvBuffer(a_sock);
+				wsabuf.buf = (CHAR*)a_sock->m_recvBuffer->GetBuffer();
+				wsabuf.len = (ULONG)a_sock->m_recvBuffer->Capacity();
+			}
 
 			DWORD flags = 0;
 
@@ -473,16 +1179,33 @@ namespace asd
 
 					case AsyncSocket::State::Connected:
 					case AsyncSocket::State::Closing:
-						if (a_event.m_transBytes == 0) {
+						if (sock->m_recvRing == nullptr && sock->m_recvBuffer == nullptr) {
+							// 0바이트 수신 완료 (LazyRecvBuffer), 이제 버퍼를 할당해서 읽는다.
+							if (RecvLazy(sock) == false)
+								break;
+						}
+						else if (a_event.m_transBytes == 0) {
 							// fin
 							CloseSocket(sock, true);
 						}
+						else if (sock->m_recvRing != nullptr) {
+							RingBuffer* ring = sock->m_recvRing.get();
+							ring->Commit(a_event.m_transBytes);
+							if (DeliverRing(sock, *ring) == false) {
+								CloseSocket(sock);
+								break;
+							}
+
+							// 유저 콜백 호출 후, 남은 데이터가 없으면 커진 버퍼를 반납
+							ring->Shrink(asd_BufferList_DefaultReadBufferSize);
+						}
 						else {
 							auto recvedData = std::move(sock->m_recvBuffer);
+							AdaptRecvSize(sock, a_event.m_transBytes, recvedData->Capacity());
 							asd_RAssert(recvedData->SetSize(a_event.m_transBytes),
 										"fail recvedData->SetSize({})",
 										a_event.m_transBytes);
-							m_event->OnRecv(sock, std::move(recvedData));
+							CallOnRecv(sock, std::move(recvedData));
 						}
 						break;
 
@@ -491,7 +1214,7 @@ namespace asd
 																 sock->GetSocektType(),
 																 sock->GetAddressFamily());
 						newSock->m_state = AsyncSocket::State::Connected;
-						m_event->OnAccept(sock, std::move(newSock));
+						CallOnAccept(sock, std::move(newSock));
 						break;
 					}
 				}
@@ -517,13 +1240,23 @@ namespace asd
 			}
 
 			// send complete
-			if (sock->m_native->m_sendProgress.erase(a_event.m_overlapped) == 1)
+			auto progress = sock->m_native->m_sendProgress.find(a_event.m_overlapped);
+			if (progress != sock->m_native->m_sendProgress.end()) {
+				size_t bytes = 0;
+				for (auto& buf : progress->second)
+					bytes += buf->GetSize();
+				sock->m_native->m_sendProgress.erase(progress);
 				sock->m_native->m_sendov_pool.Free(a_event.m_overlapped);
+
+				auto sendLock = GetLock(sock->m_sendLock);
+				ReleaseSendBytes(sock, bytes);
+			}
 		}
 
 
 
-		virtual int Listen(AsyncSocket* a_sock) override
+		virtual int Listen(AsyncSocket* a_sock,
+						   int a_backlog) override
 		{
 			if (a_sock->m_native->m_listening) {
 				asd_OnErr("already listenig");
@@ -791,10 +1524,7 @@ namespace asd
 
 			a_sock->Socket::Close();
 			a_sock->m_state = AsyncSocket::State::Closed;
-			m_event->OnClose(a_sock, a_sock->m_lastError);
-
-			auto handle = AsyncSocketHandle::GetHandle(a_sock);
-			handle.Free();
+			NotifyClose(a_sock);
 		}
 
 
@@ -816,28 +1546,48 @@ namespace asd
 	public:
 		static const int ObjCntPerPoll = 1;
 		static const uint32_t DefaultPollOptions = EPOLLONESHOT;
-		int m_epoll = -1;
-		int m_eventfd = -1;
+		static const uint32_t EdgePollOptions = EPOLLET | EPOLLIN | EPOLLOUT;
+
+		struct Poller
+		{
+			int m_epoll = -1;
+			int m_eventfd = -1;
+		};
+
+		// IOEventOption::PerThreadPoller 이면 IO 쓰레드 수만큼, 아니면 모든 쓰레드가 공유하는 1개
+		std::vector<Poller> m_pollers;
+
+		// 담당 쓰레드가 정해지지 않은 소켓을 등록할 때 순서대로 배정
+		std::atomic<uint32_t> m_nextPoller;
+
+		// IOEventOption::EdgeTriggered
+		const bool m_edgeTriggered;
 
 
 		IOEventInternal_EPOLL(uint32_t a_threadCount,
-							  IOEvent* a_event)
-			: IOEventInternal(a_threadCount, a_event)
+							  IOEvent* a_event,
+							  const IOEventOption& a_option)
+			: IOEventInternal(a_threadCount, a_event, a_option)
+			, m_edgeTriggered(a_option.EdgeTriggered)
 		{
-			m_epoll = ::epoll_create(ObjCntPerPoll);
-			if (m_epoll == -1) {
-				auto e = errno;
-				asd_RaiseException("fail epoll_create, errno:{}", e);
-			}
+			m_nextPoller = 0;
+			m_pollers.resize(a_option.PerThreadPoller ? max<uint32_t>(a_threadCount, 1) : 1);
+			for (auto& poller : m_pollers) {
+				poller.m_epoll = ::epoll_create(ObjCntPerPoll);
+				if (poller.m_epoll == -1) {
+					auto e = errno;
+					asd_RaiseException("fail epoll_create, errno:{}", e);
+				}
 
-			m_eventfd = ::eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK);
-			if (m_eventfd == -1) {
-				auto e = errno;
-				asd_RaiseException("fail eventfd, errno:{}", e);
-			}
+				poller.m_eventfd = ::eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK);
+				if (poller.m_eventfd == -1) {
+					auto e = errno;
+					asd_RaiseException("fail eventfd, errno:{}", e);
+				}
 
-			if (ProcEventfd<true>() == false)
-				return;
+				if (ProcEventfd<true>(poller) == false)
+					return;
+			}
 
 			StartThread();
 		}
@@ -847,20 +1597,75 @@ namespace asd
 		virtual ~IOEventInternal_EPOLL()
 		{
 			StopThread();
-			if (m_epoll >= 0)
-				::close(m_epoll);
-			if (m_eventfd >= 0)
-				::close(m_eventfd);
+			for (auto& poller : m_pollers) {
+				if (poller.m_epoll >= 0)
+					::close(poller.m_epoll);
+				if (poller.m_eventfd >= 0)
+					::close(poller.m_eventfd);
+			}
+		}
+
+
+
+		inline Poller& GetPoller(AsyncSocket* a_sock)
+		{
+			asd_DAssert(a_sock->m_pollerIndex < m_pollers.size());
+			return m_pollers[a_sock->m_pollerIndex];
+		}
+
+
+
+		// EdgeTriggered 인 경우, 처리할 이벤트가 남아있는 소켓들 (쓰레드별)
+		// 소유권(m_pollOwned)을 가진 채로 대기하며, 다음 배치에서 이어서 처리한다.
+		static std::deque<AsyncSocket_ptr>& EdgeReadyList()
+		{
+			thread_local std::deque<AsyncSocket_ptr> t_list;
+			return t_list;
+		}
+
+
+
+		// 에러로 닫힌 나눠 만든 리스너의 원본 리스너와 에러 (쓰레드별)
+		// 원본 리스너를 닫으면서 나눠 만든 리스너의 락을 잡으므로, 락을 잡지 않은 다음 WaitBatch에서 닫는다.
+		static std::deque<std::pair<AsyncSocketHandle, Socket::Error>>& FailedListenerList()
+		{
+			thread_local std::deque<std::pair<AsyncSocketHandle, Socket::Error>> t_list;
+			return t_list;
+		}
+
+
+
+		// 나눠 만든 리스너 하나가 에러로 닫히면 그 쓰레드는 더 이상 accept하지 못하므로,
+		// 원본 리스너도 닫아서 OnClose로 알린다.
+		void CloseFailedListeners()
+		{
+			auto& failed = FailedListenerList();
+			while (failed.empty() == false) {
+				auto owner = failed.front().first.GetObj();
+				const auto err = failed.front().second;
+				failed.pop_front();
+				if (owner == nullptr)
+					continue;
+
+				auto sockLock = GetLock(owner->m_sockLock);
+				if (owner->m_state != AsyncSocket::State::Listening)
+					continue;
+				owner->m_lastError = err;
+				CloseSocket(owner.get());
+			}
 		}
 
 
 
 		virtual bool Register(AsyncSocket* a_sock) override
 		{
+			if (a_sock->m_pollerIndex >= m_pollers.size())
+				a_sock->m_pollerIndex = m_nextPoller++ % (uint32_t)m_pollers.size();
+
 			epoll_event ev;
 			ev.data.ptr = (void*)AsyncSocketHandle::GetID(a_sock);
-			ev.events = DefaultPollOptions | EPOLLIN;
-			auto r = ::epoll_ctl(m_epoll,
+			ev.events = m_edgeTriggered ? EdgePollOptions : DefaultPollOptions | EPOLLIN;
+			auto r = ::epoll_ctl(GetPoller(a_sock).m_epoll,
 								 EPOLL_CTL_ADD,
 								 a_sock->GetNativeHandle(),
 								 &ev);
@@ -886,30 +1691,35 @@ namespace asd
 		virtual bool PostSignal(AsyncSocket* a_sock) override
 		{
 			if (a_sock == nullptr) {
-				ssize_t r;
-				uint64_t wakeup = 1;
-				while (sizeof(wakeup) != (r=::write(m_eventfd, &wakeup, sizeof(wakeup)))) {
-					if (r>=0){
-						asd_OnErr("unexpected result, r:{}", r);
-						return false;
-					}
-					auto e = errno;
-					switch (e) {
-						case EAGAIN:
-							return true;
-						case EINTR:
+				// 모든 IO 쓰레드를 깨운다.
+				bool ret = true;
+				for (auto& poller : m_pollers) {
+					ssize_t r;
+					uint64_t wakeup = 1;
+					while (sizeof(wakeup) != (r=::write(poller.m_eventfd, &wakeup, sizeof(wakeup)))) {
+						if (r>=0){
+							asd_OnErr("unexpected result, r:{}", r);
+							ret = false;
+							break;
+						}
+						auto e = errno;
+						if (e == EAGAIN)
+							break;
+						if (e == EINTR)
 							continue;
+						asd_OnErr("fail write to m_eventfd, errno:{}", e);
+						ret = false;
+						break;
 					}
-					asd_OnErr("fail write to m_eventfd, errno:{}", e);
-					return false;
 				}
-				return true;
+				return ret;
 			}
 
+			// 엣지 트리거는 같은 설정으로 수정하여, 송신 가능하면 EPOLLOUT 이벤트가 다시 발생하도록 한다.
 			epoll_event ev;
 			ev.data.ptr = (void*)AsyncSocketHandle::GetID(a_sock);
-			ev.events = DefaultPollOptions | EPOLLOUT;
-			auto r = ::epoll_ctl(m_epoll,
+			ev.events = m_edgeTriggered ? EdgePollOptions : DefaultPollOptions | EPOLLOUT;
+			auto r = ::epoll_ctl(GetPoller(a_sock).m_epoll,
 								 EPOLL_CTL_MOD,
 								 a_sock->GetNativeHandle(),
 								 &ev);
@@ -924,13 +1734,13 @@ namespace asd
 
 
 		template <bool IS_FIRST>
-		bool ProcEventfd()
+		bool ProcEventfd(Poller& a_poller)
 		{
 			bool fail = false;
 			if (IS_FIRST == false) {
 				ssize_t r;
 				uint64_t wakeup;
-				while (sizeof(wakeup) != (r=::read(m_eventfd, &wakeup, sizeof(wakeup)))) {
+				while (sizeof(wakeup) != (r=::read(a_poller.m_eventfd, &wakeup, sizeof(wakeup)))) {
 					if (r >= 0)
 						asd_OnErr("unexpected result, r:{}", r);
 					else {
@@ -947,9 +1757,9 @@ namespace asd
 			epoll_event ev;
 			ev.data.ptr = (void*)AsyncSocketHandle::Null;
 			ev.events = EPOLLONESHOT | EPOLLIN;
-			auto r = ::epoll_ctl(m_epoll,
+			auto r = ::epoll_ctl(a_poller.m_epoll,
 								 IS_FIRST ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
-								 m_eventfd,
+								 a_poller.m_eventfd,
 								 &ev);
 			if (r != 0) {
 				auto e = errno;
@@ -965,38 +1775,216 @@ namespace asd
 
 
 
-		virtual bool Wait(uint32_t a_timeoutMs,
-						  EventInfo& a_event /*Out*/) override
+		// 한번의 epoll_wait로 여러 이벤트를 가져온다.
+		// EPOLLONESHOT이므로 같은 소켓이 한 배치에 두번 들어오지 않는다.
+		// EdgeTriggered 인 경우는 m_pollOwned를 먼저 잡은 쓰레드만 처리하고,
+		// 다른 쓰레드는 이벤트 비트만 m_pollEvents에 남겨 소유한 쓰레드가 이어서 처리하게 한다.
+		virtual size_t WaitBatch(uint32_t a_timeoutMs,
+								 EventInfo* a_events /*Out*/,
+								 size_t a_maxCount,
+								 uint32_t a_threadIndex) override
 		{
-			auto r = ::epoll_wait(m_epoll,
-								  &a_event.m_epollEvent,
-								  1,
-								  a_timeoutMs);
-			if (r > 0) {
-				auto id = (AsyncSocketHandle::ID)a_event.m_epollEvent.data.ptr;
-				if (id == AsyncSocketHandle::Null)
-					return ProcEventfd<false>();
-				a_event.m_socket = AsyncSocketHandle(id).GetObj();
-				if (a_event.m_socket == nullptr)
-					return true;
-				if (a_event.m_socket->m_state == AsyncSocket::State::Connecting)
-					a_event.m_onEvent = a_event.m_epollEvent.events & EPOLLOUT;
-				else {
-					a_event.m_onEvent = a_event.m_epollEvent.events & EPOLLIN;
-					a_event.m_onSignal = a_event.m_epollEvent.events & EPOLLOUT;
+			thread_local std::vector<epoll_event> t_epollEvents;
+			if (t_epollEvents.size() < a_maxCount)
+				t_epollEvents.resize(a_maxCount);
+
+			CloseFailedListeners();
+
+			// 이어서 처리할 소켓이 있으면 기다리지 않는다.
+			auto& ready = EdgeReadyList();
+			Poller& poller = m_pollers[a_threadIndex % m_pollers.size()];
+			auto r = ::epoll_wait(poller.m_epoll,
+								  t_epollEvents.data(),
+								  (int)min<size_t>(a_maxCount, std::numeric_limits<int>::max()),
+								  ready.empty() ? a_timeoutMs : 0);
+			if (r < 0) {
+				auto e = errno;
+				if (e != EINTR)
+					asd_OnErr("polling error, errno:{}", e);
+				r = 0;
+			}
+
+			size_t count = 0;
+			for (int i=0; i<r; ++i) {
+				auto& event = a_events[count];
+				event.m_epollEvent = t_epollEvents[i];
+				auto id = (AsyncSocketHandle::ID)event.m_epollEvent.data.ptr;
+				if (id == AsyncSocketHandle::Null) {
+					ProcEventfd<false>(poller);
+					continue;
 				}
-				return true;
+				event.m_socket = AsyncSocketHandle(id).GetObj();
+				if (event.m_socket == nullptr)
+					continue;
+				if (m_edgeTriggered) {
+					AsyncSocket* sock = event.m_socket.get();
+					sock->m_pollEvents |= event.m_epollEvent.events;
+					if (sock->m_pollOwned.exchange(true)) {
+						// 다른 쓰레드가 처리중
+						event.m_socket.reset();
+						continue;
+					}
+					event.m_epollEvent.events = sock->m_pollEvents.exchange(0);
+				}
+				SetEventFlags(event);
+				++count;
 			}
-			else if (r == 0) {
-				a_event.m_timeout = true;
-				return true;
+
+			// 다 처리하지 못했던 소켓들
+			while (count < a_maxCount && ready.empty() == false) {
+				auto& event = a_events[count];
+				event.m_socket = std::move(ready.front());
+				ready.pop_front();
+				event.m_epollEvent.events = event.m_socket->m_pollEvents.exchange(0);
+				SetEventFlags(event);
+				++count;
 			}
+			return count;
+		}
+
 
-			a_event.m_error = errno;
-			if (a_event.m_error == EINTR)
+
+		// 큐의 첫번째 버퍼를 MSG_ZEROCOPY로 보낼지 여부. m_sendLock을 잡은 상태에서 호출
+		// 처음 사용할 때 SO_ZEROCOPY를 설정하고, 실패하면 이 소켓은 writev만 사용한다.
+		bool UseZeroCopy(AsyncSocket* a_sock)
+		{
+#if asd_Support_ZeroCopy
+			typedef AsyncSocketNative::ZeroCopyState ZeroCopyState;
+			auto native = a_sock->m_native.get();
+			if (native != nullptr && native->m_zcFrontPinned)
 				return true;
-			asd_OnErr("polling error, errno:{}", a_event.m_error);
+
+			auto& front = a_sock->m_sendQueue.front();
+			if (m_option.ZeroCopyThreshold == 0 || front->GetSize() - a_sock->m_sendOffset < m_option.ZeroCopyThreshold)
+				return false;
+
+			if (native == nullptr) {
+				a_sock->m_native = std::make_shared<AsyncSocketNative>();
+				native = a_sock->m_native.get();
+			}
+			if (native->m_zcState == ZeroCopyState::Unknown) {
+				int on = 1;
+				auto r = ::setsockopt(a_sock->GetNativeHandle(),
+									  SOL_SOCKET,
+									  SO_ZEROCOPY,
+									  &on,
+									  sizeof(on));
+				native->m_zcState = r == 0 ? ZeroCopyState::On : ZeroCopyState::Off;
+			}
+			return native->m_zcState == ZeroCopyState::On;
+#else
+			return false;
+#endif
+		}
+
+
+
+		// MSG_ZEROCOPY로 a_sent 바이트를 송신함. m_sendLock을 잡은 상태에서 호출
+		// 다 보낸 버퍼는 완료통지를 받을 때까지 m_zcPending으로 옮겨둔다.
+		void SentZeroCopy(AsyncSocket* a_sock,
+						  size_t a_sent)
+		{
+#if asd_Support_ZeroCopy
+			auto native = a_sock->m_native.get();
+			asd_DAssert(native != nullptr);
+			const uint32_t id = native->m_zcNextId++;
+			++a_sock->m_sendStats.ZeroCopySends;
+			ReleaseSendBytes(a_sock, a_sent);
+
+			auto& queue = a_sock->m_sendQueue;
+			const size_t remain = queue.front()->GetSize() - a_sock->m_sendOffset;
+			if (remain > a_sent) {
+				a_sock->m_sendOffset += a_sent;
+				native->m_zcFrontPinned = true;
+				return;
+			}
+			asd_DAssert(remain == a_sent);
+			native->m_zcPending.push_back({id, std::move(queue.front())});
+			queue.pop_front();
+			a_sock->m_sendOffset = 0;
+			native->m_zcFrontPinned = false;
+#else
+			asd_RAssert(false, "unsupported MSG_ZEROCOPY");
+#endif
+		}
+
+
+
+		bool HasZeroCopyPending(AsyncSocket* a_sock)
+		{
+#if asd_Support_ZeroCopy
+			auto native = a_sock->m_native.get();
+			return native != nullptr && native->m_zcPending.empty() == false;
+#else
 			return false;
+#endif
+		}
+
+
+
+#if asd_Support_ZeroCopy
+		// MSG_ERRQUEUE에서 MSG_ZEROCOPY 완료통지를 읽어 커널이 놓아준 버퍼들을 해제한다.
+		// 이 소켓이 MSG_ZEROCOPY를 사용한 적이 없으면 false
+		bool ReapZeroCopy(AsyncSocket* a_sock)
+		{
+			typedef AsyncSocketNative::ZeroCopyState ZeroCopyState;
+			auto sendLock = GetLock(a_sock->m_sendLock);
+			auto native = a_sock->m_native.get();
+			if (native == nullptr || native->m_zcState == ZeroCopyState::Unknown)
+				return false;
+
+			auto& pending = native->m_zcPending;
+			while (true) {
+				alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_storage))];
+				msghdr msg = {};
+				msg.msg_control = control;
+				msg.msg_controllen = sizeof(control);
+				auto r = ::recvmsg(a_sock->GetNativeHandle(), &msg, MSG_ERRQUEUE);
+				if (r == -1) {
+					auto e = errno;
+					if (e == EINTR)
+						continue;
+					if (e != EAGAIN)
+						asd_OnErr("fail recvmsg(MSG_ERRQUEUE), errno:{}", e);
+					break;
+				}
+
+				for (cmsghdr* cm=CMSG_FIRSTHDR(&msg); cm!=nullptr; cm=CMSG_NXTHDR(&msg, cm)) {
+					const bool recvErr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+									  || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+					if (recvErr == false)
+						continue;
+					sock_extended_err ee;
+					std::memcpy(&ee, CMSG_DATA(cm), sizeof(ee));
+					if (ee.ee_origin != SO_EE_ORIGIN_ZEROCOPY || ee.ee_errno != 0)
+						continue;
+
+					// 커널이 복사로 대체했으면 이후로는 writev를 사용한다. (loopback 등)
+					if (ee.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+						native->m_zcState = ZeroCopyState::Off;
+
+					// [ee_info, ee_data] 범위의 sendmsg가 완료됨. TCP는 순서대로 완료된다.
+					const uint32_t last = ee.ee_data;
+					a_sock->m_sendStats.ZeroCopyDone += last - ee.ee_info + 1;
+					while (pending.empty() == false && (int32_t)(pending.front().m_id - last) <= 0)
+						pending.pop_front();
+				}
+			}
+			return true;
+		}
+#endif
+
+
+
+		void SetEventFlags(EventInfo& a_event)
+		{
+			const uint32_t events = a_event.m_epollEvent.events;
+			if (a_event.m_socket->m_state == AsyncSocket::State::Connecting)
+				a_event.m_onEvent = events & EPOLLOUT;
+			else {
+				a_event.m_onEvent = events & (EPOLLIN | EPOLLERR);
+				a_event.m_onSignal = events & EPOLLOUT;
+			}
 		}
 
 
@@ -1015,30 +2003,61 @@ namespace asd
 			AsyncSocket* sock = a_event.m_socket.get();
 
 			// error
-			if (EPOLLERR & a_event.m_epollEvent.events) {
+			// 연결중인 소켓의 에러(연결 거부 등)는 아래에서 OnConnect로 알린다.
+			if ((EPOLLERR & a_event.m_epollEvent.events) && sock->m_state != AsyncSocket::State::Connecting) {
 				int e = GetSocketError(sock);
-				switch (e) {
-					default:
-						asd_OnErr("unknown socket error, errno:{}", e);
-						break;
-				}
-				if (sock->m_state != AsyncSocket::State::Closing)
+				if (sock->GetSocektType() == Socket::Type::UDP) {
+					// ICMP 에러 등 이전 데이터그램에 대한 에러이므로 소켓은 계속 사용한다.
 					sock->m_lastError = e;
-				CloseSocket(sock);
-				return;
+				}
+#if asd_Support_ZeroCopy
+				else if (e == 0 && ReapZeroCopy(sock)) {
+					// MSG_ZEROCOPY 완료통지
+				}
+#endif
+				else {
+					switch (e) {
+						default:
+							asd_OnErr("unknown socket error, errno:{}", e);
+							break;
+					}
+					if (sock->m_state != AsyncSocket::State::Closing)
+						sock->m_lastError = e;
+					CloseSocket(sock);
+					return;
+				}
 			}
 
 			// connected
 			if (a_event.m_socket->m_state == AsyncSocket::State::Connecting) {
+				// connect 호출 전에 등록되면서 발생한 이벤트 (연결되지 않은 소켓은 EPOLLHUP)
+				// 엣지 트리거는 이후의 이벤트와 합쳐져 있을 수 있으므로 현재 상태를 다시 확인한다.
+				if (EPOLLHUP & a_event.m_epollEvent.events) {
+					pollfd pfd;
+					pfd.fd = sock->GetNativeHandle();
+					pfd.events = POLLOUT;
+					pfd.revents = 0;
+					if (::poll(&pfd, 1, 0) <= 0)
+						return;
+				}
 				asd_RAssert(EPOLLOUT & a_event.m_epollEvent.events, "unknown logic error");
 				int e = GetSocketError(sock);
 				if (e == 0) {
 					a_event.m_socket->m_state = AsyncSocket::State::Connected;
-					sock->m_recvBuffer = NewBuffer<asd_BufferList_DefaultReadBufferSize>();
 					m_event->OnConnect(sock, 0);
+
+					// 엣지 트리거는 연결과 함께 받은 수신 이벤트가 다시 오지 않으므로 다음 배치에서 이어서 처리한다.
+					// (서버가 먼저 보내는 경우)
+					if (m_edgeTriggered && (EPOLLIN & a_event.m_epollEvent.events))
+						ContinueLater(sock, EPOLLIN);
 				}
 				else {
 					switch (e) {
+						case ETIMEDOUT: // connection timeout
+						case ECONNREFUSED: // 서버에서 connection 거부
+						case EHOSTUNREACH:
+						case ENETUNREACH:
+							break;
 						default:
 							asd_OnErr("unknown socket error, errno:{}", e);
 							break;
@@ -1051,28 +2070,91 @@ namespace asd
 			}
 
 			// recv
+			// 엣지 트리거는 EAGAIN 또는 예산을 다 쓸 때까지 반복한다.
+			uint32_t budget = max<uint32_t>(m_option.EdgeBudget, 1);
+			if (sock->GetSocektType() == Socket::Type::UDP) {
+				while (sock->m_state == AsyncSocket::State::Connected) {
+					bool more;
+					int e = RecvDatagrams(sock, more);
+					switch (e) {
+						case 0:
+							break;
+						case EAGAIN: // 전부 읽었음
+							return;
+						case EINTR: // 인터럽트
+							continue;
+						default: // ICMP 에러 등, 소켓은 계속 사용한다.
+							sock->m_lastError = e;
+							more = true;
+							break;
+					}
+					if (m_edgeTriggered == false || more == false)
+						return;
+					if (--budget == 0) {
+						ContinueLater(sock, EPOLLIN);
+						return;
+					}
+				}
+				return;
+			}
+
 			sock->m_lastError = 0;
 			while (sock->m_state == AsyncSocket::State::Connected) {
-				if (sock->m_recvBuffer == nullptr) {
-					asd_OnErr("unknown logic error");
-					sock->m_lastError = -1;
-					CloseSocket(sock, true);
-					return;
+				RingBuffer* ring = sock->m_recvRing.get();
+				void* buf;
+				size_t len;
+				if (ring != nullptr) {
+					if (ring->Reserve(asd_BufferList_DefaultReadBufferSize) == false) {
+						asd_OnErr("recv ring buffer is full, limit:{}", ring->GetLimit());
+						sock->m_lastError = ENOBUFS;
+						CloseSocket(sock);
+						return;
+					}
+					buf = ring->GetWritePtr();
+					len = ring->GetWritable();
+				}
+				else {
+					// 수신 가능 통지를 받은 뒤에 할당 (LazyRecvBuffer가 아니면 이전 수신 후 미리 할당해둔다)
+					if (sock->m_recvBuffer == nullptr)
+						sock->m_recvBuffer = NewRecvBuffer(sock);
+					buf = sock->m_recvBuffer->GetBuffer();
+					len = sock->m_recvBuffer->Capacity();
 				}
 				auto r = ::recv(sock->GetNativeHandle(),
-								sock->m_recvBuffer->GetBuffer(),
-								sock->m_recvBuffer->Capacity(),
+								buf,
+								len,
 								0);
 				if (r > 0) {
 					// success
-					auto recvedData = std::move(sock->m_recvBuffer);
-					asd_RAssert(recvedData->SetSize(r), "fail recvedData->SetSize({})", r);
-					m_event->OnRecv(sock, std::move(recvedData));
+					if (ring != nullptr) {
+						ring->Commit(r);
+						if (DeliverRing(sock, *ring) == false) {
+							CloseSocket(sock);
+							return;
+						}
 
-					// 유저 콜백 호출 후
-					if (sock->m_state == AsyncSocket::State::Connected)
-						sock->m_recvBuffer = NewBuffer<asd_BufferList_DefaultReadBufferSize>();
-					return;
+						// 유저 콜백 호출 후, 남은 데이터가 없으면 커진 버퍼를 반납
+						ring->Shrink(asd_BufferList_DefaultReadBufferSize);
+					}
+					else {
+						auto recvedData = std::move(sock->m_recvBuffer);
+						AdaptRecvSize(sock, r, len);
+						asd_RAssert(recvedData->SetSize(r), "fail recvedData->SetSize({})", r);
+						CallOnRecv(sock, std::move(recvedData));
+
+						// 유저 콜백 호출 후
+						if (sock->m_state == AsyncSocket::State::Connected && m_option.LazyRecvBuffer == false)
+							sock->m_recvBuffer = NewRecvBuffer(sock);
+					}
+
+					// 버퍼를 다 채우지 못했으면 수신버퍼가 비었으므로 다음 엣지를 기다린다.
+					if (m_edgeTriggered == false || (size_t)r < len)
+						return;
+					if (--budget == 0) {
+						ContinueLater(sock, EPOLLIN);
+						return;
+					}
+					continue;
 				}
 				else if (r == 0) {
 					// fin
@@ -1084,6 +2166,8 @@ namespace asd
 					auto e = errno;
 					switch (e) {
 						case EAGAIN: // 전부 읽었음
+							if (m_option.LazyRecvBuffer)
+								sock->m_recvBuffer.reset();
 							return;
 						case EINTR: // 인터럽트
 							continue;
@@ -1102,16 +2186,27 @@ namespace asd
 			}
 
 			// listen
+			budget = max<uint32_t>(m_option.EdgeBudget, 1);
 			while (sock->m_state == AsyncSocket::State::Listening) {
 				auto newSock = AsyncSocketHandle().Alloc();
 				IpAddress addr;
 				auto e = sock->Accept(*newSock, addr);
 				switch (e) {
-					case 0:
+					case 0: {
 						newSock->m_state = AsyncSocket::State::Connected;
-						newSock->m_recvBuffer = NewBuffer<asd_BufferList_DefaultReadBufferSize>();
-						m_event->OnAccept(sock, std::move(newSock));
-						return;
+						newSock->m_pollerIndex = sock->m_pollerIndex;
+
+						// 나눠 만든 리스너는 내부용이므로 원본 리스너로 알린다.
+						auto owner = sock->m_listenOwner.GetObj();
+						CallOnAccept(owner != nullptr ? owner.get() : sock, std::move(newSock));
+						if (m_edgeTriggered == false)
+							return;
+						if (--budget == 0) {
+							ContinueLater(sock, EPOLLIN);
+							return;
+						}
+						continue;
+					}
 					case EAGAIN:
 						return;
 					case EINTR: // 인터럽트
@@ -1128,6 +2223,17 @@ namespace asd
 
 
 
+		// 엣지 트리거에서 예산을 다 써서 남은 이벤트를 다음 배치로 미룬다.
+		// 이벤트 비트를 남겨두면 Poll_Finally에서 EdgeReadyList()에 넣는다.
+		inline void ContinueLater(AsyncSocket* a_sock,
+								  uint32_t a_events)
+		{
+			asd_DAssert(m_edgeTriggered);
+			a_sock->m_pollEvents |= a_events;
+		}
+
+
+
 		virtual int Connect(AsyncSocket* a_sock,
 							const IpAddress& a_dst) override
 		{
@@ -1147,9 +2253,59 @@ namespace asd
 
 
 
-		virtual int Listen(AsyncSocket* a_sock) override
+		virtual int PrepareListen(AsyncSocket* a_sock) override
+		{
+			if (m_pollers.size() <= 1)
+				return 0;
+			return a_sock->SetSockOpt_ReusePort(true);
+		}
+
+
+
+		virtual int Listen(AsyncSocket* a_sock,
+						   int a_backlog) override
 		{
-			// 딱히 할게 없음
+			if (m_pollers.size() <= 1)
+				return 0;
+
+			// 원본 리스너가 없는 나머지 IO 쓰레드마다 같은 주소의 리스너를 만든다.
+			IpAddress addr;
+			int e = a_sock->GetSockName(addr);
+			if (e != 0) {
+				asd_OnErr("fail GetSockName, errno:{}", e);
+				return e;
+			}
+
+			const auto ownerHandle = AsyncSocketHandle::GetHandle(a_sock);
+			for (uint32_t i=0; i<m_pollers.size(); ++i) {
+				if (i == a_sock->m_pollerIndex)
+					continue;
+
+				AsyncSocketHandle handle;
+				auto shard = handle.Alloc();
+				auto sockLock = GetLock(shard->m_sockLock);
+				e = shard->Init(a_sock->GetSocektType(), addr.GetAddressFamily());
+				if (e == 0)
+					e = shard->SetSockOpt_ReusePort(true);
+				if (e == 0)
+					e = shard->Bind(addr);
+				if (e == 0) {
+					shard->m_pollerIndex = i;
+					e = Register(shard.get()) ? 0 : shard->m_lastError;
+				}
+				if (e == 0)
+					e = shard->Socket::Listen(a_backlog);
+				if (e != 0) {
+					asd_OnErr("fail listen shard({}), errno:{}", addr.ToString(), e);
+					handle.Free();
+					return e;
+				}
+
+				shard->m_event = a_sock->m_event;
+				shard->m_listenOwner = ownerHandle;
+				shard->m_state = AsyncSocket::State::Listening;
+				a_sock->m_listenShards.emplace_back(std::move(handle));
+			}
 			return 0;
 		}
 
@@ -1157,20 +2313,72 @@ namespace asd
 
 		virtual int Send(AsyncSocket* a_sock) override
 		{
+			if (a_sock->GetSocektType() == Socket::Type::UDP)
+				return SendDatagrams(a_sock);
+
 			thread_local std::vector<iovec> t_iovec;
-			const size_t count = min(a_sock->m_sendQueue.size(), (size_t)IOV_MAX);
-			t_iovec.resize(count);
-			size_t i = 0;
-			for (auto& data : a_sock->m_sendQueue) {
-				auto& iov = t_iovec[i++];
-				iov.iov_base = data->GetBuffer();
-				iov.iov_len = data->GetSize();
-			}
+			auto& queue = a_sock->m_sendQueue;
+			CoalesceSendQueue(a_sock);
+
+			while (queue.empty() == false) {
+				// 송신큐의 버퍼는 공유중일 수 있으므로(SharedBuffer)
+				// 버퍼를 수정하지 않고 m_sendOffset으로 송신 진행상황을 관리한다.
+				size_t total = 0;
+				ssize_t r;
+				bool zeroCopy = false;
+				const FileBuffer* file = queue.front()->GetFile();
+				if (file != nullptr) {
+					// 파일은 유저 공간으로 읽어들이지 않고 커널에서 바로 전송
+					asd_DAssert(file->GetSize() > a_sock->m_sendOffset);
+					off_t offset = (off_t)(file->GetOffset() + a_sock->m_sendOffset);
+					total = file->GetSize() - a_sock->m_sendOffset;
+					r = ::sendfile(a_sock->GetNativeHandle(),
+								   file->GetNativeHandle(),
+								   &offset,
+								   total);
+					if (r == 0) {
+						asd_OnErr("file truncated while sending");
+						return EIO;
+					}
+				}
+#if asd_Support_ZeroCopy
+				else if (UseZeroCopy(a_sock)) {
+					// 큰 버퍼는 커널로 복사하지 않고 페이지를 그대로 전송한다.
+					auto& data = queue.front();
+					asd_DAssert(data->GetSize() > a_sock->m_sendOffset);
+					iovec iov;
+					iov.iov_base = data->GetBuffer() + a_sock->m_sendOffset;
+					iov.iov_len = total = data->GetSize() - a_sock->m_sendOffset;
+					msghdr msg = {};
+					msg.msg_iov = &iov;
+					msg.msg_iovlen = 1;
+					r = ::sendmsg(a_sock->GetNativeHandle(),
+								  &msg,
+								  MSG_ZEROCOPY | MSG_NOSIGNAL);
+					zeroCopy = true;
+				}
+#endif
+				else {
+					// 파일 버퍼 직전까지를 writev로 전송
+					const size_t limit = min(queue.size(), (size_t)IOV_MAX);
+					t_iovec.resize(limit);
+					size_t count = 0;
+					for (; count<limit; ++count) {
+						auto& data = queue[count];
+						if (data->GetFile() != nullptr)
+							break;
+						auto& iov = t_iovec[count];
+						const size_t offset = count==0 ? a_sock->m_sendOffset : 0;
+						asd_DAssert(data->GetSize() >= offset);
+						iov.iov_base = data->GetBuffer() + offset;
+						iov.iov_len = data->GetSize() - offset;
+						total += iov.iov_len;
+					}
+					r = ::writev(a_sock->GetNativeHandle(),
+								 t_iovec.data(),
+								 count);
+				}
 
-			while (t_iovec.size() > 0) {
-				auto r = writev(a_sock->GetNativeHandle(),
-								t_iovec.data(),
-								t_iovec.size());
 				if (r == -1) {
 					auto e = errno;
 					switch (e) {
@@ -1178,22 +2386,27 @@ namespace asd
 							continue;
 						case EAGAIN: // 과도한 Send로 인해 송신버퍼 부족
 							a_sock->m_sendSignal = true;
-							t_iovec.pop_back();
-							continue;
+							return 0;
 						case EPIPE: // 상대방 연결 끊김
 							break;
 						default:
-							asd_OnErr("fail writev, errno:{}", e);
+							asd_OnErr("fail {}, errno:{}", file!=nullptr ? "sendfile" : zeroCopy ? "sendmsg" : "writev", e);
 							break;
 					}
 					return e;
 				}
-				break;
-			}
 
-			for (i=0; i<t_iovec.size(); ++i)
-				a_sock->m_sendQueue.pop_front();
+				if (zeroCopy)
+					SentZeroCopy(a_sock, (size_t)r);
+				else
+					PopSent(a_sock, (size_t)r);
 
+				if ((size_t)r < total) {
+					// 송신버퍼가 가득 참, EPOLLOUT 이벤트를 기다린다.
+					a_sock->m_sendSignal = true;
+					return 0;
+				}
+			}
 			return 0;
 		}
 
@@ -1210,7 +2423,8 @@ namespace asd
 				if (a_sock->m_state != AsyncSocket::State::Closing)
 					::shutdown(a_sock->GetNativeHandle(), SHUT_RD);
 
-				if (a_sock->m_sendQueue.size() > 0) {
+				// MSG_ZEROCOPY로 보낸 버퍼는 커널이 놓아줄 때까지 기다린다. (EPOLLERR로 통지됨)
+				if (a_sock->HasPendingSend() || HasZeroCopyPending(a_sock)) {
 					a_sock->m_state = AsyncSocket::State::Closing;
 					return;
 				}
@@ -1218,10 +2432,21 @@ namespace asd
 
 			a_sock->Socket::Close();
 			a_sock->m_state = AsyncSocket::State::Closed;
-			m_event->OnClose(a_sock, a_sock->m_lastError);
 
-			auto handle = AsyncSocketHandle::GetHandle(a_sock);
-			handle.Free();
+			// 나눠 만든 리스너들도 함께 닫는다.
+			for (auto& shardHandle : a_sock->m_listenShards) {
+				auto shard = shardHandle.GetObj();
+				if (shard != nullptr)
+					shard->Close();
+			}
+			a_sock->m_listenShards.clear();
+
+			// 나눠 만든 리스너는 내부용이므로 알리지 않는다.
+			// 원본 리스너가 닫은 것이 아니라 에러로 닫혔으면(m_event가 남아있음) 원본 리스너를 닫아서 알린다.
+			const bool isShard = a_sock->m_listenOwner.GetID() != AsyncSocketHandle::Null;
+			if (isShard && std::atomic_load(&a_sock->m_event) != nullptr)
+				FailedListenerList().emplace_back(a_sock->m_listenOwner, a_sock->m_lastError);
+			NotifyClose(a_sock, isShard == false);
 		}
 
 
@@ -1231,13 +2456,32 @@ namespace asd
 			if (a_sock->m_state == AsyncSocket::State::Closed)
 				return;
 
+			if (m_edgeTriggered) {
+				if (a_sock->m_state == AsyncSocket::State::Closing) {
+					CloseSocket(a_sock);
+					if (a_sock->m_state == AsyncSocket::State::Closed)
+						return;
+				}
+
+				// 소유권을 놓은 뒤, 그 사이에 들어온 이벤트가 있으면 다시 잡아서 다음 배치에 처리한다.
+				a_sock->m_pollOwned = false;
+				if (a_sock->m_pollEvents == 0 || a_sock->m_pollOwned.exchange(true))
+					return;
+				auto sock = AsyncSocketHandle::GetHandle(a_sock).GetObj();
+				if (sock != nullptr)
+					EdgeReadyList().emplace_back(std::move(sock));
+				else
+					a_sock->m_pollOwned = false;
+				return;
+			}
+
 			if (DefaultPollOptions & EPOLLONESHOT) {
 				epoll_event ev;
 				ev.data.ptr = (void*)AsyncSocketHandle::GetID(a_sock);
 				ev.events = DefaultPollOptions | EPOLLIN;
-				if (a_sock->m_sendSignal)
+				if (a_sock->m_sendSignal || a_sock->m_state == AsyncSocket::State::Connecting)
 					ev.events |= EPOLLOUT;
-				auto r = ::epoll_ctl(m_epoll,
+				auto r = ::epoll_ctl(GetPoller(a_sock).m_epoll,
 									 EPOLL_CTL_MOD,
 									 a_sock->GetNativeHandle(),
 									 &ev);
@@ -1256,51 +2500,1028 @@ namespace asd
 
 
 
-#else
-	#error This platform is not supported.
-
-#endif
-
+#if asd_Support_IOUring
+	#define asd_IOEventInternal_URING_Entries	1024
 
+	// 이 쓰레드가 담당하는 링 (IO 쓰레드 자신이 넣은 요청은 대기 직전에 모아서 제출한다)
+	thread_local void* t_uringCurrentRing = nullptr;
 
-	IOEvent::~IOEvent()
+	class IOEventInternal_URING final
+		: public IOEventInternal
 	{
-		Stop();
-	}
+	public:
+		enum OpType : uint8_t
+		{
+			Op_None = 0,
+			Op_Recv,
+			Op_RecvPoll,	// LazyRecvBuffer, 수신 가능 통지만 받는다.
+			Op_Accept,
+			Op_Connect,
+			Op_Send,
+			Op_SendPoll,
+			Op_Signal,
+		};
 
+		// IO 쓰레드마다 하나씩 사용하는 링
+		struct Ring
+		{
+			int m_fd = -1;
 
-	void IOEvent::Start(uint32_t a_threadCount /*= Get_HW_Concurrency()*/)
-	{
-		reset(new IOEventInternal_NATIVE(a_threadCount, this));
-	}
+			void* m_sqMap = nullptr;
+			size_t m_sqMapSize = 0;
+			void* m_cqMap = nullptr;	// SQ와 한번에 매핑된 경우 nullptr
+			size_t m_cqMapSize = 0;
+			io_uring_sqe* m_sqes = nullptr;
+			size_t m_sqesSize = 0;
 
+			unsigned* m_sqHead = nullptr;
+			unsigned* m_sqTail = nullptr;
+			unsigned* m_sqArray = nullptr;
+			unsigned m_sqMask = 0;
+			unsigned m_sqEntries = 0;
 
-	void IOEvent::Stop()
-	{
-		std::shared_ptr<IOEventInternal> internal = std::move(*this);
-		if (internal != nullptr)
-			internal->StopThread();
-	}
+			unsigned* m_cqHead = nullptr;
+			unsigned* m_cqTail = nullptr;
+			io_uring_cqe* m_cqes = nullptr;
+			unsigned m_cqMask = 0;
 
+			// SQ를 보호하는 락 (CQ는 담당 IO 쓰레드만 접근한다)
+			Mutex m_sqLock;
 
-	bool IOEvent::RegisterListener(AsyncSocket_ptr& a_sock,
-								   const IpAddress& a_bind,
-								   int a_backlog /*= 1024*/)
-	{
-		auto internal = get();
-		if (internal == nullptr)
-			return false;
-		if (a_sock == nullptr)
-			return false;
+			// SQ에 넣었지만 아직 커널에 제출하지 않은 요청 수
+			unsigned m_unsubmitted = 0;
 
-		auto sockLock = GetLock(a_sock->m_sockLock);
+			// 완료되지 않은 요청 수
+			std::atomic<uint32_t> m_inflight{0};
+
+
+			// 성공하면 0, 실패하면 errno를 리턴
+			int Init(unsigned a_entries)
+			{
+				io_uring_params params;
+				std::memset(&params, 0, sizeof(params));
+				m_fd = (int)::syscall(__NR_io_uring_setup, a_entries, &params);
+				if (m_fd < 0) {
+					auto e = errno;
+					m_fd = -1;
+					return e;
+				}
+
+				// 대기 타임아웃(EXT_ARG)과 완료큐 넘침 보존(NODROP)은 필수
+				const uint32_t required = IORING_FEAT_EXT_ARG | IORING_FEAT_NODROP;
+				if ((params.features & required) != required)
+					return ENOSYS;
+
+				m_sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+				m_cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+				if (singleMap)
+					m_sqMapSize = m_cqMapSize = max(m_sqMapSize, m_cqMapSize);
+
+				m_sqMap = ::mmap(nullptr, m_sqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+				if (m_sqMap == MAP_FAILED) {
+					auto e = errno;
+					m_sqMap = nullptr;
+					return e;
+				}
+
+				uint8_t* cq = (uint8_t*)m_sqMap;
+				if (singleMap == false) {
+					m_cqMap = ::mmap(nullptr, m_cqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+					if (m_cqMap == MAP_FAILED) {
+						auto e = errno;
+						m_cqMap = nullptr;
+						return e;
+					}
+					cq = (uint8_t*)m_cqMap;
+				}
+
+				m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				void* sqes = ::mmap(nullptr, m_sqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, m_fd, IORING_OFF_SQES);
+				if (sqes == MAP_FAILED)
+					return errno;
+				m_sqes = (io_uring_sqe*)sqes;
+
+				uint8_t* sq = (uint8_t*)m_sqMap;
+				m_sqHead = (unsigned*)(sq + params.sq_off.head);
+				m_sqTail = (unsigned*)(sq + params.sq_off.tail);
+				m_sqArray = (unsigned*)(sq + params.sq_off.array);
+				m_sqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+				m_sqEntries = *(unsigned*)(sq + params.sq_off.ring_entries);
+
+				m_cqHead = (unsigned*)(cq + params.cq_off.head);
+				m_cqTail = (unsigned*)(cq + params.cq_off.tail);
+				m_cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+				m_cqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+				return 0;
+			}
+
+			~Ring()
+			{
+				if (m_sqes != nullptr)
+					::munmap(m_sqes, m_sqesSize);
+				if (m_cqMap != nullptr)
+					::munmap(m_cqMap, m_cqMapSize);
+				if (m_sqMap != nullptr)
+					::munmap(m_sqMap, m_sqMapSize);
+				if (m_fd >= 0)
+					::close(m_fd);
+			}
+		};
+
+		std::vector<std::unique_ptr<Ring>> m_rings;
+
+		// 담당 쓰레드가 정해지지 않은 소켓을 등록할 때 순서대로 배정
+		std::atomic<uint32_t> m_nextRing;
+
+		// 멀티샷 accept 사용 여부, 커널이 거부(EINVAL)하면 이후로는 한번씩 요청한다.
+		std::atomic_bool m_multishotAccept;
+
+
+		// 커널이 필요한 기능을 모두 지원하는지 처음 한번만 확인한다.
+		static bool IsSupported()
+		{
+			static const bool s_supported = []()
+			{
+				Ring ring;
+				if (ring.Init(4) != 0)
+					return false;
+
+				const unsigned OpCount = 256;
+				std::vector<uint8_t> buf(sizeof(io_uring_probe) + OpCount*sizeof(io_uring_probe_op), 0);
+				auto probe = (io_uring_probe*)buf.data();
+				if (::syscall(__NR_io_uring_register, ring.m_fd, IORING_REGISTER_PROBE, probe, OpCount) < 0)
+					return false;
+
+				const uint8_t ops[] = {
+					IORING_OP_NOP,
+					IORING_OP_RECV,
+					IORING_OP_SENDMSG,
+					IORING_OP_ACCEPT,
+					IORING_OP_CONNECT,
+					IORING_OP_POLL_ADD,
+				};
+				for (auto op : ops) {
+					if (op > probe->last_op)
+						return false;
+					if ((probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)
+						return false;
+				}
+				return true;
+			}();
+			return s_supported;
+		}
+
+
+		IOEventInternal_URING(uint32_t a_threadCount,
+							  IOEvent* a_event,
+							  const IOEventOption& a_option)
+			: IOEventInternal(a_threadCount, a_event, a_option)
+		{
+			m_nextRing = 0;
+#if defined(IORING_ACCEPT_MULTISHOT)
+			m_multishotAccept = true;
+#else
+			m_multishotAccept = false;
+#endif
+			m_rings.resize(max<uint32_t>(a_threadCount, 1));
+			for (auto& ring : m_rings) {
+				ring.reset(new Ring);
+				auto e = ring->Init(asd_IOEventInternal_URING_Entries);
+				if (e != 0)
+					asd_RaiseException("fail io_uring_setup, errno:{}", e);
+			}
+
+			StartThread();
+		}
+
+
+
+		virtual ~IOEventInternal_URING()
+		{
+			StopThread();
+
+			// 진행중인 요청들을 취소하고 완료를 받아서, 요청들이 잡고있던 소켓 참조를 해제한다.
+			std::vector<EventInfo> events(max<size_t>(m_option.PollBatchSize, 1));
+			for (uint32_t i=0; i<m_rings.size(); ++i) {
+				Ring& ring = *m_rings[i];
+				t_uringCurrentRing = nullptr;
+#if defined(IORING_ASYNC_CANCEL_ANY)
+				Push(ring, [](io_uring_sqe& a_sqe)
+				{
+					a_sqe.opcode = IORING_OP_ASYNC_CANCEL;
+					a_sqe.fd = -1;
+					a_sqe.cancel_flags = IORING_ASYNC_CANCEL_ANY;
+				});
+#endif
+				for (int retry=0; ring.m_inflight>0 && retry<100; ++retry) {
+					const size_t count = WaitBatch(10, events.data(), events.size(), i);
+					for (size_t k=0; k<count; ++k)
+						events[k] = EventInfo();
+				}
+			}
+			t_uringCurrentRing = nullptr;
+		}
+
+
+
+		virtual IOEventOption::Backend GetBackend() const override
+		{
+			return IOEventOption::Backend::IOUring;
+		}
+
+
+
+		inline Ring& GetRing(AsyncSocket* a_sock)
+		{
+			asd_DAssert(a_sock->m_pollerIndex < m_rings.size());
+			return *m_rings[a_sock->m_pollerIndex];
+		}
+
+
+
+		// m_sqLock을 잡은 상태에서 SQ에 쌓인 요청들을 커널에 제출한다.
+		int Submit(Ring& a_ring)
+		{
+			while (a_ring.m_unsubmitted > 0) {
+				auto r = ::syscall(__NR_io_uring_enter, a_ring.m_fd, a_ring.m_unsubmitted, 0, 0, nullptr, 0);
+				if (r < 0) {
+					auto e = errno;
+					switch (e) {
+						case EINTR: // 인터럽트
+							continue;
+						case EAGAIN:
+						case EBUSY: // 완료큐가 밀려있음, 담당 IO 쓰레드가 대기하기 전에 다시 제출한다.
+							return 0;
+					}
+					asd_OnErr("fail io_uring_enter, errno:{}", e);
+					return e;
+				}
+				if (r == 0)
+					break;
+				a_ring.m_unsubmitted -= min<unsigned>((unsigned)r, a_ring.m_unsubmitted);
+			}
+			return 0;
+		}
+
+
+
+		// SQ에 요청을 하나 추가한다. a_prep으로 sqe를 채운다.
+		// SQ에 들어간 요청은 언젠가 반드시 제출되므로, 실패를 리턴하는 경우는 SQ에 넣지 못했을 때 뿐이다.
+		template <typename Prep>
+		int Push(Ring& a_ring,
+				 Prep&& a_prep)
+		{
+			auto lock = GetLock(a_ring.m_sqLock);
+			const unsigned tail = *a_ring.m_sqTail;
+			if (tail - __atomic_load_n(a_ring.m_sqHead, __ATOMIC_ACQUIRE) >= a_ring.m_sqEntries) {
+				// SQ가 가득 참
+				int e = Submit(a_ring);
+				if (e != 0)
+					return e;
+				if (tail - __atomic_load_n(a_ring.m_sqHead, __ATOMIC_ACQUIRE) >= a_ring.m_sqEntries)
+					return EBUSY;
+			}
+
+			const unsigned index = tail & a_ring.m_sqMask;
+			io_uring_sqe& sqe = a_ring.m_sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			a_prep(sqe);
+			a_ring.m_sqArray[index] = index;
+			__atomic_store_n(a_ring.m_sqTail, tail + 1, __ATOMIC_RELEASE);
+			++a_ring.m_unsubmitted;
+			++a_ring.m_inflight;
+
+			if (t_uringCurrentRing != &a_ring)
+				Submit(a_ring);
+			return 0;
+		}
+
+
+
+		// 소켓의 요청 슬롯에 요청을 넣는다. 완료될 때까지 슬롯이 소켓 참조를 잡고 있는다.
+		template <typename Prep>
+		int PushOp(AsyncSocket* a_sock,
+				   AsyncSocketNative::UringOp& a_op,
+				   OpType a_type,
+				   Prep&& a_prep)
+		{
+			a_op.m_ref = AsyncSocketHandle::GetHandle(a_sock).GetObj();
+			if (a_op.m_ref == nullptr)
+				return EBADF;
+			a_op.m_type = a_type;
+
+			int e = Push(GetRing(a_sock), [&](io_uring_sqe& a_sqe)
+			{
+				a_prep(a_sqe);
+				a_sqe.fd = a_sock->GetNativeHandle();
+				a_sqe.user_data = (uint64_t)(uintptr_t)&a_op;
+			});
+			if (e != 0) {
+				asd_OnErr("fail push io_uring request, errno:{}", e);
+				a_op.m_ref.reset();
+			}
+			return e;
+		}
+
+
+
+		// 담당 IO 쓰레드에서만 호출한다.
+		size_t Reap(Ring& a_ring,
+					EventInfo* a_events /*Out*/,
+					size_t a_maxCount)
+		{
+			unsigned head = *a_ring.m_cqHead;
+			const unsigned tail = __atomic_load_n(a_ring.m_cqTail, __ATOMIC_ACQUIRE);
+			size_t count = 0;
+			for (; head!=tail && count<a_maxCount; ++head) {
+				const io_uring_cqe& cqe = a_ring.m_cqes[head & a_ring.m_cqMask];
+#if defined(IORING_CQE_F_MORE)
+				const bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+#else
+				const bool more = false;
+#endif
+				if (more == false)
+					--a_ring.m_inflight;
+
+				auto op = (AsyncSocketNative::UringOp*)(uintptr_t)cqe.user_data;
+				if (op == nullptr)
+					continue;	// 깨우기용
+
+				// 멀티샷 요청은 마지막 완료까지 소켓 참조를 유지한다.
+				auto& event = a_events[count];
+				if (more)
+					event.m_socket = op->m_ref;
+				else
+					event.m_socket = std::move(op->m_ref);
+				if (event.m_socket == nullptr)
+					continue;
+				event.m_uringOp = op->m_type;
+				event.m_uringRes = cqe.res;
+				event.m_uringMore = more;
+				if (op->m_type == Op_Signal)
+					event.m_onSignal = true;
+				else
+					event.m_onEvent = true;
+				++count;
+			}
+			__atomic_store_n(a_ring.m_cqHead, head, __ATOMIC_RELEASE);
+			return count;
+		}
+
+
+
+		virtual bool Register(AsyncSocket* a_sock) override
+		{
+			if (a_sock->m_pollerIndex >= m_rings.size())
+				a_sock->m_pollerIndex = m_nextRing++ % (uint32_t)m_rings.size();
+			if (a_sock->m_native == nullptr)
+				a_sock->m_native = std::make_shared<AsyncSocketNative>();
+
+			int e = a_sock->SetNonblock(true);
+			if (e != 0) {
+				asd_OnErr("fail SetNonblock, errno:{}", e);
+				a_sock->m_lastError = e;
+				return false;
+			}
+
+			// accept한 소켓은 바로 수신을 시작한다.
+			if (a_sock->m_state == AsyncSocket::State::Connected) {
+				e = ArmRecv(a_sock);
+				if (e != 0) {
+					a_sock->m_lastError = e;
+					return false;
+				}
+			}
+			return true;
+		}
+
+
+
+		virtual bool PostSignal(AsyncSocket* a_sock) override
+		{
+			if (a_sock == nullptr) {
+				// 모든 IO 쓰레드를 깨운다.
+				bool ret = true;
+				for (auto& ring : m_rings) {
+					int e = Push(*ring, [](io_uring_sqe& a_sqe)
+					{
+						a_sqe.opcode = IORING_OP_NOP;
+					});
+					if (e != 0) {
+						asd_OnErr("fail push wakeup, errno:{}", e);
+						ret = false;
+					}
+				}
+				return ret;
+			}
+
+			int e = PushOp(a_sock, a_sock->m_native->m_signalOp, Op_Signal, [](io_uring_sqe& a_sqe)
+			{
+				a_sqe.opcode = IORING_OP_NOP;
+			});
+			return e == 0;
+		}
+
+
+
+		// 대기 전에 이 쓰레드가 쌓아둔 요청을 한번에 제출하고, 완료된 요청을 최대 a_maxCount개 가져온다.
+		virtual size_t WaitBatch(uint32_t a_timeoutMs,
+								 EventInfo* a_events /*Out*/,
+								 size_t a_maxCount,
+								 uint32_t a_threadIndex) override
+		{
+			Ring& ring = *m_rings[a_threadIndex % m_rings.size()];
+			t_uringCurrentRing = &ring;
+			{
+				auto lock = GetLock(ring.m_sqLock);
+				Submit(ring);
+			}
+
+			size_t count = Reap(ring, a_events, a_maxCount);
+			if (count > 0)
+				return count;
+
+			unsigned flags = IORING_ENTER_GETEVENTS;
+			io_uring_getevents_arg arg;
+			__kernel_timespec ts;
+			const void* argp = nullptr;
+			size_t argsz = 0;
+			if (a_timeoutMs != std::numeric_limits<uint32_t>::max()) {
+				ts.tv_sec = a_timeoutMs / 1000;
+				ts.tv_nsec = (a_timeoutMs % 1000) * 1000000LL;
+				std::memset(&arg, 0, sizeof(arg));
+				arg.ts = (uint64_t)(uintptr_t)&ts;
+				flags |= IORING_ENTER_EXT_ARG;
+				argp = &arg;
+				argsz = sizeof(arg);
+			}
+
+			auto r = ::syscall(__NR_io_uring_enter, ring.m_fd, 0, 1, flags, argp, argsz);
+			if (r < 0) {
+				auto e = errno;
+				switch (e) {
+					case EINTR:
+					case ETIME:
+					case EAGAIN:
+					case EBUSY:
+						break;
+					default:
+						asd_OnErr("polling error, errno:{}", e);
+						break;
+				}
+			}
+			return Reap(ring, a_events, a_maxCount);
+		}
+
+
+
+		// 수신 요청, m_sockLock을 잡은 상태에서 호출
+		int ArmRecv(AsyncSocket* a_sock)
+		{
+			auto& native = *a_sock->m_native;
+			if (native.m_recvPending)
+				return 0;
+
+			void* buf;
+			size_t len;
+			RingBuffer* ring = a_sock->m_recvRing.get();
+			if (ring != nullptr) {
+				if (ring->Reserve(asd_BufferList_DefaultReadBufferSize) == false) {
+					asd_OnErr("recv ring buffer is full, limit:{}", ring->GetLimit());
+					return ENOBUFS;
+				}
+				buf = ring->GetWritePtr();
+				len = ring->GetWritable();
+			}
+			else if (m_option.LazyRecvBuffer || a_sock->GetSocektType() == Socket::Type::UDP) {
+				// 버퍼 없이 수신 가능 통지만 요청 (UDP는 통지를 받은 뒤 recvmmsg로 모아서 받는다)
+				int e = PushOp(a_sock, native.m_recvOp, Op_RecvPoll, [](io_uring_sqe& a_sqe)
+				{
+					a_sqe.opcode = IORING_OP_POLL_ADD;
+					a_sqe.poll32_events = POLLIN;
+				});
+				if (e == 0)
+					native.m_recvPending = true;
+				return e;
+			}
+			else {
+				if (a_sock->m_recvBuffer == nullptr)
+					a_sock->m_recvBuffer = NewRecvBuffer(a_sock);
+				buf = a_sock->m_recvBuffer->GetBuffer();
+				len = a_sock->m_recvBuffer->Capacity();
+			}
+
+			int e = PushOp(a_sock, native.m_recvOp, Op_Recv, [&](io_uring_sqe& a_sqe)
+			{
+				a_sqe.opcode = IORING_OP_RECV;
+				a_sqe.addr = (uint64_t)(uintptr_t)buf;
+				a_sqe.len = (uint32_t)min<size_t>(len, std::numeric_limits<uint32_t>::max());
+			});
+			if (e == 0)
+				native.m_recvPending = true;
+			return e;
+		}
+
+
+
+		// accept 요청, m_sockLock을 잡은 상태에서 호출
+		// 멀티샷이면 요청 하나로 연결마다 완료를 받으며, 마지막 완료(IORING_CQE_F_MORE 없음) 후에 다시 요청한다.
+		int ArmAccept(AsyncSocket* a_sock)
+		{
+			auto& native = *a_sock->m_native;
+			if (native.m_recvPending)
+				return 0;
+
+			const bool multishot = m_multishotAccept;
+			int e = PushOp(a_sock, native.m_recvOp, Op_Accept, [multishot](io_uring_sqe& a_sqe)
+			{
+				a_sqe.opcode = IORING_OP_ACCEPT;
+#if defined(IORING_ACCEPT_MULTISHOT)
+				if (multishot)
+					a_sqe.ioprio |= IORING_ACCEPT_MULTISHOT;
+#endif
+			});
+			if (e == 0)
+				native.m_recvPending = true;
+			return e;
+		}
+
+
+
+		// 수신 결과 처리, a_res는 수신한 바이트 수 또는 -errno
+		void RecvComplete(AsyncSocket* a_sock,
+						  int a_res)
+		{
+			a_sock->m_lastError = 0;
+			if (a_res > 0) {
+				RingBuffer* ring = a_sock->m_recvRing.get();
+				if (ring != nullptr) {
+					ring->Commit(a_res);
+					if (DeliverRing(a_sock, *ring) == false) {
+						CloseSocket(a_sock);
+						return;
+					}
+
+					// 유저 콜백 호출 후, 남은 데이터가 없으면 커진 버퍼를 반납
+					ring->Shrink(asd_BufferList_DefaultReadBufferSize);
+					return;
+				}
+				auto recvedData = std::move(a_sock->m_recvBuffer);
+				AdaptRecvSize(a_sock, a_res, recvedData->Capacity());
+				asd_RAssert(recvedData->SetSize(a_res), "fail recvedData->SetSize({})", a_res);
+				CallOnRecv(a_sock, std::move(recvedData));
+				return;
+			}
+			if (a_res == 0) {
+				// fin
+				CloseSocket(a_sock, true);
+				return;
+			}
+			const int e = -a_res;
+			switch (e) {
+				case EAGAIN:
+				case EINTR: // Poll_Finally에서 다시 요청
+					if (m_option.LazyRecvBuffer)
+						a_sock->m_recvBuffer.reset();
+					return;
+				case ECONNABORTED:
+				case ECONNRESET: // 상대방이 끊음 (RST)
+					CloseSocket(a_sock, true);
+					return;
+				default:
+					asd_OnErr("fail recv, errno:{}", e);
+					a_sock->m_lastError = e;
+					CloseSocket(a_sock);
+					return;
+			}
+		}
+
+
+
+		virtual void ProcEvent(EventInfo& a_event) override
+		{
+			AsyncSocket* sock = a_event.m_socket.get();
+			auto& native = *sock->m_native;
+			const int res = a_event.m_uringRes;
+
+			switch (a_event.m_uringOp) {
+				case Op_Connect: {
+					native.m_recvPending = false;
+					if (sock->m_state != AsyncSocket::State::Connecting)
+						return;
+					if (res == 0) {
+						sock->m_state = AsyncSocket::State::Connected;
+						m_event->OnConnect(sock, 0);
+					}
+					else {
+						const int e = -res;
+						sock->m_lastError = e;
+						sock->m_state = AsyncSocket::State::None;
+						m_event->OnConnect(sock, e);
+					}
+					return;
+				}
+
+				case Op_Accept: {
+					if (a_event.m_uringMore == false)
+						native.m_recvPending = false;
+					if (sock->m_state != AsyncSocket::State::Listening) {
+						// 닫히는 중에 accept된 연결
+						if (res >= 0)
+							::close(res);
+						return;
+					}
+					if (res < 0) {
+						const int e = -res;
+						switch (e) {
+							case EAGAIN:
+							case EINTR:
+							case ECONNABORTED: // Poll_Finally에서 다시 요청
+								return;
+							case EINVAL:
+								// 멀티샷 accept를 지원하지 않는 커널
+								if (m_multishotAccept.exchange(false))
+									return;
+								asd_OnErr("fail accept, errno:{}", e);
+								sock->m_lastError = e;
+								CloseSocket(sock);
+								return;
+							default:
+								asd_OnErr("fail accept, errno:{}", e);
+								sock->m_lastError = e;
+								CloseSocket(sock);
+								return;
+						}
+					}
+
+					auto newSock = AsyncSocketHandle().Alloc();
+					static_cast<Socket&>(*newSock) = Socket((Socket::Handle)res,
+															 sock->GetSocektType(),
+															 sock->GetAddressFamily());
+					newSock->m_state = AsyncSocket::State::Connected;
+					CallOnAccept(sock, std::move(newSock));
+					return;
+				}
+
+				case Op_Recv: {
+					native.m_recvPending = false;
+					if (sock->m_state != AsyncSocket::State::Connected)
+						return;
+					RecvComplete(sock, res);
+					return;
+				}
+
+				case Op_RecvPoll: {
+					native.m_recvPending = false;
+					if (sock->m_state != AsyncSocket::State::Connected)
+						return;
+					if (res < 0) {
+						RecvComplete(sock, res);
+						return;
+					}
+
+					if (sock->GetSocektType() == Socket::Type::UDP) {
+						// 다 받지 못한 데이터그램은 Poll_Finally에서 다시 요청하면 바로 통지된다.
+						bool more;
+						int e = RecvDatagrams(sock, more);
+						switch (e) {
+							case 0:
+							case EAGAIN:
+							case EINTR:
+								break;
+							default: // ICMP 에러 등, 소켓은 계속 사용한다.
+								sock->m_lastError = e;
+								break;
+						}
+						return;
+					}
+
+					// 수신 가능하므로 이제 버퍼를 할당해서 읽는다.
+					sock->m_recvBuffer = NewRecvBuffer(sock);
+					auto r = ::recv(sock->GetNativeHandle(),
+									sock->m_recvBuffer->GetBuffer(),
+									sock->m_recvBuffer->Capacity(),
+									0);
+					RecvComplete(sock, r >= 0 ? (int)r : -errno);
+					return;
+				}
+
+				case Op_Send:
+				case Op_SendPoll: {
+					native.m_sendPending = false;
+					auto sendLock = GetLock(sock->m_sendLock);
+					sock->m_sendSignal = false;
+					switch (sock->m_state) {
+						case AsyncSocket::State::Connected:
+						case AsyncSocket::State::Closing:
+							break;
+						default:
+							return;
+					}
+
+					int e = 0;
+					if (res < 0)
+						e = -res;
+					else if (a_event.m_uringOp == Op_Send)
+						PopSent(sock, (size_t)res);
+
+					switch (e) {
+						case 0:
+						case EINTR:
+						case EAGAIN: // 남은 데이터를 이어서 송신
+							e = Send(sock);
+							break;
+						case EPIPE:
+						case ECONNRESET: // 상대방 연결 끊김
+							break;
+						default:
+							asd_OnErr("fail sendmsg, errno:{}", e);
+							break;
+					}
+					if (e != 0) {
+						sock->m_lastError = e;
+						CloseSocket(sock, true);
+					}
+					return;
+				}
+
+				default:
+					asd_OnErr("unknown io_uring op : {}", a_event.m_uringOp);
+					return;
+			}
+		}
+
+
+
+		virtual int Connect(AsyncSocket* a_sock,
+							const IpAddress& a_dst) override
+		{
+			auto& native = *a_sock->m_native;
+			const int len = a_dst.GetAddrLen();
+			asd_DAssert(len > 0 && (size_t)len <= sizeof(native.m_addr));
+			std::memcpy(&native.m_addr, (const sockaddr*)a_dst, len);
+
+			int e = PushOp(a_sock, native.m_recvOp, Op_Connect, [&](io_uring_sqe& a_sqe)
+			{
+				a_sqe.opcode = IORING_OP_CONNECT;
+				a_sqe.addr = (uint64_t)(uintptr_t)&native.m_addr;
+				a_sqe.off = (uint64_t)len;
+			});
+			if (e != 0)
+				return e;
+			native.m_recvPending = true;
+			return 0;
+		}
+
+
+
+		virtual int Listen(AsyncSocket* a_sock,
+						   int a_backlog) override
+		{
+			return ArmAccept(a_sock);
+		}
+
+
+
+		// 송신은 소켓당 하나의 요청만 진행하고, 완료되면 송신큐에 쌓인 나머지를 이어서 보낸다.
+		virtual int Send(AsyncSocket* a_sock) override
+		{
+			auto& native = *a_sock->m_native;
+			auto& queue = a_sock->m_sendQueue;
+			if (native.m_sendPending) {
+				a_sock->m_sendSignal = true;
+				return 0;
+			}
+
+			if (a_sock->GetSocektType() == Socket::Type::UDP) {
+				// sendmmsg로 바로 보내고, 송신버퍼가 가득 차면 POLLOUT을 기다린다.
+				int e = SendDatagrams(a_sock);
+				if (e != 0 || a_sock->m_sendSignal == false)
+					return e;
+				e = PushOp(a_sock, native.m_sendOp, Op_SendPoll, [](io_uring_sqe& a_sqe)
+				{
+					a_sqe.opcode = IORING_OP_POLL_ADD;
+					a_sqe.poll32_events = POLLOUT;
+				});
+				if (e == 0)
+					native.m_sendPending = true;
+				return e;
+			}
+
+			// 진행중인 송신이 없으므로 송신큐를 정리해도 된다.
+			CoalesceSendQueue(a_sock);
+
+			while (queue.empty() == false) {
+				const FileBuffer* file = queue.front()->GetFile();
+				if (file == nullptr)
+					break;
+
+				// 파일은 sendfile로 바로 보내고, 송신버퍼가 가득 차면 POLLOUT을 기다린다.
+				asd_DAssert(file->GetSize() > a_sock->m_sendOffset);
+				off_t offset = (off_t)(file->GetOffset() + a_sock->m_sendOffset);
+				auto r = ::sendfile(a_sock->GetNativeHandle(),
+									file->GetNativeHandle(),
+									&offset,
+									file->GetSize() - a_sock->m_sendOffset);
+				if (r == 0) {
+					asd_OnErr("file truncated while sending");
+					return EIO;
+				}
+				if (r < 0) {
+					auto e = errno;
+					switch (e) {
+						case EINTR: // 인터럽트
+							continue;
+						case EAGAIN: // 송신버퍼 부족
+							e = PushOp(a_sock, native.m_sendOp, Op_SendPoll, [](io_uring_sqe& a_sqe)
+							{
+								a_sqe.opcode = IORING_OP_POLL_ADD;
+								a_sqe.poll32_events = POLLOUT;
+							});
+							if (e == 0) {
+								native.m_sendPending = true;
+								a_sock->m_sendSignal = true;
+							}
+							return e;
+						case EPIPE: // 상대방 연결 끊김
+							break;
+						default:
+							asd_OnErr("fail sendfile, errno:{}", e);
+							break;
+					}
+					return e;
+				}
+				PopSent(a_sock, (size_t)r);
+			}
+			if (queue.empty())
+				return 0;
+
+			// 파일 버퍼 직전까지를 sendmsg로 전송
+			// 완료될 때까지 커널이 참조하므로 iovec과 msghdr은 소켓별로 가지고 있는다.
+			const size_t limit = min(queue.size(), (size_t)IOV_MAX);
+			native.m_sendIov.clear();
+			for (size_t i=0; i<limit; ++i) {
+				auto& data = queue[i];
+				if (data->GetFile() != nullptr)
+					break;
+				const size_t offset = i==0 ? a_sock->m_sendOffset : 0;
+				asd_DAssert(data->GetSize() >= offset);
+				iovec iov;
+				iov.iov_base = data->GetBuffer() + offset;
+				iov.iov_len = data->GetSize() - offset;
+				native.m_sendIov.push_back(iov);
+			}
+
+			msghdr& msg = native.m_sendMsg;
+			std::memset(&msg, 0, sizeof(msg));
+			msg.msg_iov = native.m_sendIov.data();
+			msg.msg_iovlen = native.m_sendIov.size();
+			int e = PushOp(a_sock, native.m_sendOp, Op_Send, [&](io_uring_sqe& a_sqe)
+			{
+				a_sqe.opcode = IORING_OP_SENDMSG;
+				a_sqe.addr = (uint64_t)(uintptr_t)&msg;
+				a_sqe.len = 1;
+				a_sqe.msg_flags = MSG_NOSIGNAL;
+			});
+			if (e != 0)
+				return e;
+			native.m_sendPending = true;
+			a_sock->m_sendSignal = true;
+			return 0;
+		}
+
+
+
+		virtual void CloseSocket(AsyncSocket* a_sock,
+								 bool a_hard = false) override
+		{
+			if (a_sock->m_state == AsyncSocket::State::Closed)
+				return;
+
+			if (a_hard == false) {
+				auto sendLock = GetLock(a_sock->m_sendLock);
+				if (a_sock->m_state != AsyncSocket::State::Closing)
+					::shutdown(a_sock->GetNativeHandle(), SHUT_RD);
+
+				if (a_sock->HasPendingSend()) {
+					a_sock->m_state = AsyncSocket::State::Closing;
+					return;
+				}
+			}
+
+			// close만으로는 진행중인 io_uring 요청이 끝나지 않으므로 shutdown으로 완료시킨다.
+			::shutdown(a_sock->GetNativeHandle(), SHUT_RDWR);
+			a_sock->Socket::Close();
+			a_sock->m_state = AsyncSocket::State::Closed;
+			NotifyClose(a_sock);
+		}
+
+
+
+		virtual void Poll_Finally(AsyncSocket* a_sock) override
+		{
+			int e;
+			switch (a_sock->m_state) {
+				case AsyncSocket::State::Connected:
+					e = ArmRecv(a_sock);
+					break;
+				case AsyncSocket::State::Listening:
+					e = ArmAccept(a_sock);
+					break;
+				case AsyncSocket::State::Closing:
+					CloseSocket(a_sock);
+					return;
+				default:
+					return;
+			}
+
+			if (e != 0) {
+				a_sock->m_lastError = e;
+				CloseSocket(a_sock);
+			}
+		}
+	};
+#endif
+
+
+
+#else
+	#error This platform is not supported.
+
+#endif
+
+
+
+	IOEvent::~IOEvent()
+	{
+		Stop();
+	}
+
+
+	void IOEvent::Start(uint32_t a_threadCount /*= Get_HW_Concurrency()*/,
+						const IOEventOption& a_option /*= IOEventOption()*/)
+	{
+#if asd_Support_IOUring
+		if (a_option.BackendType == IOEventOption::Backend::IOUring) {
+			if (IOEventInternal_URING::IsSupported()) {
+				reset(new IOEventInternal_URING(a_threadCount, this, a_option));
+				return;
+			}
+			// 지원하지 않으면 Native로 대체 (GetBackend()로 확인 가능)
+		}
+#endif
+		reset(new IOEventInternal_NATIVE(a_threadCount, this, a_option));
+	}
+
+
+	IOEventOption::Backend IOEvent::GetBackend() const
+	{
+		auto internal = get();
+		if (internal == nullptr)
+			return IOEventOption::Backend::Native;
+		return internal->GetBackend();
+	}
+
+
+	void IOEvent::Stop()
+	{
+		std::shared_ptr<IOEventInternal> internal = std::move(*this);
+		if (internal != nullptr)
+			internal->StopThread();
+	}
+
+
+	bool IOEvent::RegisterListener(AsyncSocket_ptr& a_sock,
+								   const IpAddress& a_bind,
+								   int a_backlog /*= 1024*/)
+	{
+		auto internal = get();
+		if (internal == nullptr)
+			return false;
+		if (a_sock == nullptr)
+			return false;
+
+		auto sockLock = GetLock(a_sock->m_sockLock);
 
 		if (a_sock->m_state != AsyncSocket::State::None) {
 			asd_OnErr("invalid socket state : {}", (uint8_t)a_sock->m_state);
 			return false;
 		}
 
-		auto e = a_sock->Bind(a_bind);
+		auto e = a_sock->Init(a_sock->GetSocektType(), a_bind.GetAddressFamily());
+		if (e != 0) {
+			asd_OnErr("fail socket init, e:{}", e);
+			return false;
+		}
+
+		e = internal->PrepareListen(a_sock.get());
+		if (e != 0) {
+			asd_OnErr("fail IOEventInternal::PrepareListen(), e:{}", e);
+			return false;
+		}
+
+		e = a_sock->Bind(a_bind);
 		if (e != 0) {
 			asd_OnErr("fail Socket::Bind({}), e:{}", a_bind.ToString(), e);
 			return false;
@@ -1315,8 +3536,8 @@ namespace asd
 			return false;
 		}
 
-		e = internal->Listen(a_sock.get());
-		if (0 != 0) {
+		e = internal->Listen(a_sock.get(), a_backlog);
+		if (e != 0) {
 			asd_OnErr("fail IOEventInternal::Listen(), e:{}", e);
 			return false;
 		}
@@ -1382,6 +3603,13 @@ namespace asd
 		if (set == false)
 			return false;
 
+		if (a_sock->m_sendHighWatermark == 0)
+			a_sock->SetSendWatermark(internal->m_option.SendHighWatermark, internal->m_option.SendLowWatermark);
+
+		ThreadPool* pool = internal->m_option.DispatchPool;
+		if (pool != nullptr && a_sock->m_dispatch == nullptr)
+			a_sock->m_dispatch = std::make_shared<AsyncSocketDispatch>(a_sock.get(), this, pool);
+
 		if (internal->Register(a_sock.get()) == false) {
 			a_sock->m_event.reset();
 			return false;
@@ -1390,6 +3618,48 @@ namespace asd
 	}
 
 
+	bool IOEvent::RegisterUDP(AsyncSocket_ptr& a_sock,
+							  const IpAddress& a_bind)
+	{
+		auto internal = get();
+		if (internal == nullptr)
+			return false;
+		if (a_sock == nullptr)
+			return false;
+
+		auto sockLock = GetLock(a_sock->m_sockLock);
+
+		if (a_sock->m_state != AsyncSocket::State::None) {
+			asd_OnErr("invalid socket state : {}", (uint8_t)a_sock->m_state);
+			return false;
+		}
+		if (a_sock->m_recvRing != nullptr) {
+			asd_OnErr("UDP socket supports only RecvMode::Chunk");
+			return false;
+		}
+
+		auto e = a_sock->Init(Socket::Type::UDP, a_bind.GetAddressFamily());
+		if (e != 0) {
+			asd_OnErr("fail socket init, e:{}", e);
+			return false;
+		}
+
+		e = a_sock->Bind(a_bind);
+		if (e != 0) {
+			asd_OnErr("fail Socket::Bind({}), e:{}", a_bind.ToString(), e);
+			return false;
+		}
+
+		// 연결 과정이 없으므로 바로 송수신 가능한 상태로 등록한다.
+		a_sock->m_state = AsyncSocket::State::Connected;
+		if (Register(a_sock) == false) {
+			a_sock->m_state = AsyncSocket::State::None;
+			return false;
+		}
+		return true;
+	}
+
+
 	void IOEvent::Poll(uint32_t a_timeoutSec)
 	{
 		auto internal = get();
@@ -1399,7 +3669,8 @@ namespace asd
 
 
 
-	bool AsyncSocket::Send(std::deque<Buffer_ptr>&& a_data)
+	template <typename Push>
+	bool AsyncSocket::SendInternal(Push&& a_push)
 	{
 		auto ev = std::atomic_load(&m_event);
 		if (ev == nullptr) {
@@ -1411,16 +3682,11 @@ namespace asd
 		if (m_state != AsyncSocket::State::Connected)
 			return false;
 
-		size_t count = 0;
-		for (auto& it : a_data) {
-			if (it == nullptr)
-				continue;
-			m_sendQueue.emplace_back(std::move(it));
-			++count;
-		}
-		a_data.clear();
+		// 높은 수위에 도달한 뒤에는 OnSendDrained 전까지 받지 않는다.
+		if (m_sendBlocked)
+			return false;
 
-		if (count == 0)
+		if (a_push() == 0)
 			return true;
 
 		if (m_sendSignal == false) {
@@ -1429,6 +3695,209 @@ namespace asd
 			else
 				asd_OnErr("fail PostSignal, ID:{}", AsyncSocketHandle::GetID(this));
 		}
+
+		if (m_sendHighWatermark == 0 || m_sendBytes < m_sendHighWatermark)
+			return true;
+		m_sendBlocked = true;
+		sendLock.unlock();
+		ev->m_event->OnSendBlocked(this);
+		return true;
+	}
+
+
+	bool AsyncSocket::Send(BufferQueue&& a_data)
+	{
+		return SendInternal([&]()
+		{
+			size_t count = 0;
+			for (auto& it : a_data) {
+				if (it == nullptr)
+					continue;
+				m_sendBytes += it->GetSize();
+				m_sendQueue.emplace_back(std::move(it));
+				++count;
+			}
+			a_data.clear();
+			return count;
+		});
+	}
+
+
+	bool AsyncSocket::Send(Buffer_ptr&& a_data)
+	{
+		return SendInternal([&]()
+		{
+			if (a_data == nullptr)
+				return (size_t)0;
+			m_sendBytes += a_data->GetSize();
+			m_sendQueue.emplace_back(std::move(a_data));
+			return (size_t)1;
+		});
+	}
+
+
+	void AsyncSocket::SetSendWatermark(size_t a_high,
+									   size_t a_low)
+	{
+		auto sendLock = GetLock(m_sendLock);
+		m_sendHighWatermark = a_high;
+		m_sendLowWatermark = min(a_low, a_high);
+	}
+
+
+	size_t AsyncSocket::GetPendingSendBytes() const
+	{
+		auto sendLock = GetLock(m_sendLock);
+		return m_sendBytes;
+	}
+
+
+	Socket::Error AsyncSocket::GetLastError() const
+	{
+		auto sockLock = GetLock(m_sockLock);
+		return m_lastError;
+	}
+
+
+	SendStats AsyncSocket::GetSendStats() const
+	{
+		auto sendLock = GetLock(m_sendLock);
+		return m_sendStats;
+	}
+
+
+	bool AsyncSocket::SendTo(Buffer_ptr&& a_data,
+							 const IpAddress& a_dst)
+	{
+		if (GetSocektType() != Socket::Type::UDP) {
+			asd_OnErr("SendTo is only for UDP socket");
+			return false;
+		}
+		if (a_data != nullptr && a_data->GetFile() != nullptr) {
+			asd_OnErr("FileBuffer can not be sent as a datagram");
+			return false;
+		}
+
+		return SendInternal([&]()
+		{
+			if (a_data == nullptr)
+				return (size_t)0;
+			m_sendBytes += a_data->GetSize();
+			m_sendToQueue.emplace_back();
+			auto& dgram = m_sendToQueue.back();
+			dgram.m_data = std::move(a_data);
+			dgram.m_dst = a_dst;
+			return (size_t)1;
+		});
+	}
+
+
+	bool AsyncSocket::SetRecvMode(RecvMode a_mode,
+								  size_t a_ringLimit /*= asd_RingBuffer_DefaultLimit*/)
+	{
+		auto sockLock = GetLock(m_sockLock);
+		if (std::atomic_load(&m_event) != nullptr) {
+			asd_OnErr("already registered socket");
+			return false;
+		}
+
+		switch (a_mode) {
+			case RecvMode::Chunk:
+				m_recvRing.reset();
+				m_frameOption.reset();
+				break;
+			case RecvMode::Ring:
+				if (a_ringLimit == 0) {
+					asd_OnErr("invalid ring limit");
+					return false;
+				}
+				m_recvRing.reset(new RingBuffer(a_ringLimit));
+				m_recvBuffer.reset();
+				m_frameOption.reset();
+				break;
+			case RecvMode::Frame:
+				asd_OnErr("use SetFraming()");
+				return false;
+			default:
+				asd_OnErr("invalid RecvMode : {}", (uint8_t)a_mode);
+				return false;
+		}
+		return true;
+	}
+
+
+	AsyncSocket::RecvMode AsyncSocket::GetRecvMode() const
+	{
+		auto sockLock = GetLock(m_sockLock);
+		if (m_frameOption != nullptr)
+			return RecvMode::Frame;
+		return m_recvRing != nullptr ? RecvMode::Ring : RecvMode::Chunk;
+	}
+
+
+	size_t AsyncSocket::GetRecvBufferCapacity() const
+	{
+		auto sockLock = GetLock(m_sockLock);
+		return m_recvBuffer != nullptr ? m_recvBuffer->Capacity() : 0;
+	}
+
+
+	size_t AsyncSocket::GetRecvSize() const
+	{
+		auto sockLock = GetLock(m_sockLock);
+		if (m_recvSize == 0) {
+			auto event = std::atomic_load(&m_event);
+			if (event != nullptr)
+				return event->m_recvInit;
+		}
+		return m_recvSize;
+	}
+
+
+	bool AsyncSocket::SetFraming(const FrameOption& a_option)
+	{
+		auto sockLock = GetLock(m_sockLock);
+		if (std::atomic_load(&m_event) != nullptr) {
+			asd_OnErr("already registered socket");
+			return false;
+		}
+
+		size_t overhead;
+		switch (a_option.FrameType) {
+			case FrameOption::Type::LengthPrefix:
+				switch (a_option.PrefixBytes) {
+					case 1:
+					case 2:
+					case 4:
+						break;
+					default:
+						asd_OnErr("invalid PrefixBytes : {}", a_option.PrefixBytes);
+						return false;
+				}
+				overhead = a_option.PrefixBytes;
+				break;
+			case FrameOption::Type::Delimiter:
+				if (a_option.Delimiter.empty()) {
+					asd_OnErr("empty Delimiter");
+					return false;
+				}
+				overhead = a_option.Delimiter.size();
+				break;
+			default:
+				asd_OnErr("invalid FrameType : {}", (uint8_t)a_option.FrameType);
+				return false;
+		}
+		if (a_option.MaxFrameSize == 0) {
+			asd_OnErr("invalid MaxFrameSize");
+			return false;
+		}
+
+		// 최대 크기의 프레임 하나가 온전히 들어갈 수 있는 크기
+		const size_t ringLimit = a_option.MaxFrameSize + overhead + asd_BufferList_DefaultReadBufferSize;
+		m_recvRing.reset(new RingBuffer(ringLimit));
+		m_recvBuffer.reset();
+		m_frameOption.reset(new FrameOption(a_option));
+		m_frameScan = 0;
 		return true;
 	}
 
@@ -552,6 +552,39 @@ namespace asd
 
 
 
+	Socket::Error Socket::SetSockOpt_ReusePort(bool a_set)
+	{
+#if defined(SO_REUSEPORT)
+		int set = a_set;
+		return SetSockOpt(SOL_SOCKET,
+						  SO_REUSEPORT,
+						  &set, 
+						  sizeof(set));
+#else
+		return WSAENOPROTOOPT;
+#endif
+	}
+
+	Socket::Error Socket::GetSockOpt_ReusePort(bool& a_result /*Out*/) const
+	{
+#if defined(SO_REUSEPORT)
+		int result;
+		uint32_t size = sizeof(result);
+		auto ret = GetSockOpt(SOL_SOCKET,
+							  SO_REUSEPORT,
+							  &result,
+							  size);
+		if (ret == 0) {
+			a_result = result != 0;
+		}
+		return ret;
+#else
+		return WSAENOPROTOOPT;
+#endif
+	}
+
+
+
 	Socket::Error Socket::SetSockOpt_UseNagle(bool a_set)
 	{
 		asd_DAssert(m_socketType == Type::TCP);
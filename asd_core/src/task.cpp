@@ -28,4 +28,9 @@ namespace asd
 	{
 		Cancel(true);
 	}
+
+	void Task::Rearm()
+	{
+		m_cancel = false;
+	}
 }
@@ -180,8 +180,15 @@ namespace asd
 			}
 
 		private:
+			using Shard = std::unordered_map<
+				size_t,
+				Work,
+				std::hash<size_t>,
+				std::equal_to<size_t>,
+				PoolAllocator<std::pair<const size_t, Work>>
+			>;
 			const size_t ShardCount;
-			std::vector<std::unordered_map<size_t, Work>> m_shards;
+			std::vector<Shard> m_shards;
 			std::vector<Mutex> m_locks;
 		}; //WorkingMap
 
@@ -13,6 +13,7 @@
 #	include <sys/syscall.h>
 #	include <unistd.h>
 #	include <pthread.h>
+#	include <sched.h>
 #
 #endif
 
@@ -79,6 +80,27 @@ namespace asd
 
 
 
+	uint32_t GetCurrentCpuIndex()
+	{
+		// 한번 실패하면 이후로는 시스템콜을 시도하지 않고 쓰레드 순번을 사용
+		static std::atomic_bool s_unsupported(false);
+		if (s_unsupported == false) {
+#if asd_Platform_Windows
+			return ::GetCurrentProcessorNumber();
+
+#else
+			int cpu = ::sched_getcpu();
+			if (cpu >= 0)
+				return (uint32_t)cpu;
+			s_unsupported = true;
+
+#endif
+		}
+		return GetCurrentThreadSequence();
+	}
+
+
+
 	uint32_t Get_HW_Concurrency()
 	{
 		static uint32_t s_HW_Concurrency;
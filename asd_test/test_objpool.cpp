@@ -9,6 +9,7 @@
 #include <cstdlib>
 #include <ctime>
 #include <unordered_map>
+#include <map>
 
 
 namespace asdtest_objpool
@@ -304,6 +305,78 @@ namespace asdtest_objpool
 
 		typedef asd::ObjectPoolShardSet<Pool2> ShardSet2;
 		ShardSetTest<ShardSet2, 4>();
+
+		typedef asd::ObjectPoolShardSet<Pool1, asd::ShardPolicy::ThreadSequence> ShardSet3;
+		ShardSetTest<ShardSet3, 4>();
+
+		typedef asd::ObjectPoolShardSet<Pool2, asd::ShardPolicy::ThreadSequence> ShardSet4;
+		ShardSetTest<ShardSet4, 4>();
+	}
+
+	TEST(ObjectPool, PoolAllocator)
+	{
+		typedef std::pair<const int, TestClass> Value;
+		typedef asd::PoolAllocator<Value> Allocator;
+		std::map<int, TestClass, std::less<int>, Allocator> map;
+		std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, asd::PoolAllocator<std::pair<const int, int>>> hashMap;
+
+		Init();
+		for (int i=0; i<TestCount; ++i) {
+			map[i];
+			hashMap[i] = i;
+		}
+		EXPECT_EQ(g_objCount, TestCount);
+		EXPECT_EQ(hashMap.size(), TestCount);
+
+		for (int i=0; i<TestCount; i+=2) {
+			map.erase(i);
+			hashMap.erase(i);
+		}
+		EXPECT_EQ(g_objCount, TestCount/2);
+		for (auto& it : hashMap)
+			EXPECT_EQ(it.first, it.second);
+
+		// 노드가 풀로 반납되는지 확인
+		auto& pool = Allocator::Pool::Instance();
+		EXPECT_TRUE(pool.Free(pool.Alloc()));
+
+		map.clear();
+		EXPECT_EQ(g_objCount, 0);
+	}
+
+	TEST(ObjectPool, ShardPolicy)
+	{
+		typedef asd::ObjectPoolShardSet<asd::ObjectPool2<TestClass>> ShardSet;
+		ShardSet shardSet;
+		const size_t shardCount = ShardSet::DefaultShardCount();
+		EXPECT_EQ(asd::Get_HW_Concurrency(), shardCount);
+
+		Init();
+		std::thread threads[4];
+		for (auto& t : threads) {
+			t = std::thread([&]()
+			{
+				const auto seq = asd::GetCurrentThreadSequence();
+				EXPECT_EQ(seq, asd::GetShardSeed(asd::ShardPolicy::ThreadSequence));
+
+				// 할당하는 동안 CPU가 바뀌지 않았으면 그 CPU의 샤드에서 할당되어야 한다.
+				int checked = 0;
+				for (int i=0; i<TestCount; ++i) {
+					const auto cpu = asd::GetCurrentCpuIndex();
+					auto obj = shardSet.Alloc();
+					const auto shard = *ShardSet::GetHeader<size_t>(obj);
+					if (cpu == asd::GetCurrentCpuIndex()) {
+						EXPECT_EQ(cpu % shardCount, shard);
+						++checked;
+					}
+					shardSet.Free(obj);
+				}
+				EXPECT_GT(checked, 0);
+			});
+		}
+		for (auto& t : threads)
+			t.join();
+		EXPECT_EQ(g_objCount, 0);
 	}
 }
 
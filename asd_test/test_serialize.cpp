@@ -1,6 +1,8 @@
 ﻿#include "stdafx.h"
 #include "asd/serialize.h"
+#include "asd/string.h"
 #include <memory>
+#include <chrono>
 #if !asd_Platform_Windows
 #include <netinet/in.h>
 #endif
@@ -404,5 +406,918 @@ namespace asdtest_serialize
 		total += (DefaultSize/2-1)*2 + DefaultSize;
 		EXPECT_EQ(buffers.GetTotalSize(), total);
 	}
+
+
+
+	TEST(Serialize, NewBuffer_SizeClass)
+	{
+		// size class 경계값 확인
+		EXPECT_EQ(asd::BufferSizeClass::GetSize(0), 64);
+		EXPECT_EQ(asd::BufferSizeClass::GetSize(1), 80);
+		EXPECT_EQ(asd::BufferSizeClass::GetSize(4), 128);
+		EXPECT_EQ(asd::BufferSizeClass::GetSize(asd::BufferSizeClass::Count-1), asd::BufferSizeClass::MaxSize);
+		for (size_t i=0; i<asd::BufferSizeClass::Count; ++i) {
+			const size_t sz = asd::BufferSizeClass::GetSize(i);
+			EXPECT_EQ(asd::BufferSizeClass::GetIndex(sz), i);
+			if (i > 0)
+				EXPECT_EQ(asd::BufferSizeClass::GetIndex(sz - 1), i);
+			if (i+1 < asd::BufferSizeClass::Count)
+				EXPECT_EQ(asd::BufferSizeClass::GetIndex(sz + 1), i + 1);
+		}
+
+		// 요청한 크기 이상의 버퍼가 할당되는지 확인
+		const size_t sizes[] = {1, 64, 65, 1000, 2048, 3000, 16*1024, 1024*1024, 1024*1024+1};
+		for (auto sz : sizes) {
+			auto buf = asd::NewBuffer(sz);
+			ASSERT_NE(buf, nullptr);
+			EXPECT_GE(buf->Capacity(), sz);
+			EXPECT_EQ(buf->Capacity(), asd::BufferSizeClass::RoundUp(sz));
+			EXPECT_EQ(buf->GetSize(), 0);
+			EXPECT_TRUE(buf->SetSize(sz));
+		}
+
+		// 작은 메시지는 작은 버퍼를 사용
+		asd::BufferList small;
+		EXPECT_EQ(sizeof(int32_t), asd::Write(small, (int32_t)1));
+		ASSERT_EQ(small.at(0)->Capacity(), asd_BufferList_MinWriteBufferSize);
+
+		// 큰 메시지는 한번에 필요한 만큼 할당
+		std::vector<uint8_t> blob(100*1024);
+		asd::BufferList large;
+		EXPECT_EQ(blob.size(), large.Write(blob.data(), blob.size()));
+		ASSERT_GE(large.at(0)->Capacity(), blob.size());
+	}
+
+
+
+	TEST(Serialize, SharedBuffer)
+	{
+		// 여러 버퍼에 나뉘어 쓰여진 데이터는 하나로 합쳐진다.
+		const int Count = 100;
+		asd::BufferList list;
+		for (int i=0; i<3; ++i)
+			list.ReserveBuffer(asd::Buffer_ptr(new SmallBuf));
+		for (int i=0; i<Count; ++i)
+			asd::Write(list, (int32_t)i);
+
+		asd::SharedBuffer shared(std::move(list));
+		EXPECT_EQ(list.GetTotalSize(), 0);
+		ASSERT_EQ(shared.GetSize(), sizeof(int32_t) * Count);
+		for (int i=0; i<Count; ++i) {
+			int32_t v;
+			std::memcpy(&v, shared.GetBuffer() + i*sizeof(int32_t), sizeof(v));
+			EXPECT_EQ(v, i);
+		}
+
+		// 참조는 복사 없이 같은 메모리를 가리킨다.
+		{
+			std::vector<asd::Buffer_ptr> refs;
+			for (int i=0; i<10; ++i) {
+				refs.emplace_back(shared.NewRef());
+				EXPECT_EQ(refs.back()->GetBuffer(), shared.GetBuffer());
+				EXPECT_EQ(refs.back()->GetSize(), shared.GetSize());
+				EXPECT_FALSE(refs.back()->SetSize(0));
+			}
+			EXPECT_EQ(shared.UseCount(), 11);
+		}
+		EXPECT_EQ(shared.UseCount(), 1);
+
+		// slice
+		auto slice = shared.Slice(sizeof(int32_t) * 10, sizeof(int32_t));
+		ASSERT_TRUE((bool)slice);
+		EXPECT_EQ(slice.GetSize(), sizeof(int32_t));
+		EXPECT_EQ(slice.GetBuffer(), shared.GetBuffer() + sizeof(int32_t) * 10);
+		EXPECT_EQ(shared.UseCount(), 2);
+
+		// 하나의 버퍼에 들어있으면 그대로 공유
+		asd::BufferList single;
+		asd::Write(single, (int64_t)123);
+		const uint8_t* org = single.at(0)->GetBuffer();
+		asd::SharedBuffer shared2(std::move(single));
+		EXPECT_EQ(shared2.GetBuffer(), org);
+		EXPECT_EQ(shared2.GetSize(), sizeof(int64_t));
+	}
+
+
+	template <typename T>
+	void Test_Varint(T in, size_t expectBytes)
+	{
+		for (int b=0; b<2; ++b) {
+			// b==1 이면 버퍼 경계에 걸치도록 작은 버퍼 사용
+			asd::BufferList buf;
+			for (int i=0; b==1 && i<5; ++i)
+				buf.ReserveBuffer(asd::Buffer_ptr(new SmallBuf));
+
+			EXPECT_EQ(expectBytes, asd::Write(buf, asd::Compact(in)));
+			T out = 0;
+			EXPECT_EQ(expectBytes, asd::Read(buf, asd::Compact(out)));
+			EXPECT_EQ(in, out);
+			EXPECT_FALSE(buf.Readable(1));
+		}
+	}
+
+	TEST(Serialize, Varint)
+	{
+		Test_Varint<uint8_t>(0, 1);
+		Test_Varint<uint16_t>(127, 1);
+		Test_Varint<uint16_t>(128, 2);
+		Test_Varint<uint32_t>(16383, 2);
+		Test_Varint<uint32_t>(16384, 3);
+		Test_Varint<uint64_t>(std::numeric_limits<uint64_t>::max(), 10);
+		Test_Varint<int8_t>(-1, 1);
+		Test_Varint<int16_t>(63, 1);
+		Test_Varint<int16_t>(-64, 1);
+		Test_Varint<int16_t>(64, 2);
+		Test_Varint<int32_t>(std::numeric_limits<int32_t>::min(), 5);
+		Test_Varint<int64_t>(std::numeric_limits<int64_t>::max(), 10);
+		Test_Varint<int64_t>(std::numeric_limits<int64_t>::min(), 10);
+
+		// 타입 범위를 넘는 값은 읽지 않는다.
+		asd::BufferList buf;
+		asd::Write(buf, asd::Compact((uint32_t)70000));
+		uint16_t small = 0;
+		EXPECT_EQ(0, asd::Read(buf, asd::Compact(small)));
+		uint32_t large = 0;
+		EXPECT_EQ(3, asd::ReadVarint(buf, large));
+		EXPECT_EQ(70000, large);
+
+		// 불완전한 데이터
+		const uint8_t broken[] = { 0x80, 0x80 };
+		buf.Write(broken, sizeof(broken));
+		EXPECT_EQ(0, asd::ReadVarint(buf, large));
+		EXPECT_TRUE(buf.Readable(sizeof(broken)));
+	}
+
+	TEST(Serialize, Varint_Container)
+	{
+		asd::BufferList buf;
+		const std::vector<int32_t> vec = { 0, -1, 300, -70000 };
+		const std::map<uint16_t, int64_t> map = { {1, -1}, {2, 1LL << 40} };
+		EXPECT_EQ(1 + sizeof(int32_t)*vec.size(), asd::Write(buf, asd::Compact(vec)));
+		EXPECT_GT(asd::Write(buf, asd::Compact(map)), 0);
+
+		std::vector<int32_t> vec2;
+		std::map<uint16_t, int64_t> map2;
+		EXPECT_GT(asd::Read(buf, asd::Compact(vec2)), 0);
+		EXPECT_GT(asd::Read(buf, asd::Compact(map2)), 0);
+		EXPECT_EQ(vec, vec2);
+		EXPECT_EQ(map, map2);
+	}
+
+	TEST(Serialize, Varint_Container_InvalidCount)
+	{
+		// 상대방이 보낸 잘못된 원소 수는 assert 없이 실패하고, 버퍼와 컨테이너는 그대로 둔다.
+		struct CountAssert : public asd::AssertHandler
+		{
+			size_t m_count = 0;
+			virtual void OnError(const asd::DebugInfo& a_info) override
+			{
+				++m_count;
+			}
+		};
+		auto handler = std::make_shared<CountAssert>();
+		auto prevHandler = asd::GetAssertHandler();
+		asd::SetAssertHandler(handler);
+
+		std::vector<int32_t> vec = { 7 };
+		const auto origin = vec;
+
+		asd::BufferList buf;
+		EXPECT_EQ(3, asd::WriteVarint(buf, (uint32_t)std::numeric_limits<asd::DefaultCountType>::max() + 1));
+		EXPECT_EQ(0, asd::Read(buf, asd::Compact(vec)));
+		EXPECT_TRUE(buf.Readable(3));
+		EXPECT_EQ(origin, vec);
+
+		// 남은 데이터로는 읽을 수 없는 원소 수
+		asd::BufferList buf2;
+		EXPECT_EQ(3, asd::WriteVarint(buf2, (uint32_t)std::numeric_limits<asd::DefaultCountType>::max()));
+		const int32_t one = 1;
+		asd::Write(buf2, one);
+		EXPECT_EQ(0, asd::Read(buf2, asd::Compact(vec)));
+		EXPECT_TRUE(buf2.Readable(3 + sizeof(one)));
+		EXPECT_EQ(origin, vec);
+
+		asd::SetAssertHandler(prevHandler);
+		EXPECT_EQ(0, handler->m_count);
+	}
+
+	TEST(Serialize, Varint_Benchmark)
+	{
+		const size_t Count = 1000 * 1000;
+		std::vector<uint32_t> ids(Count);
+		for (size_t i=0; i<Count; ++i)
+			ids[i] = (uint32_t)(i % 3000); // 대부분 작은 ID
+
+		typedef std::chrono::high_resolution_clock Clock;
+		auto Ns = [](Clock::duration d) { return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(); };
+
+		for (int compact=0; compact<2; ++compact) {
+			asd::BufferList buf;
+			auto t0 = Clock::now();
+			for (auto id : ids) {
+				if (compact)
+					asd::Write(buf, asd::Compact(id));
+				else
+					asd::Write(buf, id);
+			}
+			auto t1 = Clock::now();
+			const size_t bytes = buf.GetTotalSize();
+			uint64_t sum = 0;
+			for (size_t i=0; i<Count; ++i) {
+				uint32_t id;
+				if (compact)
+					EXPECT_GT(asd::Read(buf, asd::Compact(id)), 0);
+				else
+					EXPECT_GT(asd::Read(buf, id), 0);
+				sum += id;
+			}
+			auto t2 = Clock::now();
+			EXPECT_GT(sum, 0);
+
+			asd::puts(asd::MString::Format("  {} : {} bytes, write {:.2f} ns/op, read {:.2f} ns/op",
+										   compact ? "varint" : "fixed ",
+										   bytes,
+										   Ns(t1 - t0) / Count,
+										   Ns(t2 - t1) / Count));
+		}
+	}
+
+
+	TEST(Serialize, BufferList_Spans)
+	{
+		const uint8_t external[] = { 10, 11, 12, 13, 14, 15, 16, 17 };
+		bool released = false;
+
+		asd::BufferList list;
+		asd::Write(list, (int32_t)1);
+		asd::Write(list, (int32_t)2);
+		list.AppendExternal(asd::Span(external, sizeof(external)), [&released]() { released = true; });
+		asd::Write(list, (int32_t)3);
+		EXPECT_EQ(list.GetTotalSize(), sizeof(int32_t)*3 + sizeof(external));
+
+		// 외부 메모리는 복사 없이 그대로 연결된다.
+		std::vector<asd::Span> spans;
+		EXPECT_EQ(list.PeekSpans(spans), list.GetTotalSize());
+		ASSERT_EQ(spans.size(), 3);
+		EXPECT_EQ(spans[0].Size, sizeof(int32_t)*2);
+		EXPECT_EQ(spans[1].Data, external);
+		EXPECT_EQ(spans[1].Size, sizeof(external));
+		EXPECT_EQ(spans[2].Size, sizeof(int32_t));
+
+		// advance
+		EXPECT_EQ(list.Advance(sizeof(int32_t) + 1), sizeof(int32_t) + 1);
+		EXPECT_EQ(list.PeekSpans(spans, 5), 5);
+		ASSERT_EQ(spans.size(), 2);
+		EXPECT_EQ(spans[0].Size, 3);
+		EXPECT_EQ(spans[1].Data, external);
+		EXPECT_EQ(spans[1].Size, 2);
+
+		// rollback
+		{
+			asd::Transactional<asd::BufOp::Read> tran(list);
+			EXPECT_EQ(list.Advance(100), 0);
+			EXPECT_EQ(list.Advance(3 + 4), 3 + 4);
+		}
+		uint8_t tail[3];
+		EXPECT_EQ(list.Read(tail, sizeof(tail)), sizeof(tail));
+		uint8_t ext[sizeof(external)];
+		EXPECT_EQ(list.Read(ext, sizeof(ext)), sizeof(ext));
+		EXPECT_EQ(0, std::memcmp(ext, external, sizeof(external)));
+		int32_t last = 0;
+		EXPECT_EQ(asd::Read(list, last), sizeof(int32_t));
+		EXPECT_EQ(last, 3);
+		EXPECT_EQ(list.PeekSpans(spans), 0);
+		EXPECT_TRUE(spans.empty());
+
+		EXPECT_FALSE(released);
+		list.Clear();
+		EXPECT_TRUE(released);
+	}
+
+
+	TEST(Serialize, BufferQueue)
+	{
+		typedef asd::InlineDeque<std::unique_ptr<int>, 4> Queue;
+		Queue queue;
+		EXPECT_EQ(queue.capacity(), 4);
+
+		// 내부 공간에서 wrap-around
+		for (int i=0; i<3; ++i)
+			queue.emplace_back(new int(i));
+		queue.pop_front();
+		queue.pop_front();
+		queue.emplace_back(new int(3));
+		queue.emplace_back(new int(4));
+		queue.emplace_front(new int(1));
+		EXPECT_EQ(queue.capacity(), 4);
+		ASSERT_EQ(queue.size(), 4);
+		for (int i=0; i<4; ++i)
+			EXPECT_EQ(*queue[i], i + 1);
+
+		// 힙으로 이동
+		for (int i=5; i<20; ++i)
+			queue.emplace_back(new int(i));
+		EXPECT_EQ(queue.capacity(), 32);
+		int expect = 1;
+		for (auto& it : queue)
+			EXPECT_EQ(*it, expect++);
+		expect = 19;
+		for (auto it=queue.rbegin(); it!=queue.rend(); ++it)
+			EXPECT_EQ(**it, expect--);
+
+		// move
+		Queue moved(std::move(queue));
+		EXPECT_TRUE(queue.empty());
+		EXPECT_EQ(queue.capacity(), 4);
+		ASSERT_EQ(moved.size(), 19);
+		EXPECT_EQ(*moved.front(), 1);
+		EXPECT_EQ(*moved.back(), 19);
+
+		// 내부 공간으로 복귀
+		moved.resize(2);
+		moved.shrink_to_fit();
+		EXPECT_EQ(moved.capacity(), 4);
+		EXPECT_EQ(*moved.at(1), 2);
+
+		queue = std::move(moved);
+		EXPECT_TRUE(moved.empty());
+		ASSERT_EQ(queue.size(), 2);
+		EXPECT_EQ(*queue[0], 1);
+	}
+
+
+	TEST(Serialize, RingBuffer)
+	{
+		asd::RingBuffer ring(1024);
+		EXPECT_EQ(ring.GetSize(), 0);
+		EXPECT_TRUE(ring.Peek().Empty());
+
+		// write
+		ASSERT_TRUE(ring.Reserve(100));
+		ASSERT_GE(ring.GetWritable(), 100);
+		for (int i=0; i<100; ++i)
+			ring.GetWritePtr()[i] = (uint8_t)i;
+		ring.Commit(100);
+		EXPECT_EQ(ring.GetSize(), 100);
+
+		// 읽기 구간은 항상 연속
+		auto span = ring.Peek();
+		ASSERT_EQ(span.Size, 100);
+		for (int i=0; i<100; ++i)
+			EXPECT_EQ(span.Data[i], (uint8_t)i);
+		ring.Consume(60);
+		span = ring.Peek();
+		ASSERT_EQ(span.Size, 40);
+		EXPECT_EQ(span.Data[0], 60);
+
+		// compaction
+		const size_t cap = ring.Capacity();
+		ASSERT_TRUE(ring.Reserve(cap - 40));
+		EXPECT_EQ(ring.Capacity(), cap);
+		span = ring.Peek();
+		ASSERT_EQ(span.Size, 40);
+		EXPECT_EQ(span.Data[0], 60);
+		EXPECT_EQ(span.Data[39], 99);
+
+		// grow
+		ASSERT_TRUE(ring.Reserve(cap));
+		EXPECT_GT(ring.Capacity(), cap);
+		span = ring.Peek();
+		ASSERT_EQ(span.Size, 40);
+		EXPECT_EQ(span.Data[0], 60);
+
+		// limit
+		ASSERT_TRUE(ring.Reserve(2000));
+		EXPECT_LE(ring.GetSize() + ring.GetWritable(), 1024);
+		ring.Commit(1024 - ring.GetSize());
+		EXPECT_EQ(ring.GetSize(), 1024);
+		EXPECT_FALSE(ring.Reserve(1));
+
+		// 다 읽으면 처음으로 돌아간다
+		ring.Consume(ring.GetSize());
+		EXPECT_EQ(ring.GetSize(), 0);
+		EXPECT_EQ(ring.GetWritable(), ring.Capacity());
+		ring.Shrink();
+		EXPECT_EQ(ring.Capacity(), 0);
+	}
+}
+
+
+
+
+namespace asdtest_serialize
+{
+	struct PodPoint
+	{
+		int32_t x;
+		int32_t y;
+		float z;
+
+		bool operator == (const PodPoint& a_other) const
+		{
+			return x == a_other.x && y == a_other.y && z == a_other.z;
+		}
+	};
+}
+asd_Declare_PodSerializable(asdtest_serialize::PodPoint);
+
+namespace asdtest_serialize
+{
+	TEST(Serialize, PodBulk)
+	{
+		const size_t Count = 1000;
+		std::vector<PodPoint> src(Count);
+		for (size_t i=0; i<Count; ++i)
+			src[i] = PodPoint{(int32_t)i, -(int32_t)i, i * 0.5f};
+
+		// 작은 버퍼 여러개에 걸쳐서 한번에 복사된다.
+		auto bufferList = asd::BufferList::New();
+		for (int i=0; i<5000; ++i)
+			bufferList->ReserveBuffer(asd::Buffer_ptr(new SmallBuf));
+
+		const size_t Bytes = sizeof(asd::DefaultCountType) + sizeof(PodPoint)*Count;
+		EXPECT_EQ(asd::Write(*bufferList, src), Bytes);
+		EXPECT_EQ(asd::Write(*bufferList, src[7]), sizeof(PodPoint));
+
+		std::array<PodPoint, 3> arr = {{ src[1], src[2], src[3] }};
+		EXPECT_EQ(asd::Write(*bufferList, arr), sizeof(arr));
+
+		std::vector<PodPoint> dst;
+		EXPECT_EQ(asd::Read(*bufferList, dst), Bytes);
+		EXPECT_EQ(src, dst);
+
+		PodPoint one;
+		EXPECT_EQ(asd::Read(*bufferList, one), sizeof(PodPoint));
+		EXPECT_EQ(one, src[7]);
+
+		std::array<PodPoint, 3> arr2;
+		EXPECT_EQ(asd::Read(*bufferList, arr2), sizeof(arr2));
+		EXPECT_EQ(arr, arr2);
+
+		// 데이터가 덜 도착했으면 vector를 건드리지 않고 실패
+		asd::BufferList partial;
+		asd::Write(partial, (asd::DefaultCountType)Count);
+		asd::Write(partial, src.data(), Count - 1);
+		dst.clear();
+		EXPECT_EQ(asd::Read(partial, dst), 0);
+		EXPECT_TRUE(dst.empty());
+		EXPECT_EQ(partial.GetTotalSize(), sizeof(asd::DefaultCountType) + sizeof(PodPoint)*(Count-1));
+	}
+
+
+	TEST(Serialize, Endian_BulkSwap)
+	{
+		// 스왑용 임시 영역보다 큰 배열
+		const size_t Count = 1000;
+		std::vector<uint32_t> src(Count);
+		for (size_t i=0; i<Count; ++i)
+			src[i] = (uint32_t)(i * 0x01020304);
+
+		asd::BufferList buf;
+		EXPECT_EQ((asd::Write_PrimitiveArray<asd::Endian::Big, uint32_t>(buf, src.data(), Count)),
+				  sizeof(uint32_t)*Count);
+
+		std::vector<uint32_t> raw(Count);
+		EXPECT_EQ(asd::Read(buf, raw.data(), Count), sizeof(uint32_t)*Count);
+		for (size_t i=0; i<Count; ++i) {
+			if (raw[i] != htonl(src[i])) {
+				EXPECT_EQ(raw[i], htonl(src[i]));
+				break;
+			}
+		}
+
+		asd::Write(buf, raw.data(), Count);
+		std::vector<uint32_t> dst(Count);
+		EXPECT_EQ((asd::Read_PrimitiveArray<asd::Endian::Big, uint32_t>(buf, dst.data(), Count)),
+				  sizeof(uint32_t)*Count);
+		EXPECT_EQ(src, dst);
+	}
+}
+
+
+namespace asdtest_serialize
+{
+	TEST(Serialize, String)
+	{
+		const std::string src = "abcdefghijklmnopqrstuvwxyz";
+		const std::u16string src16 = u"가나다라마바사";
+
+		asd::BufferList buf;
+		for (int i=0; i<100; ++i)
+			buf.ReserveBuffer(asd::Buffer_ptr(new SmallBuf));
+		EXPECT_EQ(asd::Write(buf, src), sizeof(asd::DefaultCountType) + src.size());
+		EXPECT_EQ(asd::Write(buf, src16), sizeof(asd::DefaultCountType) + src16.size()*2);
+		EXPECT_EQ(asd::Write(buf, std::string()), sizeof(asd::DefaultCountType));
+
+		std::string dst = "garbage";
+		std::u16string dst16;
+		EXPECT_GT(asd::Read(buf, dst), 0);
+		EXPECT_GT(asd::Read(buf, dst16), 0);
+		EXPECT_EQ(src, dst);
+		EXPECT_EQ(src16, dst16);
+		EXPECT_EQ(asd::Read(buf, dst), sizeof(asd::DefaultCountType));
+		EXPECT_TRUE(dst.empty());
+		EXPECT_EQ(asd::Read(buf, dst), 0);
+	}
+
+
+	TEST(Serialize, MessageView)
+	{
+		const std::string name = "MessageView";
+		const std::vector<uint8_t> blob(1000, 0xAB);
+
+		asd::BufferList buf;
+		asd::Write(buf, name);
+		asd::Write(buf, (int32_t)123);
+		asd::Write(buf, blob);
+
+		// 버퍼 경계에 걸친 데이터 (인라인 scratch 크기를 넘는 것 포함)
+		asd::BufferList small;
+		for (int i=0; i<1000; ++i)
+			small.ReserveBuffer(asd::Buffer_ptr(new SmallBuf));
+		asd::Write(small, name);
+		asd::Write(small, blob);
+
+		{
+			asd::MessageView view(buf);
+			EXPECT_EQ(buf.GetViewCount(), 1);
+
+			const uint8_t* head = buf.PeekContiguous().Data;
+			asd::StringView str;
+			int32_t num = 0;
+			asd::Span bin;
+			EXPECT_EQ(view.Read(str), sizeof(asd::DefaultCountType) + name.size());
+			EXPECT_EQ(view.Read(num), sizeof(int32_t));
+			EXPECT_EQ(view.Read(bin), sizeof(asd::DefaultCountType) + blob.size());
+			EXPECT_EQ(view.Read(str), 0);
+
+			// 복사 없이 수신 버퍼를 가리킨다.
+			EXPECT_EQ((const uint8_t*)str.Data, head + sizeof(asd::DefaultCountType));
+			EXPECT_TRUE(str == name);
+			EXPECT_EQ(num, 123);
+			ASSERT_EQ(bin.Size, blob.size());
+			EXPECT_EQ(0, std::memcmp(bin.Data, blob.data(), blob.size()));
+
+			asd::MessageView view2(small);
+			asd::StringView str2;
+			asd::Span bin2;
+			EXPECT_GT(view2.Read(str2), 0);
+			EXPECT_GT(view2.Read(bin2), 0);
+			EXPECT_EQ(str2.ToString(), name);
+			ASSERT_EQ(bin2.Size, blob.size());
+			EXPECT_EQ(0, std::memcmp(bin2.Data, blob.data(), blob.size()));
+
+			// 나중에 읽은 뷰 때문에 앞의 뷰가 깨지지 않는다.
+			EXPECT_TRUE(str2 == name);
+		}
+		EXPECT_EQ(buf.GetViewCount(), 0);
+		EXPECT_EQ(small.GetViewCount(), 0);
+	}
+}
+
+
+namespace asdtest_serialize
+{
+	static_assert(asd::SerializedSizeOf<int32_t>::Value == 4, "");
+	static_assert(asd::SerializedSizeOf<PodPoint>::Value == sizeof(PodPoint), "");
+	static_assert(asd::SerializedSizeOf<std::tuple<int8_t, double, std::array<uint16_t, 3>>>::Value == 15, "");
+	static_assert(asd::SerializedSizeOf<std::pair<int32_t, std::string>>::IsFixed == false, "");
+
+	template <typename T>
+	void Test_SerializedSize(const T& a_data)
+	{
+		asd::BufferList buf;
+		const size_t bytes = asd::Write(buf, a_data);
+		EXPECT_GT(bytes, 0);
+		EXPECT_EQ(asd::SerializedSize(a_data), bytes);
+
+		// 한 개의 버퍼에 같은 내용으로 직렬화된다.
+		asd::Buffer_ptr one = asd::Serialize(a_data);
+		ASSERT_NE(one, nullptr);
+		ASSERT_EQ(one->GetSize(), bytes);
+		std::vector<uint8_t> expect(bytes);
+		EXPECT_EQ(buf.Read(expect.data(), bytes), bytes);
+		EXPECT_EQ(0, std::memcmp(one->GetBuffer(), expect.data(), bytes));
+
+		asd::BufferList in;
+		in.PushBack(std::move(one));
+		T out;
+		EXPECT_EQ(asd::Read(in, out), bytes);
+		EXPECT_TRUE(a_data == out);
+	}
+
+	TEST(Serialize, SerializedSize)
+	{
+		Test_SerializedSize((int64_t)-1);
+		Test_SerializedSize(PodPoint{1, 2, 3.0f});
+		Test_SerializedSize(std::string("SerializedSize"));
+		Test_SerializedSize(std::vector<int32_t>(50000, 7));
+		Test_SerializedSize(std::vector<std::string>{"a", "bc", "", "def"});
+		Test_SerializedSize(std::make_pair((uint16_t)1, std::string("pair")));
+		Test_SerializedSize(std::make_tuple((int8_t)1, std::vector<double>{1.5, 2.5}, std::string("tuple")));
+
+		std::map<int32_t, std::vector<uint8_t>> m;
+		for (int i=0; i<100; ++i)
+			m[i].resize(i);
+		Test_SerializedSize(m);
+
+		std::set<std::string> set = { "x", "yy", "zzz" };
+		Test_SerializedSize(set);
+
+		// Compact 래퍼는 varint 크기 (컨테이너는 원소 수만 varint)
+		std::vector<uint32_t> ids = { 1, 300, 70000 };
+		EXPECT_EQ(asd::SerializedSize(asd::Compact((uint32_t)127)), 1);
+		EXPECT_EQ(asd::SerializedSize(asd::Compact((int32_t)-65)), 2);
+		EXPECT_EQ(asd::SerializedSize(asd::Compact(ids)), 1 + 4*3);
+
+		// SerializedSize()를 구현하지 않은 사용자 정의 타입은 직접 써서 잰다.
+		CustomStruct custom;
+		custom.data1 = 1;
+		custom.data4[1][2] = 3;
+		asd::BufferList buf;
+		EXPECT_EQ(asd::SerializedSize(custom), asd::Write(buf, custom));
+	}
+}
+
+
+namespace asdtest_serialize
+{
+	struct FusedCustomStruct
+	{
+		int data1;
+		double data2;
+		std::vector<uint16_t> data3;
+		std::unordered_map<int, std::map<int, double>> data4;
+
+		asd_Serialize_Fields(data1, data2, data3, data4)
+	};
+
+	// 필드마다 Write/Read 하는 기존 방식
+	struct ManualFixedStruct
+	{
+		int32_t id;
+		int64_t time;
+		float x, y, z;
+		uint16_t flag;
+
+		inline size_t WriteTo(asd::BufferList& buffer) const
+		{
+			asd::Transactional<asd::BufOp::Write> tran(buffer);
+			size_t sum = 0;
+			for (size_t ret : { asd::Write(buffer, id),
+								asd::Write(buffer, time),
+								asd::Write(buffer, x),
+								asd::Write(buffer, y),
+								asd::Write(buffer, z),
+								asd::Write(buffer, flag) }) {
+				if (ret == 0)
+					return 0;
+				sum += ret;
+			}
+			return tran.SetResult(sum);
+		}
+
+		inline size_t ReadFrom(asd::BufferList& buffer)
+		{
+			asd::Transactional<asd::BufOp::Read> tran(buffer);
+			size_t sum = 0;
+			for (size_t ret : { asd::Read(buffer, id),
+								asd::Read(buffer, time),
+								asd::Read(buffer, x),
+								asd::Read(buffer, y),
+								asd::Read(buffer, z),
+								asd::Read(buffer, flag) }) {
+				if (ret == 0)
+					return 0;
+				sum += ret;
+			}
+			return tran.SetResult(sum);
+		}
+	};
+
+	struct FusedFixedStruct
+	{
+		int32_t id;
+		int64_t time;
+		float x, y, z;
+		uint16_t flag;
+
+		asd_Serialize_Fields(id, time, x, y, z, flag)
+
+		inline bool operator == (const FusedFixedStruct& r) const
+		{
+			return id==r.id && time==r.time && x==r.x && y==r.y && z==r.z && flag==r.flag;
+		}
+	};
+
+
+	TEST(Serialize, Fields)
+	{
+		FusedFixedStruct fixed = { 1, -2, 3.5f, 4.5f, 5.5f, 6 };
+		EXPECT_EQ(asd::SerializedSize(fixed), 4+8+4*3+2);
+		Test_WriteRead<FusedFixedStruct, SmallBuf>(fixed);
+		Test_WriteRead<FusedFixedStruct, LargeBuf>(fixed);
+
+		// 기존 방식과 같은 포맷
+		CustomStruct manual;
+		manual.data1 = 123;
+		manual.data2 = 4.56;
+		manual.data3 = { 1, 2, 3 };
+		for (int h=0; h<=9; ++h) {
+			for (int w=0; w<=9; ++w)
+				manual.data4[h][w] = h + w/10.0;
+		}
+		asd::BufferList buf;
+		const size_t bytes = asd::Write(buf, manual);
+
+		FusedCustomStruct fused;
+		EXPECT_EQ(asd::Read(buf, fused), bytes);
+		EXPECT_EQ(asd::SerializedSize(fused), bytes);
+		EXPECT_EQ(fused.data1, manual.data1);
+		EXPECT_EQ(fused.data2, manual.data2);
+		EXPECT_EQ(fused.data3, manual.data3);
+		EXPECT_EQ(fused.data4, manual.data4);
+
+		// 데이터가 부족하면 읽기 오프셋이 그대로
+		asd::BufferList partial;
+		asd::Write(partial, fixed);
+		std::vector<uint8_t> raw(partial.GetTotalSize() - 1);
+		partial.Read(raw.data(), raw.size());
+		asd::BufferList incomplete;
+		incomplete.Write(raw.data(), raw.size());
+		FusedFixedStruct out;
+		EXPECT_EQ(asd::Read(incomplete, out), 0);
+		EXPECT_TRUE(incomplete.Readable(raw.size()));
+	}
+
+
+	static_assert(asd::SerializedSizeOf<FusedFixedStruct>::IsPackable, "");
+	static_assert(asd::SerializedSizeOf<FusedCustomStruct>::IsPackable, "");
+	static_assert(asd::SerializedSizeOf<std::map<int32_t, std::vector<std::string>>>::IsPackable, "");
+	static_assert(asd::SerializedSizeOf<CustomStruct>::IsPackable == false, "");
+
+	template <typename T>
+	void Test_Serialize(const T& a_data)
+	{
+		asd::BufferList buf;
+		const size_t bytes = asd::Write(buf, a_data);
+		ASSERT_GT(bytes, 0);
+
+		asd::Buffer_ptr one = asd::Serialize(a_data);
+		ASSERT_NE(one, nullptr);
+		ASSERT_EQ(one->GetSize(), bytes);
+		std::vector<uint8_t> expect(bytes);
+		EXPECT_EQ(buf.Read(expect.data(), bytes), bytes);
+		EXPECT_EQ(0, std::memcmp(one->GetBuffer(), expect.data(), bytes));
+	}
+
+	TEST(Serialize, Pack)
+	{
+		// 용량 확인 없이 바로 쓰는 경로
+		Test_Serialize(FusedFixedStruct{ 1, -2, 3.5f, 4.5f, 5.5f, 6 });
+
+		FusedCustomStruct fused;
+		fused.data1 = 123;
+		fused.data2 = 4.56;
+		fused.data3 = { 1, 2, 3 };
+		for (int h=0; h<=9; ++h) {
+			for (int w=0; w<=9; ++w)
+				fused.data4[h][w] = h + w/10.0;
+		}
+		Test_Serialize(fused);
+
+		std::vector<uint32_t> ids = { 1, 300, 70000 };
+		Test_Serialize(asd::Compact(ids));
+		Test_Serialize(asd::Compact((int64_t)-123456789));
+
+		// 개수 제한을 넘으면 실패
+		EXPECT_EQ(asd::Serialize(std::vector<std::string>(65536)), nullptr);
+
+		// PackTo가 없는 사용자 정의 타입은 Write 경로
+		CustomStruct custom;
+		custom.data1 = 1;
+		custom.data4[1][2] = 3;
+		Test_Serialize(custom);
+	}
+
+
+	template <typename T>
+	void Bench_Fields(const char* a_name, const T& a_src, size_t a_count)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		auto Ns = [](Clock::duration d) { return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(); };
+
+		asd::BufferList buf;
+		auto t0 = Clock::now();
+		for (size_t i=0; i<a_count; ++i)
+			asd::Write(buf, a_src);
+		auto t1 = Clock::now();
+		T dst;
+		size_t fail = 0;
+		for (size_t i=0; i<a_count; ++i)
+			fail += asd::Read(buf, dst) == 0;
+		auto t2 = Clock::now();
+		EXPECT_EQ(fail, 0);
+
+		asd::puts(asd::MString::Format("  {} : write {:.2f} ns/op, read {:.2f} ns/op",
+									   a_name,
+									   Ns(t1 - t0) / a_count,
+									   Ns(t2 - t1) / a_count));
+	}
+
+	TEST(Serialize, Fields_Benchmark)
+	{
+		const size_t Count = 300 * 1000;
+		ManualFixedStruct manualFixed = { 1, -2, 3.5f, 4.5f, 5.5f, 6 };
+		FusedFixedStruct fusedFixed = { 1, -2, 3.5f, 4.5f, 5.5f, 6 };
+		Bench_Fields("fixed manual", manualFixed, Count);
+		Bench_Fields("fixed fused ", fusedFixed, Count);
+
+		CustomStruct manual;
+		manual.data1 = 1;
+		manual.data2 = 2;
+		manual.data3.resize(16);
+		FusedCustomStruct fused;
+		fused.data1 = 1;
+		fused.data2 = 2;
+		fused.data3.resize(16);
+		Bench_Fields("mixed manual", manual, Count);
+		Bench_Fields("mixed fused ", fused, Count);
+	}
 }
 
+
+#if asd_Support_FlatBuffers
+namespace asdtest_serialize
+{
+	// 스키마 없이 테스트하기 위한 루트 테이블 대용
+	struct FakeRoot
+	{
+		uint32_t value;
+
+		inline bool Verify(flatbuffers::Verifier&) const
+		{
+			return value != 0xDEADBEEF;
+		}
+	};
+
+	// [root offset = 8][padding][value]
+	std::vector<uint8_t> MakeFakeFlatBuffer(uint32_t a_value)
+	{
+		std::vector<uint8_t> ret(12, 0);
+		const uint32_t offset = 8;
+		std::memcpy(&ret[0], &offset, 4);
+		std::memcpy(&ret[8], &a_value, 4);
+		return ret;
+	}
+
+	TEST(Serialize, FlatBuffersMessage)
+	{
+		const auto msg = MakeFakeFlatBuffer(777);
+
+		// 여러 버퍼에 걸친 메시지를 하나의 정렬된 버퍼로 모은다.
+		asd::BufferList list;
+		for (int i=0; i<10; ++i)
+			list.ReserveBuffer(asd::Buffer_ptr(new SmallBuf));
+		list.Write(msg.data(), msg.size());
+		list.Write(msg.data(), msg.size());
+
+		asd::FlatBuffersMessage<FakeRoot> fb;
+		EXPECT_TRUE(fb.Read(list, msg.size()));
+		ASSERT_TRUE((bool)fb);
+		EXPECT_EQ(fb->value, 777);
+		EXPECT_EQ(0, (uintptr_t)fb.GetData().Data % asd_FlatBuffers_Alignment);
+		EXPECT_EQ(list.GetTotalSize() - msg.size(), msg.size());
+
+		// 정렬된 뷰는 복사하지 않는다.
+		alignas(8) uint8_t aligned[32];
+		std::memcpy(aligned, msg.data(), msg.size());
+		EXPECT_TRUE(fb.Assign(asd::Span(aligned, msg.size())));
+		EXPECT_EQ(fb.GetData().Data, aligned);
+		EXPECT_EQ(fb->value, 777);
+
+		// 정렬되지 않은 뷰는 복사한다.
+		std::memcpy(aligned + 1, msg.data(), msg.size());
+		EXPECT_TRUE(fb.Assign(asd::Span(aligned + 1, msg.size())));
+		EXPECT_NE(fb.GetData().Data, aligned + 1);
+		EXPECT_EQ(0, (uintptr_t)fb.GetData().Data % asd_FlatBuffers_Alignment);
+		EXPECT_EQ(fb->value, 777);
+
+		// 수신 버퍼의 소유권을 가져온다.
+		auto buf = asd::NewBuffer(msg.size());
+		std::memcpy(buf->GetBuffer(), msg.data(), msg.size());
+		buf->SetSize(msg.size());
+		const uint8_t* raw = buf->GetBuffer();
+		EXPECT_TRUE(fb.Assign(std::move(buf)));
+		EXPECT_EQ(fb.GetData().Data, raw);
+
+		// 검증 실패 시 읽기 오프셋이 그대로
+		const auto bad = MakeFakeFlatBuffer(0xDEADBEEF);
+		asd::BufferList badList;
+		badList.Write(bad.data(), bad.size());
+		EXPECT_FALSE(fb.Read(badList, bad.size()));
+		EXPECT_FALSE((bool)fb);
+		EXPECT_TRUE(badList.Readable(bad.size()));
+	}
+}
+#endif
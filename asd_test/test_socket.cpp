@@ -1,5 +1,6 @@
 ﻿#include "stdafx.h"
 #include "asd/ioevent.h"
+#include "asd/filebuffer.h"
 #include "asd/string.h"
 #include "asd/semaphore.h"
 #include "asd/threadpool.h"
@@ -7,6 +8,7 @@
 #include <thread>
 #include <array>
 #include <unordered_map>
+#include <chrono>
 
 namespace asdtest_socket
 {
@@ -45,6 +47,80 @@ namespace asdtest_socket
 		return 0;
 	}
 
+	// io_uring을 지원하지 않는 환경이면 epoll로 대체되므로, 메시지를 남기고 io_uring 테스트를 건너뛴다.
+	bool SkipWithoutIOUring()
+	{
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		asd::IOEvent io;
+		io.Start(1, option);
+		if (io.GetBackend() == asd::IOEventOption::Backend::IOUring)
+			return false;
+		asd::puts("io_uring is not supported, skipped");
+		return true;
+	}
+
+	// 임의의 포트에 리스너 하나를 열고 블로킹 클라이언트로 접속하는 테스트들의 공통 IOEvent
+	// 마지막으로 accept한 소켓과 OnClose를 기록하며, 소멸할 때 리스너를 닫는다.
+	struct ListenerTestIO : public asd::IOEvent
+	{
+		asd::AsyncSocketHandle m_listener;
+		asd::IpAddress m_addr;	// 클라이언트가 접속할 loopback 주소
+		asd::AsyncSocketHandle m_accepted;
+		asd::Semaphore m_accept;
+		asd::Semaphore m_close;
+
+		virtual ~ListenerTestIO()
+		{
+			auto listener = m_listener.Free();
+			if (listener != nullptr)
+				listener->Close();
+		}
+
+		// IO 쓰레드를 시작하고 리스너를 등록한다.
+		bool Listen(uint32_t a_threadCount,
+					const asd::IOEventOption& a_option,
+					asd::AddressFamily a_af = asd::AddressFamily::IPv4)
+		{
+			Start(a_threadCount, a_option);
+			auto sock = m_listener.Alloc();
+			if (RegisterListener(sock, asd::IpAddress(Addr_Any(a_af), 0), 1024) == false)
+				return false;
+			asd::IpAddress bound;
+			if (sock->GetSockName(bound) != 0)
+				return false;
+			m_addr = asd::IpAddress(Addr_Loopback(a_af), bound.GetPort());
+			return true;
+		}
+
+		int Connect(asd::Socket& a_client) const
+		{
+			return a_client.Connect(m_addr);
+		}
+
+		// 접속 후 서버측 소켓을 기다린다.
+		asd::AsyncSocket_ptr WaitAccept()
+		{
+			if (m_accept.Wait(10 * 1000) == false)
+				return nullptr;
+			return m_accepted.GetObj();
+		}
+
+		virtual void OnAccept(asd::AsyncSocket* a_listener,
+							  asd::AsyncSocket_ptr&& a_newSock) override
+		{
+			m_accepted = asd::AsyncSocketHandle::GetHandle(a_newSock.get());
+			asd::IOEvent::OnAccept(a_listener, std::move(a_newSock));
+			m_accept.Post();
+		}
+
+		virtual void OnClose(asd::AsyncSocket* a_sock,
+							 asd::Socket::Error a_err) override
+		{
+			m_close.Post();
+		}
+	};
+
 
 
 	void TCP_Blocked(asd::AddressFamily af)
@@ -269,11 +345,13 @@ namespace asdtest_socket
 		}
 	};
 
-	void TCP_NonBlocked(asd::AddressFamily af)
+	void TCP_NonBlocked(asd::AddressFamily af,
+						const asd::IOEventOption& option = asd::IOEventOption(),
+						const size_t ClientCount = 1,
+						const uint32_t threadCount = asd::Get_HW_Concurrency())
 	{
 		static const size_t TotalDataSize = 1 * 1024 * 1024;
 		static const size_t SendSize = TotalDataSize / 1024;
-		static const size_t ClientCount = 1;
 
 		static asd::Semaphore s_finish;
 		static std::atomic<size_t> s_clientCount;
@@ -402,9 +480,29 @@ namespace asdtest_socket
 		{
 			PeerManager m_peerManager;
 
+			// 소켓마다 IO 쓰레드가 고정되는 경우 (PerThreadPoller, io_uring) 콜백을 호출한 쓰레드
+			// PerThreadPoller는 accept한 소켓이 리스너의 쓰레드에 남고, io_uring은 새로 배정된다.
+			bool m_checkAffinity = false;
+			bool m_acceptAffinity = false;
+			asd::Mutex m_affinityLock;
+			std::unordered_map<asd::AsyncSocketHandle, std::thread::id> m_ioThread;
+
+			void CheckAffinity(asd::AsyncSocket* a_sock)
+			{
+				if (m_checkAffinity == false)
+					return;
+				const auto handle = asd::AsyncSocketHandle::GetHandle(a_sock);
+				const auto tid = std::this_thread::get_id();
+				auto lock = asd::GetLock(m_affinityLock);
+				auto it = m_ioThread.emplace(handle, tid).first;
+				EXPECT_EQ(it->second, tid);
+			}
+
 			virtual void OnAccept(asd::AsyncSocket* a_listener,
 								  asd::AsyncSocket_ptr&& a_newSock) override
 			{
+				if (m_acceptAffinity)
+					CheckAffinity(a_newSock.get());
 				auto handle = asd::AsyncSocketHandle::GetHandle(a_listener);
 				auto listener = m_peerManager.Find(handle);
 				ASSERT_TRUE(listener != nullptr);
@@ -415,6 +513,7 @@ namespace asdtest_socket
 			virtual void OnConnect(asd::AsyncSocket* a_sock,
 								   asd::Socket::Error a_err) override
 			{
+				CheckAffinity(a_sock);
 				auto handle = asd::AsyncSocketHandle::GetHandle(a_sock);
 				auto peer = m_peerManager.Find(handle);
 				ASSERT_TRUE(peer != nullptr);
@@ -427,6 +526,7 @@ namespace asdtest_socket
 			virtual void OnRecv(asd::AsyncSocket* a_sock,
 								asd::Buffer_ptr&& a_data) override
 			{
+				CheckAffinity(a_sock);
 				auto handle = asd::AsyncSocketHandle::GetHandle(a_sock);
 				auto peer = m_peerManager.Find(handle);
 				ASSERT_TRUE(peer != nullptr);
@@ -452,8 +552,12 @@ namespace asdtest_socket
 
 		asd::IpAddress addr;
 		TestIO io;
-		io.Start();
+		io.Start(threadCount, option);
 		io.m_peerManager.m_threadPool.Start();
+#if !asd_Platform_Windows
+		io.m_checkAffinity = option.PerThreadPoller || io.GetBackend() == asd::IOEventOption::Backend::IOUring;
+		io.m_acceptAffinity = option.PerThreadPoller && io.GetBackend() == asd::IOEventOption::Backend::Native;
+#endif
 
 		// start server
 		{
@@ -477,6 +581,10 @@ namespace asdtest_socket
 
 		// wait finish
 		s_finish.Wait();
+		if (io.m_checkAffinity) {
+			auto lock = asd::GetLock(io.m_affinityLock);
+			EXPECT_GE(io.m_ioThread.size(), ClientCount * 2);
+		}
 
 		auto lock = asd::GetLock(io.m_peerManager.m_lock);
 		auto peers = std::move(io.m_peerManager.m_peers);
@@ -494,8 +602,1306 @@ namespace asdtest_socket
 		TCP_NonBlocked(asd::AddressFamily::IPv6);
 	}
 
-	void UDP_NonBlocked(asd::AddressFamily af)
+	TEST(Socket, IPv4_TCP_NonBlocked_PollBatch)
+	{
+		// 한번에 하나씩 가져오는 경우와 작은 배치로 나눠 가져오는 경우
+		asd::IOEventOption option;
+		option.PollBatchSize = 1;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option);
+		option.PollBatchSize = 2;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option);
+	}
+
+	TEST(Socket, IPv4_TCP_NonBlocked_PerThreadPoller)
+	{
+		// 여러 연결이 SO_REUSEPORT로 나눠진 리스너들에 분산되어도 정상 동작해야 한다.
+		asd::IOEventOption option;
+		option.PerThreadPoller = true;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+	}
+
+	TEST(Socket, IPv6_TCP_NonBlocked_PerThreadPoller)
+	{
+		asd::IOEventOption option;
+		option.PerThreadPoller = true;
+		TCP_NonBlocked(asd::AddressFamily::IPv6, option, 8, 4);
+	}
+
+	TEST(Socket, IPv4_TCP_NonBlocked_EdgeTriggered)
+	{
+		asd::IOEventOption option;
+		option.EdgeTriggered = true;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+
+		// 예산이 1이면 한번 읽을 때마다 다른 소켓들 뒤로 미뤄진다.
+		option.EdgeBudget = 1;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+
+		option.PerThreadPoller = true;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+	}
+
+	TEST(Socket, IPv6_TCP_NonBlocked_EdgeTriggered)
+	{
+		asd::IOEventOption option;
+		option.EdgeTriggered = true;
+		TCP_NonBlocked(asd::AddressFamily::IPv6, option, 8, 4);
+	}
+
+	TEST(Socket, IPv4_TCP_NonBlocked_IOUring)
+	{
+		if (SkipWithoutIOUring())
+			return;
+
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+	}
+
+	TEST(Socket, IPv6_TCP_NonBlocked_IOUring)
+	{
+		if (SkipWithoutIOUring())
+			return;
+
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		TCP_NonBlocked(asd::AddressFamily::IPv6, option, 8, 4);
+	}
+
+	// 거부된 연결은 OnConnect로 에러를 알려야 한다. (connect 전에 등록되면서 받는 EPOLLHUP과 구분)
+	void TCP_ConnectRefused(const asd::IOEventOption& option)
+	{
+		struct TestIO : public asd::IOEvent
+		{
+			asd::Semaphore m_connect;
+			std::atomic<asd::Socket::Error> m_error{0};
+
+			virtual void OnConnect(asd::AsyncSocket* a_sock,
+								   asd::Socket::Error a_err) override
+			{
+				m_error = a_err;
+				m_connect.Post();
+			}
+		};
+
+		// bind만 하고 listen하지 않은 포트
+		asd::Socket closed;
+		asd::IpAddress addr;
+		ASSERT_EQ(0, closed.Bind(asd::IpAddress(Addr_Loopback(asd::AddressFamily::IPv4), 0)));
+		ASSERT_EQ(0, closed.GetSockName(addr));
+
+		TestIO io;
+		io.Start(2, option);
+
+		asd::AsyncSocketHandle handle;
+		{
+			auto sock = handle.Alloc();
+			ASSERT_TRUE(io.RegisterConnector(sock, addr));
+		}
+		EXPECT_TRUE(io.m_connect.Wait(10 * 1000));
+		EXPECT_NE(0, io.m_error);
+
+		auto sock = handle.Free();
+		if (sock != nullptr)
+			sock->Close();
+	}
+
+	TEST(Socket, IPv4_TCP_ConnectRefused)
+	{
+		asd::IOEventOption option;
+		TCP_ConnectRefused(option);
+
+		option.EdgeTriggered = true;
+		TCP_ConnectRefused(option);
+
+		option.EdgeTriggered = false;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		TCP_ConnectRefused(option);
+	}
+
+	// 서버가 먼저 보내는 경우, 연결 완료와 함께 받은 수신 이벤트도 처리해야 한다.
+	// 첫번째 소켓의 OnConnect가 IO 쓰레드를 잡고 있는 동안 두번째 소켓이 연결되고 데이터를 받게 해서
+	// 두번째 소켓의 연결 이벤트에 수신 이벤트가 합쳐지도록 한다.
+	void TCP_ServerSendsFirst(const asd::IOEventOption& option)
+	{
+		static const char Greeting[] = "hello";
+		static const size_t ClientCount = 2;
+
+		struct TestIO : public asd::IOEvent
+		{
+			asd::AsyncSocket* m_first = nullptr;
+			asd::Semaphore m_recv;
+			std::atomic<size_t> m_connected{0};
+
+			virtual void OnConnect(asd::AsyncSocket* a_sock,
+								   asd::Socket::Error a_err) override
+			{
+				EXPECT_EQ(0, a_err);
+				++m_connected;
+				if (a_sock == m_first)
+					std::this_thread::sleep_for(std::chrono::milliseconds(300));
+			}
+
+			virtual void OnRecv(asd::AsyncSocket* a_sock,
+								asd::Buffer_ptr&& a_data) override
+			{
+				EXPECT_EQ(sizeof(Greeting), a_data->GetSize());
+				m_recv.Post();
+			}
+		};
+
+		asd::Socket listener;
+		asd::IpAddress addr;
+		ASSERT_EQ(0, listener.Bind(asd::IpAddress(Addr_Loopback(asd::AddressFamily::IPv4), 0)));
+		ASSERT_EQ(0, listener.GetSockName(addr));
+		ASSERT_EQ(0, listener.Listen());
+
+		TestIO io;
+		io.Start(1, option);
+
+		std::array<asd::AsyncSocketHandle, ClientCount> handles;
+		for (size_t i=0; i<ClientCount; ++i) {
+			auto sock = handles[i].Alloc();
+			if (i == 0)
+				io.m_first = sock.get();
+			ASSERT_TRUE(io.RegisterConnector(sock, addr));
+		}
+
+		std::array<asd::Socket, ClientCount> servers;
+		for (auto& server : servers) {
+			asd::IpAddress peer;
+			ASSERT_EQ(0, listener.Accept(server, peer));
+			auto r = server.Send(Greeting, sizeof(Greeting));
+			ASSERT_EQ(0, r.m_error);
+		}
+
+		for (size_t i=0; i<ClientCount; ++i)
+			EXPECT_TRUE(io.m_recv.Wait(5 * 1000));
+		EXPECT_EQ(ClientCount, io.m_connected);
+
+		for (auto& handle : handles) {
+			auto sock = handle.Free();
+			if (sock != nullptr)
+				sock->Close();
+		}
+	}
+
+	TEST(Socket, IPv4_TCP_ServerSendsFirst)
+	{
+		asd::IOEventOption option;
+		option.PollBatchSize = 1;
+		TCP_ServerSendsFirst(option);
+
+		option.EdgeTriggered = true;
+		TCP_ServerSendsFirst(option);
+	}
+
+	TEST(Socket, IPv4_TCP_NonBlocked_LazyRecvBuffer)
+	{
+		asd::IOEventOption option;
+		option.LazyRecvBuffer = true;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+
+		option.EdgeTriggered = true;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+
+		option.EdgeTriggered = false;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 4);
+	}
+
+	// 대량 수신에서는 수신 버퍼가 커지고, 이후 작은 수신이 이어지면 다시 줄어야 한다.
+	// LazyRecvBuffer 이면 수신할 데이터가 없는 동안 수신 버퍼를 잡고 있지 않아야 한다.
+	void TCP_AdaptiveRecvBuffer(const asd::IOEventOption& option)
+	{
+		static const size_t BulkBytes = 4 * 1024 * 1024;
+		static const size_t SmallCount = 64;
+
+		struct TestIO : public ListenerTestIO
+		{
+			std::atomic<size_t> m_recved{0};
+			std::atomic<size_t> m_maxCapacity{0};
+			std::atomic<size_t> m_lastCapacity{0};
+
+			virtual void OnRecv(asd::AsyncSocket* a_sock,
+								asd::Buffer_ptr&& a_data) override
+			{
+				const size_t cap = a_data->Capacity();
+				if (cap > m_maxCapacity)
+					m_maxCapacity = cap;
+				m_lastCapacity = cap;
+				m_recved += a_data->GetSize();
+			}
+		};
+
+		TestIO io;
+		ASSERT_TRUE(io.Listen(1, option));
+
+		asd::Socket client;
+		ASSERT_EQ(0, io.Connect(client));
+		auto server = io.WaitAccept();
+		ASSERT_NE(nullptr, server);
+		EXPECT_EQ((size_t)option.RecvBufferInit, server->GetRecvSize());
+		if (option.LazyRecvBuffer)
+			EXPECT_EQ(0, server->GetRecvBufferCapacity());
+
+		// 수신을 마친 IO 쓰레드가 수신 버퍼를 정리할 때까지 기다린 후 확인한다.
+		auto checkIdle = [&]()
+		{
+			for (int wait=0; wait<1000; ++wait) {
+				const size_t cap = server->GetRecvBufferCapacity();
+				if (option.LazyRecvBuffer ? cap == 0 : cap >= server->GetRecvSize())
+					break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			if (option.LazyRecvBuffer)
+				EXPECT_EQ(0, server->GetRecvBufferCapacity());
+			else
+				EXPECT_GE(server->GetRecvBufferCapacity(), server->GetRecvSize());
+		};
+
+		std::vector<uint8_t> chunk(64 * 1024, 0xab);
+		for (size_t sent=0; sent<BulkBytes;) {
+			auto s = client.Send(chunk.data(), std::min(chunk.size(), BulkBytes - sent));
+			ASSERT_EQ(0, s.m_error);
+			sent += s.m_bytes;
+		}
+		for (int wait=0; io.m_recved < BulkBytes && wait<5000; ++wait)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		ASSERT_EQ(BulkBytes, io.m_recved);
+		const size_t bulkMax = io.m_maxCapacity;
+		EXPECT_GT(bulkMax, (size_t)option.RecvBufferInit);
+		EXPECT_LE(bulkMax, asd::BufferSizeClass::RoundUp(option.RecvBufferMax));
+		EXPECT_GT(server->GetRecvSize(), (size_t)option.RecvBufferInit);
+		EXPECT_LE(server->GetRecvSize(), (size_t)option.RecvBufferMax);
+		checkIdle();
+
+		for (size_t i=0; i<SmallCount; ++i) {
+			auto s = client.Send(chunk.data(), 16);
+			ASSERT_EQ(0, s.m_error);
+			for (int wait=0; io.m_recved < BulkBytes + (i+1)*16 && wait<5000; ++wait)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		EXPECT_EQ(BulkBytes + SmallCount*16, io.m_recved);
+		EXPECT_LE(io.m_lastCapacity, asd::BufferSizeClass::RoundUp(option.RecvBufferMin) * 2);
+		EXPECT_EQ((size_t)option.RecvBufferMin, server->GetRecvSize());
+		checkIdle();
+
+		server.reset();
+		client.Close();
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+	}
+
+	TEST(Socket, IPv4_TCP_AdaptiveRecvBuffer)
+	{
+		asd::IOEventOption option;
+		TCP_AdaptiveRecvBuffer(option);
+
+		option.LazyRecvBuffer = true;
+		TCP_AdaptiveRecvBuffer(option);
+
+		option.EdgeTriggered = true;
+		TCP_AdaptiveRecvBuffer(option);
+	}
+
+	TEST(Socket, IPv4_TCP_AdaptiveRecvBuffer_IOUring)
+	{
+		if (SkipWithoutIOUring())
+			return;
+
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		TCP_AdaptiveRecvBuffer(option);
+
+		option.LazyRecvBuffer = true;
+		TCP_AdaptiveRecvBuffer(option);
+	}
+
+	TEST(Socket, IPv4_TCP_NonBlocked_DispatchPool)
+	{
+		asd::ThreadPoolOption poolOption;
+		poolOption.ThreadCount = 4;
+		asd::ThreadPool pool(poolOption);
+		pool.Start();
+
+		asd::IOEventOption option;
+		option.DispatchPool = &pool;
+		TCP_NonBlocked(asd::AddressFamily::IPv4, option, 8, 2);
+		pool.Stop();
+	}
+
+	TEST(Socket, IPv4_TCP_DispatchPool_Order)
+	{
+		// 느린 OnRecv를 쓰레드풀에서 처리해도 소켓별로 수신 순서가 유지되고,
+		// OnClose는 그 소켓의 모든 OnRecv가 끝난 뒤에 호출되어야 한다.
+		static const size_t ClientCount = 4;
+		static const size_t TotalBytes = 256 * 1024;
+
+		asd::ThreadPoolOption poolOption;
+		poolOption.ThreadCount = 4;
+		asd::ThreadPool pool(poolOption);
+		pool.Start();
+
+		struct TestIO : public ListenerTestIO
+		{
+			asd::Mutex m_lock;
+			std::unordered_map<asd::AsyncSocket*, std::vector<uint8_t>> m_recving;
+			std::vector<std::vector<uint8_t>> m_closed;
+
+			virtual void OnRecv(asd::AsyncSocket* a_sock,
+								asd::Buffer_ptr&& a_data) override
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+				auto lock = asd::GetLock(m_lock);
+				auto& recved = m_recving[a_sock];
+				recved.insert(recved.end(), a_data->GetBuffer(), a_data->GetBuffer() + a_data->GetSize());
+			}
+
+			virtual void OnClose(asd::AsyncSocket* a_sock,
+								 asd::Socket::Error a_err) override
+			{
+				auto lock = asd::GetLock(m_lock);
+				auto it = m_recving.find(a_sock);
+				if (it == m_recving.end())
+					return;	// listener
+				m_closed.emplace_back(std::move(it->second));
+				m_recving.erase(it);
+				lock.unlock();
+				m_close.Post();
+			}
+		};
+
+		TestIO io;
+		asd::IOEventOption option;
+		option.DispatchPool = &pool;
+		ASSERT_TRUE(io.Listen(2, option));
+
+		std::vector<uint8_t> data(TotalBytes);
+		for (size_t i=0; i<TotalBytes; ++i)
+			data[i] = (uint8_t)(i % 251);
+
+		std::vector<std::thread> clients;
+		for (size_t c=0; c<ClientCount; ++c) {
+			clients.emplace_back([&]()
+			{
+				asd::Socket client;
+				ASSERT_EQ(0, io.Connect(client));
+				for (size_t offset=0; offset<data.size();) {
+					const size_t len = std::min(data.size() - offset, asd::Random::Uniform<size_t>(1, 5000));
+					auto s = client.Send(data.data() + offset, len);
+					ASSERT_EQ(s.m_error, 0);
+					offset += s.m_bytes;
+				}
+				client.Close();
+			});
+		}
+		for (auto& t : clients)
+			t.join();
+
+		for (size_t c=0; c<ClientCount; ++c)
+			EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+		{
+			auto lock = asd::GetLock(io.m_lock);
+			ASSERT_EQ(ClientCount, io.m_closed.size());
+			for (auto& recved : io.m_closed)
+				EXPECT_TRUE(recved == data);
+		}
+		pool.Stop();
+	}
+
+	// 상대방이 읽지 않으면 높은 수위에서 송신이 막히고, 다시 읽기 시작하면 낮은 수위에서 풀려야 한다.
+	void TCP_SendWatermark(const asd::IOEventOption& option)
+	{
+		static const size_t ChunkSize = 16 * 1024;
+
+		struct TestIO : public ListenerTestIO
+		{
+			std::atomic<int> m_blocked{0};
+			std::atomic<int> m_drained{0};
+			std::atomic<size_t> m_drainedPending{0};
+			asd::Semaphore m_drain;
+
+			virtual void OnSendBlocked(asd::AsyncSocket* a_sock) override
+			{
+				++m_blocked;
+			}
+
+			virtual void OnSendDrained(asd::AsyncSocket* a_sock) override
+			{
+				m_drainedPending = a_sock->GetPendingSendBytes();
+				++m_drained;
+				m_drain.Post();
+			}
+		};
+
+		TestIO io;
+		ASSERT_TRUE(io.Listen(2, option));
+
+		// 커널 버퍼를 작게 고정하여, 읽지 않는 상대방 때문에 송신큐가 쌓이도록 한다.
+		asd::Socket client;
+		ASSERT_EQ(0, client.Init());
+		ASSERT_EQ(0, client.SetSockOpt_RecvBufSize(4 * 1024));
+		ASSERT_EQ(0, io.Connect(client));
+		auto server = io.WaitAccept();
+		ASSERT_NE(nullptr, server);
+		ASSERT_EQ(0, server->SetSockOpt_SendBufSize(4 * 1024));
+
+		auto send = [&]()
+		{
+			auto buf = asd::NewBuffer<ChunkSize>();
+			std::memset(buf->GetBuffer(), 0x5a, ChunkSize);
+			EXPECT_TRUE(buf->SetSize(ChunkSize));
+			return server->Send(std::move(buf));
+		};
+
+		// 클라이언트가 읽지 않는 동안 커널 버퍼가 차면 송신큐가 쌓이다가 막힌다.
+		size_t sent = 0;
+		for (int i=0; i<4096 && send(); ++i)
+			sent += ChunkSize;
+		ASSERT_EQ(1, io.m_blocked);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		EXPECT_GT(server->GetPendingSendBytes(), option.SendLowWatermark);
+		EXPECT_FALSE(send());
+		EXPECT_EQ(0, io.m_drained);
+
+		std::atomic<size_t> recved{0};
+		std::thread reader([&]()
+		{
+			std::vector<uint8_t> buf(64 * 1024);
+			for (;;) {
+				auto r = client.Recv(buf.data(), buf.size());
+				if (r.m_error != 0 || r.m_bytes <= 0)
+					return;
+				recved += r.m_bytes;
+			}
+		});
+
+		ASSERT_TRUE(io.m_drain.Wait(10 * 1000));
+		EXPECT_EQ(1, io.m_drained);
+		EXPECT_LE(io.m_drainedPending, option.SendLowWatermark);
+		EXPECT_TRUE(send());
+		sent += ChunkSize;
+
+		// 남은 데이터를 모두 보낸 뒤 닫는다. (Close는 송신큐를 버린다)
+		for (int wait=0; server->GetPendingSendBytes()>0 && wait<10000; ++wait)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		EXPECT_EQ(0, server->GetPendingSendBytes());
+		server->Close();
+		server.reset();
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+		reader.join();
+		EXPECT_EQ(sent, recved);
+	}
+
+	TEST(Socket, IPv4_TCP_SendWatermark)
+	{
+		asd::IOEventOption option;
+		option.SendHighWatermark = 256 * 1024;
+		option.SendLowWatermark = 64 * 1024;
+		TCP_SendWatermark(option);
+
+		option.EdgeTriggered = true;
+		TCP_SendWatermark(option);
+	}
+
+	TEST(Socket, IPv4_TCP_SendWatermark_IOUring)
+	{
+		if (SkipWithoutIOUring())
+			return;
+
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		option.SendHighWatermark = 256 * 1024;
+		option.SendLowWatermark = 64 * 1024;
+		TCP_SendWatermark(option);
+	}
+
+	// 송신큐가 쌓인 상태에서 크기가 섞인 버퍼들을 보내도 스트림이 그대로 도착해야 한다.
+	// (SendCoalesceSize로 작은 버퍼들을 모으거나, ZeroCopyThreshold 이상은 MSG_ZEROCOPY로 보낸다)
+	void TCP_SendPolicy(const asd::IOEventOption& option,
+						const std::vector<size_t>& sizes)
+	{
+		auto pattern = [](size_t a_offset)
+		{
+			return (uint8_t)((a_offset * 7) % 251);
+		};
+
+		ListenerTestIO io;
+		ASSERT_TRUE(io.Listen(2, option));
+
+		// 수신 버퍼를 작게 하여 송신큐가 쌓이도록 한다.
+		// MSG_ZEROCOPY 세그먼트는 loopback에서 truesize가 커서 수신 윈도우가 거의 닫히므로 기본값을 사용한다.
+		asd::Socket client;
+		ASSERT_EQ(0, client.Init());
+		if (option.ZeroCopyThreshold == 0)
+			ASSERT_EQ(0, client.SetSockOpt_RecvBufSize(4 * 1024));
+		ASSERT_EQ(0, io.Connect(client));
+		auto server = io.WaitAccept();
+		ASSERT_NE(nullptr, server);
+
+		// 클라이언트가 읽기 전에 모두 Send하여 송신큐에 쌓이게 한다.
+		size_t total = 0;
+		for (size_t size : sizes) {
+			auto buf = asd::NewBuffer(size);
+			for (size_t i=0; i<size; ++i)
+				buf->GetBuffer()[i] = pattern(total + i);
+			ASSERT_TRUE(buf->SetSize(size));
+			ASSERT_TRUE(server->Send(std::move(buf)));
+			total += size;
+		}
+
+		std::vector<uint8_t> buf(64 * 1024);
+		size_t recved = 0;
+		size_t mismatch = 0;
+		while (recved < total) {
+			auto r = client.Recv(buf.data(), buf.size());
+			ASSERT_EQ(0, r.m_error);
+			ASSERT_GT(r.m_bytes, 0);
+			for (int i=0; i<r.m_bytes; ++i) {
+				if (buf[i] != pattern(recved + i))
+					++mismatch;
+			}
+			recved += r.m_bytes;
+		}
+		EXPECT_EQ(total, recved);
+		EXPECT_EQ(0, mismatch);
+
+		// 송신 방식이 실제로 적용되었는지 확인 (IOCP는 모으지 않고, MSG_ZEROCOPY는 리눅스 epoll 전용)
+		const asd::SendStats stats = server->GetSendStats();
+#if !asd_Platform_Windows
+		bool coalescable = false;
+		for (size_t i=1; i<sizes.size(); ++i)
+			coalescable |= sizes[i-1] < option.SendCoalesceSize && sizes[i] < option.SendCoalesceSize;
+		if (coalescable)
+			EXPECT_GT(stats.CoalescedBuffers, 0);
+#endif
+#if asd_Platform_Linux
+		if (option.ZeroCopyThreshold > 0 && io.GetBackend() == asd::IOEventOption::Backend::Native) {
+			EXPECT_GT(stats.ZeroCopySends, 0);
+
+			// 완료통지는 EPOLLERR로 따로 오므로 모두 회수될 때까지 기다린다.
+			for (int wait=0; server->GetSendStats().ZeroCopyDone < stats.ZeroCopySends && wait<5000; ++wait)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			EXPECT_EQ(stats.ZeroCopySends, server->GetSendStats().ZeroCopyDone);
+		}
+#endif
+		server.reset();
+
+		client.Close();
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+	}
+
+	TEST(Socket, IPv4_TCP_SendCoalesce)
+	{
+		// 모을 수 있는 작은 버퍼 사이사이에 큰 버퍼를 섞는다.
+		std::vector<size_t> sizes;
+		for (size_t i=0; i<20000; ++i)
+			sizes.push_back(i%50 == 0 ? 4000 + i%1000 : 1 + i%300);
+
+		asd::IOEventOption option;
+		TCP_SendPolicy(option, sizes);
+
+		option.EdgeTriggered = true;
+		TCP_SendPolicy(option, sizes);
+
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		option.EdgeTriggered = false;
+		TCP_SendPolicy(option, sizes);
+	}
+
+	TEST(Socket, IPv4_TCP_SendZeroCopy)
+	{
+		// loopback은 커널이 복사로 대체하므로, 도중에 writev로 바뀌는 경로까지 확인한다.
+		std::vector<size_t> sizes;
+		for (size_t i=0; i<200; ++i)
+			sizes.push_back(i%4 == 0 ? 100 + i : 64*1024 + i*1000);
+
+		asd::IOEventOption option;
+		option.ZeroCopyThreshold = 64 * 1024;
+		TCP_SendPolicy(option, sizes);
+
+		option.EdgeTriggered = true;
+		TCP_SendPolicy(option, sizes);
+	}
+
+	void TCP_RingRecv(asd::AddressFamily af,
+					  const asd::IOEventOption& option = asd::IOEventOption())
+	{
+		// [uint16_t 길이][길이만큼의 데이터] 형태의 프레임을 링버퍼 위에서 복사 없이 파싱
+		static const size_t FrameCount = 1000;
+		static const size_t MaxFrameSize = 5000;
+
+		struct TestIO : public ListenerTestIO
+		{
+			asd::Semaphore m_finish;
+			std::atomic<size_t> m_frameCount;
+			std::atomic<size_t> m_invalid;
+			std::atomic<size_t> m_maxCapacity;
+
+			TestIO()
+			{
+				m_frameCount = 0;
+				m_invalid = 0;
+				m_maxCapacity = 0;
+			}
+
+			virtual void OnAccept(asd::AsyncSocket* a_listener,
+								  asd::AsyncSocket_ptr&& a_newSock) override
+			{
+				EXPECT_TRUE(a_newSock->SetRecvMode(asd::AsyncSocket::RecvMode::Ring, 64*1024));
+				EXPECT_EQ(asd::AsyncSocket::RecvMode::Ring, a_newSock->GetRecvMode());
+				ASSERT_TRUE(Register(a_newSock));
+				EXPECT_FALSE(a_newSock->SetRecvMode(asd::AsyncSocket::RecvMode::Chunk));
+			}
+
+			virtual void OnRecv(asd::AsyncSocket* a_sock,
+								asd::Buffer_ptr&& a_data) override
+			{
+				ADD_FAILURE();
+			}
+
+			virtual void OnRecvRing(asd::AsyncSocket* a_sock,
+									asd::RingBuffer& a_data) override
+			{
+				if (a_data.Capacity() > m_maxCapacity)
+					m_maxCapacity = a_data.Capacity();
+
+				for (;;) {
+					auto span = a_data.Peek();
+					uint16_t len;
+					if (span.Size < sizeof(len))
+						break;
+					std::memcpy(&len, span.Data, sizeof(len));
+					if (span.Size < sizeof(len) + len)
+						break;
+
+					const uint8_t* payload = span.Data + sizeof(len);
+					for (size_t i=0; i<len; ++i) {
+						if (payload[i] != (uint8_t)(len + i))
+							++m_invalid;
+					}
+					a_data.Consume(sizeof(len) + len);
+					if (++m_frameCount == FrameCount)
+						m_finish.Post();
+				}
+			}
+		};
+
+		TestIO io;
+		ASSERT_TRUE(io.Listen(asd::Get_HW_Concurrency(), option, af));
+
+		std::vector<uint8_t> data;
+		for (size_t f=0; f<FrameCount; ++f) {
+			const uint16_t len = (uint16_t)asd::Random::Uniform<size_t>(0, MaxFrameSize);
+			const uint8_t* p = (const uint8_t*)&len;
+			data.insert(data.end(), p, p + sizeof(len));
+			for (size_t i=0; i<len; ++i)
+				data.push_back((uint8_t)(len + i));
+		}
+
+		asd::Socket client;
+		ASSERT_EQ(0, io.Connect(client));
+		for (size_t offset=0; offset<data.size();) {
+			const size_t len = std::min(data.size() - offset, asd::Random::Uniform<size_t>(1, 3000));
+			auto s = client.Send(data.data() + offset, len);
+			ASSERT_EQ(s.m_error, 0);
+			offset += s.m_bytes;
+		}
+
+		EXPECT_TRUE(io.m_finish.Wait(10 * 1000));
+		EXPECT_EQ(FrameCount, io.m_frameCount);
+		EXPECT_EQ(0, io.m_invalid);
+		EXPECT_LE(io.m_maxCapacity, 64*1024);
+
+		// 수신측 소켓이 닫힐 때까지 기다린 후 io를 정리한다.
+		client.Close();
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+	}
+
+	TEST(Socket, IPv4_TCP_RingRecv)
+	{
+		TCP_RingRecv(asd::AddressFamily::IPv4);
+	}
+
+	TEST(Socket, IPv4_TCP_RingRecv_EdgeTriggered)
+	{
+		asd::IOEventOption option;
+		option.EdgeTriggered = true;
+		TCP_RingRecv(asd::AddressFamily::IPv4, option);
+		option.EdgeBudget = 1;
+		TCP_RingRecv(asd::AddressFamily::IPv4, option);
+	}
+
+	TEST(Socket, IPv4_TCP_RingRecv_IOUring)
+	{
+		if (SkipWithoutIOUring())
+			return;
+
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		TCP_RingRecv(asd::AddressFamily::IPv4, option);
+	}
+
+	void TCP_Framing(asd::AddressFamily af,
+					 const asd::FrameOption& a_option)
+	{
+		static const size_t FrameCount = 1000;
+
+		struct TestIO : public ListenerTestIO
+		{
+			asd::FrameOption m_option;
+			asd::Semaphore m_finish;
+			std::atomic<size_t> m_frameCount;
+			std::atomic<size_t> m_invalid;
+			std::atomic<int> m_closeError;
+
+			TestIO()
+			{
+				m_frameCount = 0;
+				m_invalid = 0;
+				m_closeError = 0;
+			}
+
+			virtual void OnAccept(asd::AsyncSocket* a_listener,
+								  asd::AsyncSocket_ptr&& a_newSock) override
+			{
+				EXPECT_TRUE(a_newSock->SetFraming(m_option));
+				EXPECT_EQ(asd::AsyncSocket::RecvMode::Frame, a_newSock->GetRecvMode());
+				ASSERT_TRUE(Register(a_newSock));
+			}
+
+			virtual void OnRecvRing(asd::AsyncSocket* a_sock,
+									asd::RingBuffer& a_data) override
+			{
+				ADD_FAILURE();
+			}
+
+			virtual void OnMessage(asd::AsyncSocket* a_sock,
+								   const asd::Span& a_frame) override
+			{
+				// 프레임 번호를 본문 길이로 사용
+				const size_t n = m_frameCount;
+				if (a_frame.Size != n)
+					++m_invalid;
+				for (size_t i=0; i<a_frame.Size; ++i) {
+					if (a_frame.Data[i] != (uint8_t)('a' + (n + i) % 26))
+						++m_invalid;
+				}
+				if (++m_frameCount == FrameCount)
+					m_finish.Post();
+			}
+
+			virtual void OnClose(asd::AsyncSocket* a_sock,
+								 asd::Socket::Error a_err) override
+			{
+				m_closeError = a_err;
+				m_close.Post();
+			}
+		};
+
+		TestIO io;
+		io.m_option = a_option;
+		ASSERT_TRUE(io.Listen(asd::Get_HW_Concurrency(), asd::IOEventOption(), af));
+
+		auto appendFrame = [&a_option](std::vector<uint8_t>& a_data, size_t a_len, size_t a_seed)
+		{
+			if (a_option.FrameType == asd::FrameOption::Type::LengthPrefix) {
+				for (size_t i=0; i<a_option.PrefixBytes; ++i) {
+					const size_t shift = a_option.PrefixEndian == asd::Endian::Little
+									   ? 8 * i
+									   : 8 * (a_option.PrefixBytes - 1 - i);
+					a_data.push_back((uint8_t)(a_len >> shift));
+				}
+			}
+			for (size_t i=0; i<a_len; ++i)
+				a_data.push_back((uint8_t)('a' + (a_seed + i) % 26));
+			if (a_option.FrameType == asd::FrameOption::Type::Delimiter)
+				a_data.insert(a_data.end(), a_option.Delimiter.begin(), a_option.Delimiter.end());
+		};
+
+		std::vector<uint8_t> data;
+		for (size_t f=0; f<FrameCount; ++f)
+			appendFrame(data, f, f);
+
+		// 최대 크기를 넘는 프레임
+		appendFrame(data, a_option.MaxFrameSize + 1, 0);
+
+		asd::Socket client;
+		ASSERT_EQ(0, io.Connect(client));
+		for (size_t offset=0; offset<data.size();) {
+			const size_t len = std::min(data.size() - offset, asd::Random::Uniform<size_t>(1, 3000));
+			auto s = client.Send(data.data() + offset, len);
+			if (s.m_error != 0)
+				break; // 서버가 먼저 닫은 경우
+			offset += s.m_bytes;
+		}
+
+		EXPECT_TRUE(io.m_finish.Wait(10 * 1000));
+		EXPECT_EQ(FrameCount, io.m_frameCount);
+		EXPECT_EQ(0, io.m_invalid);
+
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+#if asd_Platform_Windows
+		EXPECT_EQ(WSAEMSGSIZE, io.m_closeError);
+#else
+		EXPECT_EQ(EMSGSIZE, io.m_closeError);
+#endif
+
+		client.Close();
+	}
+
+	TEST(Socket, IPv4_TCP_Framing)
+	{
+		asd::FrameOption prefix;
+		prefix.PrefixBytes = 2;
+		prefix.PrefixEndian = asd::Endian::Big;
+		prefix.MaxFrameSize = 1000;
+		TCP_Framing(asd::AddressFamily::IPv4, prefix);
+
+		asd::FrameOption delim;
+		delim.FrameType = asd::FrameOption::Type::Delimiter;
+		delim.Delimiter = "\r\n";
+		delim.MaxFrameSize = 1000;
+		TCP_Framing(asd::AddressFamily::IPv4, delim);
+	}
+
+	void TCP_FileBuffer(const asd::IOEventOption& option)
+	{
+		// 테스트용 파일 생성
+		const char* path = "asd_test_filebuffer.tmp";
+		const size_t FileSize = 1024*1024 + 123;
+		std::vector<uint8_t> content(FileSize);
+		for (size_t i=0; i<FileSize; ++i)
+			content[i] = (uint8_t)asd::Random::Uniform(0, 255);
+		{
+			FILE* fp = std::fopen(path, "wb");
+			ASSERT_NE(fp, nullptr);
+			ASSERT_EQ(FileSize, std::fwrite(content.data(), 1, FileSize, fp));
+			std::fclose(fp);
+		}
+
+		// 매핑
+		const size_t SliceOffset = 5000, SliceSize = 70000;
+		{
+			auto buf = asd::FileBuffer::Open(path, SliceOffset, SliceSize);
+			ASSERT_NE(buf, nullptr);
+			EXPECT_NE(buf->GetFile(), nullptr);
+			EXPECT_EQ(buf->GetSize(), SliceSize);
+			EXPECT_FALSE(buf->SetSize(0));
+			ASSERT_NE(buf->GetBuffer(), nullptr);
+			EXPECT_EQ(0, std::memcmp(buf->GetBuffer(), &content[SliceOffset], SliceSize));
+			EXPECT_EQ(asd::FileBuffer::Open(path, FileSize), nullptr);
+		}
+
+		// [일반 버퍼][파일 전체][일반 버퍼][파일 일부] 순서로 송신
+		std::vector<uint8_t> expect;
+		const uint8_t header[] = { 1, 2, 3, 4 };
+		expect.insert(expect.end(), header, header + sizeof(header));
+		expect.insert(expect.end(), content.begin(), content.end());
+		expect.insert(expect.end(), header, header + sizeof(header));
+		expect.insert(expect.end(), &content[SliceOffset], &content[SliceOffset] + SliceSize);
+
+		struct TestIO : public ListenerTestIO
+		{
+			const char* m_path;
+			size_t m_sliceOffset;
+			size_t m_sliceSize;
+
+			virtual void OnAccept(asd::AsyncSocket* a_listener,
+								  asd::AsyncSocket_ptr&& a_newSock) override
+			{
+				ASSERT_TRUE(Register(a_newSock));
+
+				const uint8_t header[] = { 1, 2, 3, 4 };
+				asd::BufferList list;
+				list.Write(header, sizeof(header));
+				list.PushBack(asd::FileBuffer::Open(m_path));
+				list.Write(header, sizeof(header));
+				list.PushBack(asd::FileBuffer::Open(m_path, m_sliceOffset, m_sliceSize));
+				EXPECT_TRUE(a_newSock->Send(std::move(list)));
+			}
+		};
+
+		TestIO io;
+		io.m_path = path;
+		io.m_sliceOffset = SliceOffset;
+		io.m_sliceSize = SliceSize;
+		ASSERT_TRUE(io.Listen(asd::Get_HW_Concurrency(), option));
+
+		asd::Socket client;
+		ASSERT_EQ(0, io.Connect(client));
+		std::vector<uint8_t> recved(expect.size());
+		size_t offset = 0;
+		while (offset < recved.size()) {
+			auto r = client.Recv(recved.data() + offset, recved.size() - offset);
+			ASSERT_EQ(r.m_error, 0);
+			ASSERT_GT(r.m_bytes, 0);
+			offset += r.m_bytes;
+		}
+		EXPECT_EQ(0, std::memcmp(recved.data(), expect.data(), expect.size()));
+
+		client.Close();
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+		std::remove(path);
+	}
+
+	TEST(Socket, FileBuffer)
+	{
+		TCP_FileBuffer(asd::IOEventOption());
+	}
+
+	TEST(Socket, FileBuffer_EdgeTriggered)
+	{
+		asd::IOEventOption option;
+		option.EdgeTriggered = true;
+		TCP_FileBuffer(option);
+	}
+
+	TEST(Socket, FileBuffer_IOUring)
+	{
+		if (SkipWithoutIOUring())
+			return;
+
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		TCP_FileBuffer(option);
+	}
+
+	// 에코 서버와 a_totalBytes를 주고받는 동안의 처리량(MB/s)
+	double TCP_EchoThroughput(const asd::IOEventOption& option,
+							  size_t a_totalBytes,
+							  asd::IOEventOption::Backend& a_backend /*Out*/)
+	{
+		struct TestIO : public ListenerTestIO
+		{
+			virtual void OnRecv(asd::AsyncSocket* a_sock,
+								asd::Buffer_ptr&& a_data) override
+			{
+				EXPECT_TRUE(a_sock->Send(std::move(a_data)));
+			}
+		};
+
+		TestIO io;
+		EXPECT_TRUE(io.Listen(2, option));
+		a_backend = io.GetBackend();
+
+		asd::Socket client;
+		EXPECT_EQ(0, io.Connect(client));
+
+		const auto begin = std::chrono::steady_clock::now();
+		std::thread reader([&]()
+		{
+			std::vector<uint8_t> buf(64 * 1024);
+			size_t recved = 0;
+			while (recved < a_totalBytes) {
+				auto r = client.Recv(buf.data(), buf.size());
+				if (r.m_error != 0 || r.m_bytes <= 0) {
+					ADD_FAILURE() << "recv error : " << r.m_error;
+					return;
+				}
+				recved += r.m_bytes;
+			}
+		});
+
+		std::vector<uint8_t> chunk(16 * 1024, 0xab);
+		for (size_t sent=0; sent<a_totalBytes;) {
+			auto s = client.Send(chunk.data(), std::min(chunk.size(), a_totalBytes - sent));
+			if (s.m_error != 0) {
+				ADD_FAILURE() << "send error : " << s.m_error;
+				break;
+			}
+			sent += s.m_bytes;
+		}
+		reader.join();
+		const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		client.Close();
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+		return (a_totalBytes / (1024.0 * 1024.0)) / sec;
+	}
+
+	TEST(Socket, IOUring_Throughput)
+	{
+		const size_t TotalBytes = 16 * 1024 * 1024;
+		asd::IOEventOption::Backend backend;
+
+		asd::IOEventOption option;
+		const double native = TCP_EchoThroughput(option, TotalBytes, backend);
+		EXPECT_EQ(asd::IOEventOption::Backend::Native, backend);
+
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		const double uring = TCP_EchoThroughput(option, TotalBytes, backend);
+
+		asd::puts(asd::MString::Format("echo throughput, native : {} MB/s, {} : {} MB/s",
+									   native,
+									   backend == asd::IOEventOption::Backend::IOUring ? "io_uring" : "fallback",
+									   uring));
+	}
+
+	// IOCP는 아직 UDP 소켓 등록(IOEvent::RegisterUDP)을 지원하지 않는다. (WSARecvFrom/WSASendTo 미구현)
+#if !asd_Platform_Windows
+	void UDP_NonBlocked(asd::AddressFamily af,
+						const asd::IOEventOption& option)
+	{
+		static const size_t Rounds = 8;
+		static const size_t CountPerRound = 64;
+
+		// 서버 소켓은 받은 데이터그램을 그대로 돌려주고, 클라이언트 소켓은 돌려받은 데이터그램을 모은다.
+		struct TestIO : public asd::IOEvent
+		{
+			asd::AsyncSocket* m_server = nullptr;
+			asd::Mutex m_lock;
+			std::vector<std::vector<uint8_t>> m_echoed;
+			asd::Semaphore m_recv;
+			asd::Semaphore m_close;
+
+			virtual void OnRecvFrom(asd::AsyncSocket* a_sock,
+									const asd::IpAddress& a_src,
+									asd::Buffer_ptr&& a_data) override
+			{
+				if (a_sock == m_server) {
+					EXPECT_TRUE(a_sock->SendTo(std::move(a_data), a_src));
+					return;
+				}
+				auto lock = asd::GetLock(m_lock);
+				m_echoed.emplace_back(a_data->GetBuffer(), a_data->GetBuffer() + a_data->GetSize());
+				lock.unlock();
+				m_recv.Post();
+			}
+
+			virtual void OnClose(asd::AsyncSocket* a_sock,
+								 asd::Socket::Error a_err) override
+			{
+				m_close.Post();
+			}
+		};
+
+		TestIO io;
+		io.Start(2, option);
+
+		asd::AsyncSocketHandle serverHandle;
+		asd::AsyncSocketHandle clientHandle;
+		asd::IpAddress serverAddr;
+		{
+			auto server = serverHandle.Alloc();
+			io.m_server = server.get();
+			ASSERT_TRUE(io.RegisterUDP(server, asd::IpAddress(Addr_Loopback(af), 0)));
+			ASSERT_EQ(0, server->GetSockName(serverAddr));
+
+			auto client = clientHandle.Alloc();
+			ASSERT_TRUE(io.RegisterUDP(client, asd::IpAddress(Addr_Loopback(af), 0)));
+		}
+		auto client = clientHandle.GetObj();
+		ASSERT_NE(nullptr, client);
+
+		// 한 라운드씩 보내고 전부 돌아오기를 기다린다. (루프백이라도 한번에 많이 보내면 커널이 버릴 수 있음)
+		std::vector<std::vector<uint8_t>> sent;
+		for (size_t round=0; round<Rounds; ++round) {
+			for (size_t i=0; i<CountPerRound; ++i) {
+				const uint32_t seq = (uint32_t)sent.size();
+				std::vector<uint8_t> payload(asd::Random::Uniform<size_t>(sizeof(seq), 1000));
+				std::memcpy(payload.data(), &seq, sizeof(seq));
+				for (size_t k=sizeof(seq); k<payload.size(); ++k)
+					payload[k] = (uint8_t)(seq + k);
+
+				auto buf = asd::NewBuffer(payload.size());
+				std::memcpy(buf->GetBuffer(), payload.data(), payload.size());
+				ASSERT_TRUE(buf->SetSize(payload.size()));
+				ASSERT_TRUE(client->SendTo(std::move(buf), serverAddr));
+				sent.emplace_back(std::move(payload));
+			}
+			for (size_t i=0; i<CountPerRound; ++i)
+				ASSERT_TRUE(io.m_recv.Wait(10 * 1000));
+		}
+
+		// DatagramMaxSize보다 큰 데이터그램은 버려지고, 뒤따르는 데이터그램은 정상 수신되어야 한다.
+		{
+			auto big = asd::NewBuffer(option.DatagramMaxSize + 1);
+			std::memset(big->GetBuffer(), 0xff, option.DatagramMaxSize + 1);
+			ASSERT_TRUE(big->SetSize(option.DatagramMaxSize + 1));
+			ASSERT_TRUE(client->SendTo(std::move(big), serverAddr));
+
+			const uint32_t seq = (uint32_t)sent.size();
+			std::vector<uint8_t> payload(sizeof(seq));
+			std::memcpy(payload.data(), &seq, sizeof(seq));
+			auto buf = asd::NewBuffer(payload.size());
+			std::memcpy(buf->GetBuffer(), payload.data(), payload.size());
+			ASSERT_TRUE(buf->SetSize(payload.size()));
+			ASSERT_TRUE(client->SendTo(std::move(buf), serverAddr));
+			sent.emplace_back(std::move(payload));
+			ASSERT_TRUE(io.m_recv.Wait(10 * 1000));
+		}
+
+		{
+			auto lock = asd::GetLock(io.m_lock);
+			ASSERT_EQ(sent.size(), io.m_echoed.size());
+			std::vector<bool> seen(sent.size(), false);
+			for (auto& echoed : io.m_echoed) {
+				ASSERT_GE(echoed.size(), sizeof(uint32_t));
+				uint32_t seq;
+				std::memcpy(&seq, echoed.data(), sizeof(seq));
+				ASSERT_LT(seq, sent.size());
+				EXPECT_FALSE(seen[seq]);
+				seen[seq] = true;
+				EXPECT_TRUE(echoed == sent[seq]);
+			}
+		}
+
+		client.reset();
+		for (auto handle : {&serverHandle, &clientHandle}) {
+			auto sock = handle->Free();
+			if (sock != nullptr)
+				sock->Close();
+		}
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+	}
+
+	TEST(Socket, IPv4_UDP_NonBlocked)
+	{
+		asd::IOEventOption option;
+		UDP_NonBlocked(asd::AddressFamily::IPv4, option);
+
+		// 배치 크기와 관계없이 동작해야 한다.
+		option.DatagramBatchSize = 1;
+		UDP_NonBlocked(asd::AddressFamily::IPv4, option);
+	}
+
+	TEST(Socket, IPv6_UDP_NonBlocked)
+	{
+		asd::IOEventOption option;
+		UDP_NonBlocked(asd::AddressFamily::IPv6, option);
+	}
+
+	TEST(Socket, IPv4_UDP_NonBlocked_EdgeTriggered)
+	{
+		asd::IOEventOption option;
+		option.EdgeTriggered = true;
+		option.EdgeBudget = 1;
+		UDP_NonBlocked(asd::AddressFamily::IPv4, option);
+	}
+
+	TEST(Socket, IPv4_UDP_NonBlocked_IOUring)
+	{
+		if (SkipWithoutIOUring())
+			return;
+
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		UDP_NonBlocked(asd::AddressFamily::IPv4, option);
+
+		option.LazyRecvBuffer = true;
+		UDP_NonBlocked(asd::AddressFamily::IPv4, option);
+	}
+
+	TEST(Socket, IPv4_UDP_NonBlocked_DispatchPool)
+	{
+		asd::ThreadPoolOption poolOption;
+		poolOption.ThreadCount = 2;
+		asd::ThreadPool pool(poolOption);
+		pool.Start();
+
+		asd::IOEventOption option;
+		option.DispatchPool = &pool;
+		UDP_NonBlocked(asd::AddressFamily::IPv4, option);
+		pool.Stop();
+	}
+
+	// 닫힌 포트로 보내지 못한 데이터그램은 소켓을 닫지 않고 버리며,
+	// 그 에러는 이후의 성공한 송신으로 지워지지 않아야 한다.
+	void UDP_SendError(const asd::IOEventOption& option)
+	{
+		const asd::AddressFamily af = asd::AddressFamily::IPv4;
+
+		struct TestIO : public asd::IOEvent
+		{
+			asd::Semaphore m_recv;
+			asd::Semaphore m_close;
+
+			virtual void OnRecvFrom(asd::AsyncSocket* a_sock,
+									const asd::IpAddress& a_src,
+									asd::Buffer_ptr&& a_data) override
+			{
+				m_recv.Post();
+			}
+
+			virtual void OnClose(asd::AsyncSocket* a_sock,
+								 asd::Socket::Error a_err) override
+			{
+				m_close.Post();
+			}
+		};
+
+		// 바인드했다가 닫아서 아무도 받지 않는 포트
+		asd::IpAddress closedAddr;
+		{
+			asd::Socket closed(asd::Socket::Type::UDP);
+			ASSERT_EQ(0, closed.Bind(asd::IpAddress(Addr_Loopback(af), 0)));
+			ASSERT_EQ(0, closed.GetSockName(closedAddr));
+		}
+
+		TestIO io;
+		io.Start(2, option);
+
+		asd::AsyncSocketHandle senderHandle;
+		asd::AsyncSocketHandle receiverHandle;
+		asd::IpAddress receiverAddr;
+		{
+			auto receiver = receiverHandle.Alloc();
+			ASSERT_TRUE(io.RegisterUDP(receiver, asd::IpAddress(Addr_Loopback(af), 0)));
+			ASSERT_EQ(0, receiver->GetSockName(receiverAddr));
+
+			auto sender = senderHandle.Alloc();
+			ASSERT_TRUE(io.RegisterUDP(sender, asd::IpAddress(Addr_Loopback(af), 0)));
+		}
+		auto sender = senderHandle.GetObj();
+		ASSERT_NE(nullptr, sender);
+		EXPECT_EQ(0, sender->GetLastError());
+
+		auto newDatagram = [](size_t a_size)
+		{
+			auto buf = asd::NewBuffer(a_size);
+			std::memset(buf->GetBuffer(), 0x5a, a_size);
+			EXPECT_TRUE(buf->SetSize(a_size));
+			return buf;
+		};
+
+		// UDP 최대 크기를 넘는 데이터그램은 보낼 수 없다. (EMSGSIZE)
+		// 뒤따르는 데이터그램들은 성공하며, 마지막 것이 도착하면 앞의 송신도 모두 처리된 것이다.
+		ASSERT_TRUE(sender->SendTo(newDatagram(UDP_Payload_Limit(af) + 1), closedAddr));
+		ASSERT_TRUE(sender->SendTo(newDatagram(16), closedAddr));
+		ASSERT_TRUE(sender->SendTo(newDatagram(16), receiverAddr));
+		ASSERT_TRUE(io.m_recv.Wait(10 * 1000));
+		EXPECT_EQ(EMSGSIZE, sender->GetLastError());
+		EXPECT_EQ(0, sender->GetPendingSendBytes());
+
+		sender.reset();
+		for (auto handle : {&senderHandle, &receiverHandle}) {
+			auto sock = handle->Free();
+			if (sock != nullptr)
+				sock->Close();
+		}
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+		EXPECT_TRUE(io.m_close.Wait(10 * 1000));
+	}
+
+	TEST(Socket, IPv4_UDP_SendError)
+	{
+		asd::IOEventOption option;
+		UDP_SendError(option);
+
+		option.EdgeTriggered = true;
+		UDP_SendError(option);
+	}
+
+	TEST(Socket, IPv4_UDP_SendError_IOUring)
 	{
+		if (SkipWithoutIOUring())
+			return;
 
+		asd::IOEventOption option;
+		option.BackendType = asd::IOEventOption::Backend::IOUring;
+		UDP_SendError(option);
 	}
+#endif
 }